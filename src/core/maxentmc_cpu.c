@@ -0,0 +1,207 @@
+/** This file is part of MaxEntMC, a maximum entropy algorithm with moment constraints. **/
+/** Copyright (C) 2014 Rafail V. Abramov.                                               **/
+/**                                                                                     **/
+/** This program is free software: you can redistribute it and/or modify it under the   **/
+/** terms of the GNU General Public License as published by the Free Software           **/
+/** Foundation, either version 3 of the License, or (at your option) any later version. **/
+/**                                                                                     **/
+/** This program is distributed in the hope that it will be useful, but WITHOUT ANY     **/
+/** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     **/
+/** PARTICULAR PURPOSE.  See the GNU General Public License for more details.           **/
+/**                                                                                     **/
+/** You should have received a copy of the GNU General Public License along with this   **/
+/** program.  If not, see <http://www.gnu.org/licenses/>.                               **/
+
+#ifdef __linux__
+#define _GNU_SOURCE /** sched_getaffinity **/
+#include <sched.h>
+#endif
+
+#include <stdio.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "maxentmc_defs.h"
+#include "maxentmc_cpu.h"
+
+#define MAXENTMC_CPU_DEFAULT_CACHE_LINE_SIZE 64
+
+#define MAXENTMC_CPU_DEFAULT_L2_CACHE_SIZE (256*1024)
+
+#define MAXENTMC_CPU_MAX_NODES 64
+
+static pthread_once_t maxentmc_cpu_once = PTHREAD_ONCE_INIT;
+
+static enum MAXENTMC_CPU_ISA maxentmc_cpu_isa_value = MAXENTMC_CPU_SCALAR;
+
+static size_t maxentmc_cpu_cache_line_size_value = MAXENTMC_CPU_DEFAULT_CACHE_LINE_SIZE;
+
+static size_t maxentmc_cpu_l2_cache_size_value = MAXENTMC_CPU_DEFAULT_L2_CACHE_SIZE;
+
+static void maxentmc_cpu_init(void)
+{
+
+    /** Instruction set. The vector kernels are only built in double precision. **/
+
+#ifndef MAXENTMC_SINGLE_PRECISION
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx512f"))
+        maxentmc_cpu_isa_value = MAXENTMC_CPU_AVX512;
+    else if(__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        maxentmc_cpu_isa_value = MAXENTMC_CPU_AVX2;
+    else if(__builtin_cpu_supports("sse2"))
+        maxentmc_cpu_isa_value = MAXENTMC_CPU_SSE2;
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+    maxentmc_cpu_isa_value = MAXENTMC_CPU_NEON;
+#endif
+#endif
+
+    /** Cache line size: sysconf where the C library knows it, sysfs otherwise **/
+
+    long line = -1;
+
+#ifdef _SC_LEVEL1_DCACHE_LINESIZE
+    line = sysconf(_SC_LEVEL1_DCACHE_LINESIZE);
+#endif
+
+    if(line <= 0){
+        FILE * f = fopen("/sys/devices/system/cpu/cpu0/cache/index0/coherency_line_size","r");
+        if(f){
+            if(fscanf(f,"%ld",&line) != 1)
+                line = -1;
+            fclose(f);
+        }
+    }
+
+    /** posix_memalign requires a power of two, and vector rows in the thread scratch
+        are aligned to cache lines **/
+
+    if(line > 0 && (line & (line-1)) == 0)
+        maxentmc_cpu_cache_line_size_value = (size_t)line;
+
+    if(maxentmc_cpu_cache_line_size_value < MAXENTMC_FLOAT_ALIGNMENT)
+        maxentmc_cpu_cache_line_size_value = MAXENTMC_FLOAT_ALIGNMENT;
+
+    /** L2 cache size, the same way (sysfs gives it in kilobytes, as in "1024K") **/
+
+    long l2 = -1;
+
+#ifdef _SC_LEVEL2_CACHE_SIZE
+    l2 = sysconf(_SC_LEVEL2_CACHE_SIZE);
+#endif
+
+    if(l2 <= 0){
+        FILE * f = fopen("/sys/devices/system/cpu/cpu0/cache/index2/size","r");
+        if(f){
+            if(fscanf(f,"%ld",&l2) == 1)
+                l2 *= 1024;
+            else
+                l2 = -1;
+            fclose(f);
+        }
+    }
+
+    if(l2 > 0)
+        maxentmc_cpu_l2_cache_size_value = (size_t)l2;
+
+}
+
+enum MAXENTMC_CPU_ISA maxentmc_cpu_isa(void)
+{
+    pthread_once(&maxentmc_cpu_once,maxentmc_cpu_init);
+    return maxentmc_cpu_isa_value;
+}
+
+size_t maxentmc_cpu_cache_line_size(void)
+{
+    pthread_once(&maxentmc_cpu_once,maxentmc_cpu_init);
+    return maxentmc_cpu_cache_line_size_value;
+}
+
+size_t maxentmc_cpu_l2_cache_size(void)
+{
+    pthread_once(&maxentmc_cpu_once,maxentmc_cpu_init);
+    return maxentmc_cpu_l2_cache_size_value;
+}
+
+#ifdef __linux__
+
+/** Reads a sysfs cpu list such as "0-3,8-11" and marks its processors in set **/
+
+static void maxentmc_cpu_read_list(char const * const name, cpu_set_t * const set)
+{
+    CPU_ZERO(set);
+
+    FILE * f = fopen(name,"r");
+    if(f == NULL)
+        return;
+
+    int begin, end;
+    char sep;
+
+    while(fscanf(f,"%d",&begin) == 1){
+        end = begin;
+        sep = (char)fgetc(f);
+        if(sep == '-'){
+            if(fscanf(f,"%d",&end) != 1)
+                break;
+            sep = (char)fgetc(f);
+        }
+        for(;(begin<=end) && (begin<CPU_SETSIZE);++begin)
+            CPU_SET(begin,set);
+        if(sep != ',')
+            break;
+    }
+
+    fclose(f);
+}
+
+#endif
+
+size_t maxentmc_cpu_topology(size_t const max, int * const cpus, int * const nodes)
+{
+    size_t n = 0;
+
+#ifdef __linux__
+
+    cpu_set_t allowed, node_set, seen;
+
+    if(sched_getaffinity(0,sizeof(cpu_set_t),&allowed))
+        return 0;
+
+    CPU_ZERO(&seen);
+
+    int node, cpu;
+
+    for(node=0;node<MAXENTMC_CPU_MAX_NODES;++node){
+        char name[64];
+        sprintf(name,"/sys/devices/system/node/node%d/cpulist",node);
+        maxentmc_cpu_read_list(name,&node_set);
+        for(cpu=0;cpu<CPU_SETSIZE;++cpu)
+            if(CPU_ISSET(cpu,&node_set) && CPU_ISSET(cpu,&allowed) && !CPU_ISSET(cpu,&seen)){
+                CPU_SET(cpu,&seen);
+                if(n<max){
+                    cpus[n] = cpu;
+                    nodes[n] = node;
+                }
+                ++n;
+            }
+    }
+
+    /** Without NUMA information in sysfs, every processor is on node 0 **/
+
+    if(n == 0)
+        for(cpu=0;cpu<CPU_SETSIZE;++cpu)
+            if(CPU_ISSET(cpu,&allowed)){
+                if(n<max){
+                    cpus[n] = cpu;
+                    nodes[n] = 0;
+                }
+                ++n;
+            }
+
+#endif
+
+    return (n<max)?n:max;
+}
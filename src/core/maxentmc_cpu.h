@@ -0,0 +1,42 @@
+/** This file is part of MaxEntMC, a maximum entropy algorithm with moment constraints. **/
+/** Copyright (C) 2014 Rafail V. Abramov.                                               **/
+/**                                                                                     **/
+/** This program is free software: you can redistribute it and/or modify it under the   **/
+/** terms of the GNU General Public License as published by the Free Software           **/
+/** Foundation, either version 3 of the License, or (at your option) any later version. **/
+/**                                                                                     **/
+/** This program is distributed in the hope that it will be useful, but WITHOUT ANY     **/
+/** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     **/
+/** PARTICULAR PURPOSE.  See the GNU General Public License for more details.           **/
+/**                                                                                     **/
+/** You should have received a copy of the GNU General Public License along with this   **/
+/** program.  If not, see <http://www.gnu.org/licenses/>.                               **/
+
+#ifndef MAXENTMC_CPU_H_INCLUDED
+#define MAXENTMC_CPU_H_INCLUDED
+
+#include <stddef.h>
+
+/** Instruction sets for which the quadrature kernels are compiled, see maxentmc_simd.h **/
+
+enum MAXENTMC_CPU_ISA {MAXENTMC_CPU_SCALAR, MAXENTMC_CPU_SSE2, MAXENTMC_CPU_AVX2, MAXENTMC_CPU_AVX512, MAXENTMC_CPU_NEON};
+
+/** The widest instruction set supported both by the library build and by the processor it runs on **/
+
+enum MAXENTMC_CPU_ISA maxentmc_cpu_isa(void);
+
+/** Size of the L1 data cache line in bytes, read from the system once, never less than MAXENTMC_FLOAT_ALIGNMENT **/
+
+size_t maxentmc_cpu_cache_line_size(void);
+
+/** Size of the L2 cache in bytes (256K when it cannot be read), used to size the quadrature point tiles **/
+
+size_t maxentmc_cpu_l2_cache_size(void);
+
+/** Processors the process may run on, with their NUMA nodes (node 0 when the system has no NUMA information), ordered by
+    node and then by processor number. Fills up to max entries of cpus and nodes and returns the number of processors
+    (0 on systems where processors cannot be enumerated). **/
+
+size_t maxentmc_cpu_topology(size_t max, int * cpus, int * nodes);
+
+#endif // MAXENTMC_CPU_H_INCLUDED
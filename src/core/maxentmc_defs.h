@@ -18,15 +18,19 @@
 #include <stdlib.h>
 #include <errno.h>
 
-#ifndef MAXENTMC_CACHE_LINE_SIZE
-#warning MAXENTMC_CACHE_LINE_SIZE not defined, assuming 64 bytes
-#define MAXENTMC_CACHE_LINE_SIZE 64
-#endif
+/** Alignment of vector data: the widest register any of the dispatched kernels may use (AVX-512) **/
+
+#define MAXENTMC_FLOAT_ALIGNMENT 64
 
-#ifdef __AVX__
-#define MAXENTMC_FLOAT_ALIGNMENT 32
+/** The cache line size is read from the system at run time, unless fixed at compile time **/
+
+#ifdef MAXENTMC_CACHE_LINE_SIZE
+#if MAXENTMC_CACHE_LINE_SIZE < MAXENTMC_FLOAT_ALIGNMENT
+#error MAXENTMC_CACHE_LINE_SIZE is smaller than MAXENTMC_FLOAT_ALIGNMENT
+#endif
 #else
-#define MAXENTMC_FLOAT_ALIGNMENT 16
+size_t maxentmc_cpu_cache_line_size(void);
+#define MAXENTMC_CACHE_LINE_SIZE maxentmc_cpu_cache_line_size()
 #endif
 
 #define MAXENTMC_ALIGNED_SIZE(boundary,size)  ((size)+((boundary)-((size)%(boundary)))%(boundary))
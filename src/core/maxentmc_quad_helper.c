@@ -17,6 +17,8 @@
 #include <math.h>
 
 #include "maxentmc_symmeig.h"
+#include "maxentmc_simd.h"
+#include "maxentmc_cpu.h"
 #include "maxentmc_quad_helper.h"
 
 #define QUAD_MAX(a,b)  ((a)>(b))?(a):(b)
@@ -24,8 +26,13 @@
 #define MAXENTMC_QUAD_HELPER_HEADER_SIZE MAXENTMC_ALIGNED_SIZE(sizeof(maxentmc_float_t),sizeof(struct maxentmc_quad_helper_struct))
 #define MAXENTMC_QUAD_HELPER_SIZE(_s_) MAXENTMC_ALIGNED_SIZE(MAXENTMC_FLOAT_ALIGNMENT,MAXENTMC_QUAD_HELPER_HEADER_SIZE+sizeof(maxentmc_float_t)*(_s_)*((_s_)+1))
 #define MAXENTMC_QUAD_THREAD_HEADER_SIZE MAXENTMC_ALIGNED_SIZE(MAXENTMC_CACHE_LINE_SIZE,sizeof(struct maxentmc_quad_helper_thread_struct))
-#define MAXENTMC_QUAD_THREAD_MOMENT_SIZE(_s_) MAXENTMC_ALIGNED_SIZE(MAXENTMC_CACHE_LINE_SIZE,MAXENTMC_QUAD_THREAD_HEADER_SIZE+sizeof(maxentmc_float_t)*(_s_))
-#define MAXENTMC_QUAD_THREAD_FULL_SIZE(_s_) MAXENTMC_ALIGNED_SIZE(MAXENTMC_CACHE_LINE_SIZE,MAXENTMC_QUAD_THREAD_MOMENT_SIZE(_s_)+sizeof(maxentmc_float_t)*(_s_)*MAXENTMC_QUAD_THREAD_HOWMANY_AT_ONCE)
+#define MAXENTMC_QUAD_THREAD_ROWS_SIZE(_s_) MAXENTMC_ALIGNED_SIZE(MAXENTMC_CACHE_LINE_SIZE,sizeof(maxentmc_float_t)*(_s_)*MAXENTMC_QUAD_THREAD_HOWMANY_AT_ONCE)
+#define MAXENTMC_QUAD_THREAD_TILE_SIZE(_s_,_t_) MAXENTMC_ALIGNED_SIZE(MAXENTMC_CACHE_LINE_SIZE,sizeof(maxentmc_float_t)*(_s_)*(_t_))
+#define MAXENTMC_QUAD_THREAD_FULL_SIZE(_s_,_m_,_d_,_t_) (MAXENTMC_QUAD_THREAD_HEADER_SIZE+MAXENTMC_QUAD_THREAD_ROWS_SIZE(_s_)+MAXENTMC_QUAD_THREAD_TILE_SIZE(_m_,_t_)+MAXENTMC_QUAD_THREAD_TILE_SIZE(_d_,_t_)+2*MAXENTMC_QUAD_THREAD_TILE_SIZE(1,_t_))
+
+static maxentmc_quad_helper_kernel_t maxentmc_quad_helper_select_kernel(void);
+
+static maxentmc_quad_helper_load_t maxentmc_quad_helper_select_load(struct maxentmc_quad_helper_struct const * const q);
 
 struct maxentmc_quad_helper_struct * maxentmc_quad_helper_alloc(maxentmc_index_t const dim)
 {
@@ -45,26 +52,75 @@ struct maxentmc_quad_helper_struct * maxentmc_quad_helper_alloc(maxentmc_index_t
 
     q->dimension = dim;
 
-    q->max_power = 0;
-
     q->armed = 0;
 
     q->n_mult = 0;
 
     q->n_mom = 0;
 
+    q->n_sets = 0;
+
+    q->collected = 0;
+
+    q->pass = 0;
+
+    q->live = 0;
+
     q->shift = MAXENTMC_INCREMENT_POINTER(q,MAXENTMC_QUAD_HELPER_HEADER_SIZE);
 
     q->rotate = q->shift + dim;
 
     q->multipliers = NULL;
 
-    q->moments = NULL;
+    memset(q->moments,0,sizeof(q->moments));
+
+    q->plan = NULL;
+
+    q->plan_list = NULL;
 
     q->moment_list = NULL;
 
     q->multiplier_list = NULL;
 
+    q->exp_mode = MAXENTMC_QUAD_HELPER_EXP_FULL;
+
+    q->kernel = maxentmc_quad_helper_select_kernel();
+
+    q->load = NULL;
+
+    q->pool = NULL;
+
+    q->spare = NULL;
+
+    q->reduce_size = 0;
+
+    q->reduce_capacity = 0;
+
+    q->reduce_thread = NULL;
+
+    q->reduce_partial = NULL;
+
+    q->reduce_node = NULL;
+
+    q->reduction_mode = MAXENTMC_QUAD_HELPER_REDUCTION_FAST;
+
+    q->reduce_blocks = 0;
+
+    q->reduce_blocks_capacity = 0;
+
+    q->reduce_block_sums = NULL;
+
+    q->rank = 0;
+
+    q->num_ranks = 1;
+
+    q->ranks_reduced = 0;
+
+#ifdef MAXENTMC_MPI
+    /** Every rank computes the whole quadrature until a communicator is set **/
+    q->comm = MPI_COMM_NULL;
+#endif
+
     maxentmc_quad_helper_set_shift_rotation(q,NULL);
 
     pthread_mutex_init(&q->lock,NULL);
@@ -93,12 +149,127 @@ void maxentmc_quad_helper_free(struct maxentmc_quad_helper_struct * const q)
                 temp = temp2->next;
                 free(temp2);
             }
+            struct maxentmc_quad_helper_plan_list_struct * temp_plan = q->plan_list;
+            while(temp_plan){
+                maxentmc_quad_plan_free(temp_plan->plan);
+                free(temp_plan->acc_index);
+                struct maxentmc_quad_helper_plan_list_struct * temp2 = temp_plan;
+                temp_plan = temp2->next;
+                free(temp2);
+            }
+            while(q->spare){
+                struct maxentmc_quad_helper_thread_struct * const qt = q->spare;
+                q->spare = qt->next;
+                free(qt);
+            }
+            free(q->reduce_thread);
+            free(q->reduce_block_sums);
             pthread_mutex_destroy(&q->lock);
             free(q);
         }
     }
 }
 
+int maxentmc_quad_helper_set_exp_mode(struct maxentmc_quad_helper_struct * const q, enum MAXENTMC_QUAD_HELPER_EXP_MODE const mode)
+{
+    MAXENTMC_CHECK_NULL(q);
+    if(q->armed){
+        MAXENTMC_MESSAGE(stderr,"error: quadrature helper is armed");
+        return -1;
+    }
+
+    switch(mode){
+        case MAXENTMC_QUAD_HELPER_EXP_FULL:
+        case MAXENTMC_QUAD_HELPER_EXP_ACCURATE:
+        case MAXENTMC_QUAD_HELPER_EXP_FAST:
+            q->exp_mode = mode;
+            return 0;
+        default:
+            MAXENTMC_MESSAGE(stderr,"error: unknown exponential mode");
+            return -1;
+    }
+}
+
+int maxentmc_quad_helper_set_reduction_mode(struct maxentmc_quad_helper_struct * const q, enum MAXENTMC_QUAD_HELPER_REDUCTION_MODE const mode)
+{
+    MAXENTMC_CHECK_NULL(q);
+    if(q->armed){
+        MAXENTMC_MESSAGE(stderr,"error: quadrature helper is armed");
+        return -1;
+    }
+
+    switch(mode){
+        case MAXENTMC_QUAD_HELPER_REDUCTION_FAST:
+        case MAXENTMC_QUAD_HELPER_REDUCTION_DETERMINISTIC:
+        case MAXENTMC_QUAD_HELPER_REDUCTION_COMPENSATED:
+            q->reduction_mode = mode;
+            return 0;
+        default:
+            MAXENTMC_MESSAGE(stderr,"error: unknown reduction mode");
+            return -1;
+    }
+}
+
+enum MAXENTMC_QUAD_HELPER_REDUCTION_MODE maxentmc_quad_helper_get_reduction_mode(struct maxentmc_quad_helper_struct const * const q)
+{
+    if(q == NULL){
+        MAXENTMC_MESSAGE(stderr,"error: NULL pointer provided");
+        return MAXENTMC_QUAD_HELPER_REDUCTION_FAST;
+    }
+    return q->reduction_mode;
+}
+
+#ifdef MAXENTMC_MPI
+int maxentmc_quad_helper_set_communicator(struct maxentmc_quad_helper_struct * const q, MPI_Comm const comm)
+{
+    MAXENTMC_CHECK_NULL(q);
+    if(q->armed){
+        MAXENTMC_MESSAGE(stderr,"error: quadrature helper is armed");
+        return -1;
+    }
+
+    q->comm = comm;
+    q->rank = 0;
+    q->num_ranks = 1;
+
+    if(comm != MPI_COMM_NULL){
+        MPI_Comm_rank(comm,&q->rank);
+        MPI_Comm_size(comm,&q->num_ranks);
+    }
+
+    return 0;
+}
+#endif
+
+int maxentmc_quad_helper_get_rank(struct maxentmc_quad_helper_struct const * const q, int * const rank, int * const num_ranks)
+{
+    MAXENTMC_CHECK_NULL(q);
+    if(rank)
+        *rank = q->rank;
+    if(num_ranks)
+        *num_ranks = q->num_ranks;
+    return 0;
+}
+
+int maxentmc_quad_helper_set_thread_pool(struct maxentmc_quad_helper_struct * const q, struct maxentmc_thread_pool_struct * const pool)
+{
+    MAXENTMC_CHECK_NULL(q);
+    if(q->armed){
+        MAXENTMC_MESSAGE(stderr,"error: quadrature helper is armed");
+        return -1;
+    }
+
+    q->pool = pool;
+
+    return 0;
+}
+
+struct maxentmc_thread_pool_struct * maxentmc_quad_helper_get_thread_pool(struct maxentmc_quad_helper_struct const * const q)
+{
+    MAXENTMC_CHECK_NULL_PT(q);
+    return q->pool;
+}
+
 maxentmc_index_t maxentmc_quad_helper_get_dimension(struct maxentmc_quad_helper_struct const * const q)
 {
     if(q)
@@ -246,13 +417,16 @@ int maxentmc_quad_helper_set_shift_rotation(struct maxentmc_quad_helper_struct *
                 return -1;
             }
 
+        /** The eigenvectors are the columns, each is scaled by the square root of its eigenvalue, so that the rotation
+            times its transpose is the covariance **/
+
         q->scale = 1.0;
         for(i=0;i<dim;++i){
             maxentmc_float_t const e_temp = sqrt(mean[i]);
             q->scale *= e_temp;
             size_t j;
             for(j=0;j<dim;++j)
-                q->rotate[i*dim+j] = cov[i*dim+j]*e_temp;
+                q->rotate[j*dim+i] = cov[j*dim+i]*e_temp;
         }
         q->shift_rotate = 1;
 
@@ -319,6 +493,116 @@ static struct maxentmc_power_vector_struct * maxentmc_quad_helper_find_power_vec
     return NULL;
 }
 
+/** Finds the monomial plan for the multiplier powers and the armed moment powers, building it on first use. The moment
+    monomials which are also multiplier monomials (all of them, in the Hessian pass) are mapped to the same positions of
+    the plan, and the moments of different sets with the same powers share one accumulator. **/
+
+static struct maxentmc_quad_helper_plan_list_struct * maxentmc_quad_helper_find_plan(struct maxentmc_quad_helper_struct * const q,
+                                                                                   struct maxentmc_power_struct const * const multiplier_powers,
+                                                                                   maxentmc_index_t const num_sets,
+                                                                                   struct maxentmc_power_struct const * const * const moment_powers)
+{
+    struct maxentmc_quad_helper_plan_list_struct * temp = q->plan_list;
+    maxentmc_index_t s;
+
+    while(temp){
+        if(temp->multiplier_powers == multiplier_powers && temp->num_sets == num_sets){
+            s = 0;
+            while((s<num_sets) && (temp->moment_powers[s] == moment_powers[s]))
+                ++s;
+            if(s == num_sets)
+                return temp;
+        }
+        temp = temp->next;
+    }
+
+    struct maxentmc_power_struct const * powers[1+num_sets];
+    size_t total = 0;
+
+    powers[0] = multiplier_powers;
+    for(s=0;s<num_sets;++s){
+        powers[1+s] = moment_powers[s];
+        total += moment_powers[s]->size;
+    }
+
+    temp = malloc(sizeof(struct maxentmc_quad_helper_plan_list_struct));
+    if(temp == NULL){
+        MAXENTMC_MESSAGE(stderr,"error: insufficient memory");
+        return NULL;
+    }
+
+    temp->plan = maxentmc_quad_plan_alloc(1+num_sets,powers);
+    if(temp->plan == NULL){
+        free(temp);
+        return NULL;
+    }
+
+    /** There are at most as many accumulators as moments, acc_index and all acc_pos share one allocation **/
+
+    temp->acc_index = malloc(sizeof(size_t)*2*total);
+    if(temp->acc_index == NULL){
+        maxentmc_quad_plan_free(temp->plan);
+        free(temp);
+        MAXENTMC_MESSAGE(stderr,"error: insufficient memory");
+        return NULL;
+    }
+
+    /** Accumulators are assigned to the distinct moment monomials in the order of their first appearance **/
+
+    size_t slot[temp->plan->size];
+    size_t * pos = temp->acc_index+total;
+    size_t i;
+
+    for(i=0;i<temp->plan->size;++i)
+        slot[i] = MAXENTMC_QUAD_PLAN_NONE;
+
+    temp->acc_size = 0;
+    for(s=0;s<num_sets;++s){
+        size_t const * const index = temp->plan->index[1+s];
+        temp->acc_pos[s] = pos;
+        for(i=0;i<moment_powers[s]->size;++i){
+            if(slot[index[i]] == MAXENTMC_QUAD_PLAN_NONE){
+                slot[index[i]] = temp->acc_size;
+                temp->acc_index[temp->acc_size++] = index[i];
+            }
+            pos[i] = slot[index[i]];
+        }
+        pos += moment_powers[s]->size;
+        temp->moment_powers[s] = moment_powers[s];
+    }
+
+    temp->multiplier_powers = multiplier_powers;
+    temp->num_sets = num_sets;
+    temp->next = q->plan_list;
+    q->plan_list = temp;
+
+    return temp;
+}
+
+/** Rebuilds the plan of the helper for the current multipliers and armed moment sets **/
+
+static int maxentmc_quad_helper_update_plan(struct maxentmc_quad_helper_struct * const q)
+{
+    if(q->multipliers == NULL){
+        q->plan = NULL;
+        return 0;
+    }
+
+    struct maxentmc_power_struct const * moment_powers[q->n_sets];
+    maxentmc_index_t s;
+
+    for(s=0;s<q->n_sets;++s)
+        moment_powers[s] = q->moments[s]->powers;
+
+    q->plan = maxentmc_quad_helper_find_plan(q,q->multipliers->powers,q->n_sets,moment_powers);
+    if(q->plan == NULL){
+        MAXENTMC_MESSAGE(stderr,"error: maxentmc_quad_helper_find_plan returned NULL for some reason");
+        return -1;
+    }
+
+    return 0;
+}
+
 int maxentmc_quad_helper_set_multipliers(struct maxentmc_quad_helper_struct * const q, struct maxentmc_power_vector_struct const * const power_vector)
 {
     MAXENTMC_CHECK_NULL(q);
@@ -349,15 +633,6 @@ int maxentmc_quad_helper_set_multipliers(struct maxentmc_quad_helper_struct * co
 
     q->multipliers = temp_v;
 
-    if(q->moments && q->multipliers)
-        q->max_power = QUAD_MAX(q->moments->powers->max_power,q->multipliers->powers->max_power);
-    else{
-        if(q->moments)
-            q->max_power = q->moments->powers->max_power;
-        else
-            q->max_power = q->multipliers->powers->max_power;
-    }
-
     return 0;
 
 
@@ -389,292 +664,762 @@ int maxentmc_quad_helper_set_moments(struct maxentmc_quad_helper_struct * const
         return -1;
     }
 
+    q->moments[0] = temp_v;
+    q->n_sets = 1;
+
+    if(maxentmc_quad_helper_update_plan(q)){
+        pthread_mutex_unlock(&q->lock);
+        return -1;
+    }
+
     memset(temp_v->gsl_vec.data, 0, sizeof(maxentmc_float_t)*temp_v->gsl_vec.size);
 
-    q->moments = temp_v;
+    q->load = maxentmc_quad_helper_select_load(q);
+
+    q->collected = 0;
+    q->ranks_reduced = 0;
     q->armed = 1;
+    ++(q->pass);
+    q->live = 0;
 
-    if(q->moments && q->multipliers)
-        q->max_power = QUAD_MAX(q->moments->powers->max_power,q->multipliers->powers->max_power);
-    else{
-        if(q->moments)
-            q->max_power = q->moments->powers->max_power;
-        else
-            q->max_power = q->multipliers->powers->max_power;
+    pthread_mutex_unlock(&q->lock);
+
+    return 0;
+}
+
+int maxentmc_quad_helper_add_moments(struct maxentmc_quad_helper_struct * const q, struct maxentmc_power_vector_struct const * const power_vector)
+{
+    MAXENTMC_CHECK_NULL(q);
+    MAXENTMC_CHECK_NULL(power_vector);
+
+    pthread_mutex_lock(&q->lock);
+
+    if(!q->armed){
+        pthread_mutex_unlock(&q->lock);
+        MAXENTMC_MESSAGE(stderr,"error: quad helper not armed");
+        return -1;
     }
 
+    if(q->live){
+        pthread_mutex_unlock(&q->lock);
+        MAXENTMC_MESSAGE(stderr,"error: accumulators of the pass are already allocated");
+        return -1;
+    }
+
+    if(q->n_sets == MAXENTMC_QUAD_HELPER_MAX_MOMENT_SETS){
+        pthread_mutex_unlock(&q->lock);
+        MAXENTMC_MESSAGE(stderr,"error: too many moment sets");
+        return -1;
+    }
+
+    if(q->dimension != power_vector->powers->dimension){
+        pthread_mutex_unlock(&q->lock);
+        MAXENTMC_MESSAGE(stderr,"error: dimensions do not match");
+        return -1;
+    }
+
+    maxentmc_index_t s;
+
+    for(s=0;s<q->n_sets;++s)
+        if(q->moments[s]->powers == power_vector->powers){
+            pthread_mutex_unlock(&q->lock);
+            MAXENTMC_MESSAGE(stderr,"error: moments are already set");
+            return -1;
+        }
+
+    struct maxentmc_power_vector_struct * temp_v = maxentmc_quad_helper_find_power_vector(q,power_vector,1);
+    if(temp_v == NULL){
+        pthread_mutex_unlock(&q->lock);
+        MAXENTMC_MESSAGE(stderr,"error: maxentmc_quad_helper_find_power_vector returned NULL for some reason");
+        return -1;
+    }
+
+    q->moments[q->n_sets++] = temp_v;
+
+    if(maxentmc_quad_helper_update_plan(q)){
+        --(q->n_sets);
+        pthread_mutex_unlock(&q->lock);
+        return -1;
+    }
+
+    memset(temp_v->gsl_vec.data, 0, sizeof(maxentmc_float_t)*temp_v->gsl_vec.size);
+
     pthread_mutex_unlock(&q->lock);
 
     return 0;
 }
 
-struct maxentmc_quad_helper_thread_struct * maxentmc_quad_helper_thread_alloc(struct maxentmc_quad_helper_struct * const q)
+/** The largest tile whose monomials, abscissas, weights and densities take at most an eighth of the L2 cache (larger
+    tiles save little on the accumulators, but their monomials no longer stay in the cache between the sweeps) **/
+
+static size_t maxentmc_quad_helper_tile_size(size_t const monomials_size, maxentmc_index_t const dim)
 {
+    size_t tile = maxentmc_cpu_l2_cache_size()/(8*sizeof(maxentmc_float_t)*(monomials_size+dim+2));
 
-    MAXENTMC_CHECK_NULL_PT(q);
+    tile -= tile%MAXENTMC_QUAD_THREAD_HOWMANY_AT_ONCE;
+
+    if(tile<MAXENTMC_QUAD_THREAD_HOWMANY_AT_ONCE)
+        tile = MAXENTMC_QUAD_THREAD_HOWMANY_AT_ONCE;
+
+    if(tile>MAXENTMC_QUAD_THREAD_MAX_TILE)
+        tile = MAXENTMC_QUAD_THREAD_MAX_TILE;
+
+    return tile;
+}
+
+/** Checks that q is armed for a pass, the caller holds the lock of the helper **/
 
+static int maxentmc_quad_helper_thread_check(struct maxentmc_quad_helper_struct const * const q)
+{
     if(q->multipliers == NULL){
         MAXENTMC_MESSAGE(stderr,"error: multipliers is NULL");
-        return NULL;
-    }
-
-    if(q->moments == NULL){
-        MAXENTMC_MESSAGE(stderr,"error: moments is NULL");
-        return NULL;
+        return -1;
     }
 
     if(!q->armed){
         MAXENTMC_MESSAGE(stderr,"error: quad helper not armed");
-        return NULL;
+        return -1;
     }
 
-    int status;
+    if(q->plan == NULL){
+        MAXENTMC_MESSAGE(stderr,"error: monomial plan is NULL");
+        return -1;
+    }
 
-    size_t size = sizeof(maxentmc_float_t)*q->moments->gsl_vec.size;
+    return 0;
+}
 
-    struct maxentmc_quad_helper_thread_struct * qt;
+/** Lays out an accumulator for the armed plan of q in the buffer of qt (which must be large enough) and zeroes it **/
 
-    MAXENTMC_ALLOC(qt,MAXENTMC_QUAD_THREAD_FULL_SIZE(size),status);
+static void maxentmc_quad_helper_thread_layout(struct maxentmc_quad_helper_thread_struct * const qt,
+                                               struct maxentmc_quad_helper_struct * const q, size_t const tile)
+{
+    size_t const size = q->plan->acc_size;
 
-    if(status)
-        return NULL;
+    size_t const monomials_size = q->plan->plan->size;
 
     qt->main_quadrature = q;
 
+    qt->next = NULL;
+
+    qt->plan = q->plan;
+
+    qt->tile = tile;
+
+    qt->pending = 0;
+
+    /** Accumulator rows are MAXENTMC_QUAD_THREAD_HOWMANY_AT_ONCE wide, the other rows a tile wide, all of them start on
+        a cache line, so that the vector kernels can use aligned loads **/
+
     qt->moments = MAXENTMC_INCREMENT_POINTER(qt,MAXENTMC_QUAD_THREAD_HEADER_SIZE);
 
-    qt->scratch = MAXENTMC_INCREMENT_POINTER(qt,MAXENTMC_QUAD_THREAD_MOMENT_SIZE(size));
+    qt->monomials = MAXENTMC_INCREMENT_POINTER(qt->moments,MAXENTMC_QUAD_THREAD_ROWS_SIZE(size));
 
-    memset(qt->moments,0,size);
+    qt->x = MAXENTMC_INCREMENT_POINTER(qt->monomials,MAXENTMC_QUAD_THREAD_TILE_SIZE(monomials_size,tile));
 
-    /** DEBUG **/
-    /*
-    MAXENTMC_MESSAGE_VARARG(stdout,"n_mult = %u, n_mom = %u",q->n_mult,q->n_mom);
-    */
-    /** END DEBUG **/
+    qt->w = MAXENTMC_INCREMENT_POINTER(qt->x,MAXENTMC_QUAD_THREAD_TILE_SIZE(q->dimension,tile));
 
-    return qt;
+    qt->rho = MAXENTMC_INCREMENT_POINTER(qt->w,MAXENTMC_QUAD_THREAD_TILE_SIZE(1,tile));
+
+    memset(qt->moments,0,sizeof(maxentmc_float_t)*size*MAXENTMC_QUAD_THREAD_HOWMANY_AT_ONCE);
+
+    /** The constant monomial, first in every plan, never changes **/
+
+    size_t k;
+    for(k=0;k<tile;++k)
+        qt->monomials[k] = 1.0;
 }
 
-int maxentmc_quad_helper_thread_compute(struct maxentmc_quad_helper_thread_struct * const qt, ...)
+/** Returns an accumulator for the armed plan of q, reusing the buffer of qt (may be NULL) when it is large enough,
+    otherwise a new one, in which case qt is left untouched **/
+
+static struct maxentmc_quad_helper_thread_struct * maxentmc_quad_helper_thread_fit(struct maxentmc_quad_helper_thread_struct * const qt,
+                                                                                   struct maxentmc_quad_helper_struct * const q)
 {
-    MAXENTMC_CHECK_NULL(qt);
-    maxentmc_index_t const dim = qt->main_quadrature->multipliers->powers->dimension;
-    maxentmc_float_t x[dim], w;
-    maxentmc_index_t i;
-    va_list ap;
-    va_start(ap,qt);
-    for(i=0;i<dim;++i)
-        x[i] = va_arg(ap,maxentmc_float_t);
-    w = va_arg(ap,maxentmc_float_t);
-    va_end(ap);
-    return maxentmc_quad_helper_thread_compute_1(qt,x,w);
-}
+    size_t const size = q->plan->acc_size;
 
-#define MAXENTMC_QUADRATURE_THREAD_COMPUTE(_N_)                                                 \
-                                                                                                \
-    struct maxentmc_power_vector_struct const * const multipliers = q->multipliers;             \
-    struct maxentmc_power_vector_struct const * const moments = q->moments;                     \
-                                                                                                \
-    size_t const d_size = multipliers->gsl_vec.size;                                            \
-    maxentmc_index_t const * const * const __restrict d_powers =                                \
-        (maxentmc_index_t const * const * const)multipliers->powers->power;                     \
-    maxentmc_float_t const * const __restrict d_data = multipliers->gsl_vec.data;               \
-    maxentmc_float_t const scale = q->scale;                                                    \
-                                                                                                \
-    size_t m_size = moments->gsl_vec.size;                                                      \
-    maxentmc_index_t const * const * const __restrict m_powers =                                \
-        (maxentmc_index_t const * const * const)moments->powers->power;                         \
-    maxentmc_float_t * const __restrict m_data = qt->moments;                                   \
-                                                                                                \
-    for(i=2;i<p1;++i){                                                                          \
-        maxentmc_index_t j;                                                                     \
-        for(j=0;j<dim;++j){                                                                     \
-            maxentmc_float_t * __restrict _x1_ = x_pow[j*p1+1];                                 \
-            maxentmc_float_t * __restrict _x_ = x_pow[j*p1+i];                                  \
-            maxentmc_float_t * __restrict _x_prev_ = x_pow[j*p1+i-1];                           \
-            maxentmc_index_t k;                                                                 \
-            for(k=0;k<(_N_);++k)                                                                \
-                _x_[k] = _x_prev_[k] * _x1_[k];                                                 \
-        }                                                                                       \
-    }                                                                                           \
-                                                                                                \
-    maxentmc_float_t rho[(_N_)];                                                                \
-                                                                                                \
-    memset(rho,0,sizeof(maxentmc_float_t)*(_N_));                                               \
-                                                                                                \
-    if(d_powers == m_powers){                                                                   \
-                                                                                                \
-        maxentmc_float_t * const temp_moments = qt->scratch;                                    \
-                                                                                                \
-        for(i=0;i<d_size;++i){                                                                  \
-            maxentmc_index_t const * const __restrict d_p = d_powers[i];                        \
-            maxentmc_float_t * const __restrict temp_m = temp_moments + i*(_N_);                \
-            maxentmc_index_t j;                                                                 \
-            for(j=0;j<(_N_);++j)                                                                \
-                temp_m[j] = 1.0;                                                                \
-            for(j=0;j<dim;++j){                                                                 \
-                maxentmc_float_t const * const __restrict _x_ = x_pow[j*p1+d_p[j]];             \
-                maxentmc_index_t k;                                                             \
-                for(k=0;k<(_N_);++k)                                                            \
-                    temp_m[k] *= _x_[k];                                                        \
-            }                                                                                   \
-            for(j=0;j<(_N_);++j)                                                                \
-                rho[j] += d_data[i] * temp_m[j];                                                \
-        }                                                                                       \
+    size_t const monomials_size = q->plan->plan->size;
+
+    size_t const tile = maxentmc_quad_helper_tile_size(monomials_size,q->dimension);
+
+    size_t const full_size = MAXENTMC_QUAD_THREAD_FULL_SIZE(size,monomials_size,q->dimension,tile);
+
+    if(qt){
+        if(qt->capacity >= full_size){
+            maxentmc_quad_helper_thread_layout(qt,q,tile);
+            return qt;
+        }
+        /** A smaller plan may still fit with the tile the buffer was laid out with, unless the moments must be reproducible:
+            the tile decides which points are summed together **/
+        if((q->reduction_mode == MAXENTMC_QUAD_HELPER_REDUCTION_FAST) && (qt->tile < tile)
+           && (qt->capacity >= MAXENTMC_QUAD_THREAD_FULL_SIZE(size,monomials_size,q->dimension,qt->tile))){
+            maxentmc_quad_helper_thread_layout(qt,q,qt->tile);
+            return qt;
+        }
+    }
+
+    int status;
+
+    struct maxentmc_quad_helper_thread_struct * new_qt;
+
+    MAXENTMC_ALLOC(new_qt,full_size,status);
+
+    if(status)
+        return NULL;
+
+    new_qt->capacity = full_size;
+
+    new_qt->node = (qt)?qt->node:-1;
+
+    maxentmc_quad_helper_thread_layout(new_qt,q,tile);
+
+    return new_qt;
+}
+
+struct maxentmc_quad_helper_thread_struct * maxentmc_quad_helper_thread_alloc(struct maxentmc_quad_helper_struct * const q)
+{
+    return maxentmc_quad_helper_thread_alloc_on_node(q,-1);
+}
+
+struct maxentmc_quad_helper_thread_struct * maxentmc_quad_helper_thread_alloc_on_node(struct maxentmc_quad_helper_struct * const q, int const node)
+{
+
+    MAXENTMC_CHECK_NULL_PT(q);
+
+    pthread_mutex_lock(&q->lock);
+
+    if(maxentmc_quad_helper_thread_check(q)){
+        pthread_mutex_unlock(&q->lock);
+        return NULL;
+    }
+
+    /** Accumulators merged in a previous pass are reused before allocating new ones, on the same node if one is given.
+        The new one is counted before the plan is read, so that no moment set can be added meanwhile **/
+
+    struct maxentmc_quad_helper_thread_struct ** link = &q->spare;
+
+    while(*link && (node >= 0) && ((*link)->node != node))
+        link = &(*link)->next;
+
+    struct maxentmc_quad_helper_thread_struct * const spare = *link;
+
+    if(spare)
+        *link = spare->next;
+
+    size_t const pass = q->pass;
+
+    ++(q->live);
+
+    pthread_mutex_unlock(&q->lock);
+
+    struct maxentmc_quad_helper_thread_struct * const qt = maxentmc_quad_helper_thread_fit(spare,q);
+
+    if(spare && (qt != spare))
+        free(spare);
+
+    if(qt == NULL){
+        pthread_mutex_lock(&q->lock);
+        if(pass == q->pass)
+            --(q->live);
+        pthread_mutex_unlock(&q->lock);
+        return NULL;
+    }
+
+    qt->pass = pass;
+
+    if(qt != spare)
+        qt->node = node;
+
+    /** DEBUG **/
+    /*
+    MAXENTMC_MESSAGE_VARARG(stdout,"n_mult = %u, n_mom = %u",q->n_mult,q->n_mom);
+    */
+    /** END DEBUG **/
+
+    return qt;
+}
+
+struct maxentmc_quad_helper_thread_struct * maxentmc_quad_helper_thread_realloc(struct maxentmc_quad_helper_thread_struct * const qt)
+{
+    MAXENTMC_CHECK_NULL_PT(qt);
+
+    struct maxentmc_quad_helper_struct * const q = qt->main_quadrature;
+
+    pthread_mutex_lock(&q->lock);
+
+    if(maxentmc_quad_helper_thread_check(q)){
+        pthread_mutex_unlock(&q->lock);
+        return NULL;
+    }
+
+    /** An accumulator kept from an earlier pass is counted in the armed one **/
+
+    size_t const pass = q->pass;
+
+    int const counted = (qt->pass == pass);
+
+    if(!counted)
+        ++(q->live);
+
+    pthread_mutex_unlock(&q->lock);
+
+    struct maxentmc_quad_helper_thread_struct * const new_qt = maxentmc_quad_helper_thread_fit(qt,q);
+
+    if(new_qt == NULL){
+        if(!counted){
+            pthread_mutex_lock(&q->lock);
+            if(pass == q->pass)
+                --(q->live);
+            pthread_mutex_unlock(&q->lock);
+        }
+        return NULL;
+    }
+
+    if(new_qt != qt)
+        free(qt);
+
+    new_qt->pass = pass;
+
+    return new_qt;
+}
+
+void maxentmc_quad_helper_thread_free(struct maxentmc_quad_helper_thread_struct * const qt)
+{
+    if(qt){
+        pthread_mutex_lock(&qt->main_quadrature->lock);
+        if(qt->pass == qt->main_quadrature->pass)
+            --(qt->main_quadrature->live);
+        pthread_mutex_unlock(&qt->main_quadrature->lock);
+        free(qt);
+    }
+}
+
+/** Fails if the accumulator is laid out for another plan than the armed one, e.g. kept from an earlier pass and not
+    passed through maxentmc_quad_helper_thread_realloc: the kernel would run past the end of its buffer **/
+
+static int maxentmc_quad_helper_thread_stale(struct maxentmc_quad_helper_thread_struct const * const qt)
+{
+    if(qt->plan != qt->main_quadrature->plan){
+        MAXENTMC_MESSAGE(stderr,"error: accumulator is not laid out for the armed moments");
+        return -1;
+    }
+
+    return 0;
+}
+
+int maxentmc_quad_helper_thread_compute(struct maxentmc_quad_helper_thread_struct * const qt, ...)
+{
+    MAXENTMC_CHECK_NULL(qt);
+    maxentmc_index_t const dim = qt->main_quadrature->multipliers->powers->dimension;
+    maxentmc_float_t x[dim], w;
+    maxentmc_index_t i;
+    va_list ap;
+    va_start(ap,qt);
+    for(i=0;i<dim;++i)
+        x[i] = va_arg(ap,maxentmc_float_t);
+    w = va_arg(ap,maxentmc_float_t);
+    va_end(ap);
+    return maxentmc_quad_helper_thread_compute_1(qt,x,w);
+}
+
+/** Quadrature kernel over a tile of points loaded into the thread scratch. The monomials of multipliers and moments
+    are evaluated together, each one multiplication of an earlier monomial by a coordinate, for the whole tile, then
+    the density of the tile, and finally the moments are swept accumulator by accumulator, so that every accumulator
+    is loaded and stored once per tile. The accumulator rows are MAXENTMC_QUAD_THREAD_HOWMANY_AT_ONCE lanes wide
+    (the lanes are summed in maxentmc_quad_helper_thread_merge), and four of them are updated together to keep
+    enough independent additions in flight. The number of points n is a multiple of MAXENTMC_QUAD_THREAD_HOWMANY_AT_ONCE,
+    see maxentmc_quad_helper_thread_pad. **/
+
+/** Taylor degree of the vectorized exponential for each enum MAXENTMC_QUAD_HELPER_EXP_MODE **/
+
+static int const maxentmc_quad_helper_exp_degree[] = {MAXENTMC_SIMD_EXP_DEGREE_MAX, 10, 6};
+
+/** Four accumulators at a time, each one summed over the tile in a register and added to the first lanes of its row **/
+
+#define MAXENTMC_QUADRATURE_THREAD_ACCUMULATE_4(_V_)                                            \
+{                                                                                               \
+    maxentmc_float_t const * const _m0_ = mono+m_index[i]*tile;                                 \
+    maxentmc_float_t const * const _m1_ = mono+m_index[i+1]*tile;                               \
+    maxentmc_float_t const * const _m2_ = mono+m_index[i+2]*tile;                               \
+    maxentmc_float_t const * const _m3_ = mono+m_index[i+3]*tile;                               \
+    MAXENTMC_SIMD_##_V_##_T _a0_ = MAXENTMC_SIMD_##_V_##_ZERO();                                \
+    MAXENTMC_SIMD_##_V_##_T _a1_ = MAXENTMC_SIMD_##_V_##_ZERO();                                \
+    MAXENTMC_SIMD_##_V_##_T _a2_ = MAXENTMC_SIMD_##_V_##_ZERO();                                \
+    MAXENTMC_SIMD_##_V_##_T _a3_ = MAXENTMC_SIMD_##_V_##_ZERO();                                \
+    for(l=0;l<n;l+=MAXENTMC_SIMD_##_V_##_WIDTH){                                                \
+        MAXENTMC_SIMD_##_V_##_T const _r_ = MAXENTMC_SIMD_##_V_##_LOAD(rho+l);                  \
+        _a0_ = MAXENTMC_SIMD_##_V_##_FMADD(MAXENTMC_SIMD_##_V_##_LOAD(_m0_+l),_r_,_a0_);        \
+        _a1_ = MAXENTMC_SIMD_##_V_##_FMADD(MAXENTMC_SIMD_##_V_##_LOAD(_m1_+l),_r_,_a1_);        \
+        _a2_ = MAXENTMC_SIMD_##_V_##_FMADD(MAXENTMC_SIMD_##_V_##_LOAD(_m2_+l),_r_,_a2_);        \
+        _a3_ = MAXENTMC_SIMD_##_V_##_FMADD(MAXENTMC_SIMD_##_V_##_LOAD(_m3_+l),_r_,_a3_);        \
+    }                                                                                           \
+    maxentmc_float_t * const _acc_ = m_data+i*MAXENTMC_QUAD_THREAD_HOWMANY_AT_ONCE;             \
+    MAXENTMC_SIMD_##_V_##_STORE(_acc_,MAXENTMC_SIMD_##_V_##_ADD(MAXENTMC_SIMD_##_V_##_LOAD(_acc_),_a0_)); \
+    MAXENTMC_SIMD_##_V_##_STORE(_acc_+MAXENTMC_QUAD_THREAD_HOWMANY_AT_ONCE,                     \
+        MAXENTMC_SIMD_##_V_##_ADD(MAXENTMC_SIMD_##_V_##_LOAD(_acc_+MAXENTMC_QUAD_THREAD_HOWMANY_AT_ONCE),_a1_)); \
+    MAXENTMC_SIMD_##_V_##_STORE(_acc_+2*MAXENTMC_QUAD_THREAD_HOWMANY_AT_ONCE,                   \
+        MAXENTMC_SIMD_##_V_##_ADD(MAXENTMC_SIMD_##_V_##_LOAD(_acc_+2*MAXENTMC_QUAD_THREAD_HOWMANY_AT_ONCE),_a2_)); \
+    MAXENTMC_SIMD_##_V_##_STORE(_acc_+3*MAXENTMC_QUAD_THREAD_HOWMANY_AT_ONCE,                   \
+        MAXENTMC_SIMD_##_V_##_ADD(MAXENTMC_SIMD_##_V_##_LOAD(_acc_+3*MAXENTMC_QUAD_THREAD_HOWMANY_AT_ONCE),_a3_)); \
+}
+
+#define MAXENTMC_QUADRATURE_THREAD_ACCUMULATE_1(_V_)                                            \
+{                                                                                               \
+    maxentmc_float_t const * const _m0_ = mono+m_index[i]*tile;                                 \
+    MAXENTMC_SIMD_##_V_##_T _a0_ = MAXENTMC_SIMD_##_V_##_ZERO();                                \
+    for(l=0;l<n;l+=MAXENTMC_SIMD_##_V_##_WIDTH)                                                 \
+        _a0_ = MAXENTMC_SIMD_##_V_##_FMADD(MAXENTMC_SIMD_##_V_##_LOAD(_m0_+l),                  \
+                   MAXENTMC_SIMD_##_V_##_LOAD(rho+l),_a0_);                                     \
+    maxentmc_float_t * const _acc_ = m_data+i*MAXENTMC_QUAD_THREAD_HOWMANY_AT_ONCE;             \
+    MAXENTMC_SIMD_##_V_##_STORE(_acc_,MAXENTMC_SIMD_##_V_##_ADD(MAXENTMC_SIMD_##_V_##_LOAD(_acc_),_a0_)); \
+}
+
+#define MAXENTMC_QUADRATURE_THREAD_KERNEL(_name_,_V_)                                           \
+MAXENTMC_SIMD_##_V_##_TARGET static void _name_(struct maxentmc_quad_helper_thread_struct * const qt, size_t const n) \
+{                                                                                               \
+    struct maxentmc_quad_helper_struct const * const q = qt->main_quadrature;                   \
+    struct maxentmc_quad_plan_struct const * const plan = q->plan->plan;                        \
                                                                                                 \
-        for(i=0;i<(_N_);++i)                                                                    \
-            rho[i] = exp(rho[i]) * w[i];                                                        \
+    size_t const d_size = q->multipliers->gsl_vec.size;                                         \
+    size_t const * const __restrict d_index = plan->index[0];                                   \
+    maxentmc_float_t const * const __restrict d_data = q->multipliers->gsl_vec.data;            \
                                                                                                 \
-        if(shift_rotate)                                                                        \
-            for(i=0;i<(_N_);++i)                                                                \
-                rho[i] *= scale;                                                                \
+    size_t const m_size = q->plan->acc_size;                                                    \
+    size_t const * const __restrict m_index = q->plan->acc_index;                               \
+    maxentmc_float_t * const __restrict m_data = qt->moments;                                   \
                                                                                                 \
-        for(i=0;i<m_size;++i){                                                                  \
-            maxentmc_index_t j;                                                                 \
-            maxentmc_float_t const * const __restrict temp_m = temp_moments + i*(_N_);          \
-            for(j=0;j<(_N_);++j)                                                                \
-                m_data[i] += temp_m[j]*rho[j];                                                  \
-        }                                                                                       \
+    size_t const * const __restrict parent = plan->parent;                                      \
+    maxentmc_index_t const * const __restrict coord = plan->coord;                              \
+    size_t const tile = qt->tile;                                                               \
+    maxentmc_float_t const * const __restrict x = qt->x;                                        \
+    maxentmc_float_t * const __restrict mono = qt->monomials;                                   \
+    maxentmc_float_t * const __restrict rho = qt->rho;                                          \
+                                                                                                \
+    size_t i, l;                                                                                \
+                                                                                                \
+    /** All monomials, one multiplication each **/                                              \
                                                                                                 \
+    for(i=1;i<plan->size;++i){                                                                  \
+        maxentmc_float_t const * const _p_ = mono+parent[i]*tile;                               \
+        maxentmc_float_t const * const _x_ = x+coord[i]*tile;                                   \
+        maxentmc_float_t * const _m_ = mono+i*tile;                                             \
+        for(l=0;l<n;l+=MAXENTMC_SIMD_##_V_##_WIDTH)                                             \
+            MAXENTMC_SIMD_##_V_##_STORE(_m_+l,MAXENTMC_SIMD_##_V_##_MUL(                        \
+                MAXENTMC_SIMD_##_V_##_LOAD(_p_+l),MAXENTMC_SIMD_##_V_##_LOAD(_x_+l)));          \
     }                                                                                           \
-    else{                                                                                       \
                                                                                                 \
-        maxentmc_float_t * const __restrict temp_m = qt->scratch;                               \
+    /** The polynomial under the exponent, four terms per pass over the tile **/                \
                                                                                                 \
-        for(i=0;i<d_size;++i){                                                                  \
-            maxentmc_index_t const * const __restrict d_p = d_powers[i];                        \
-            maxentmc_index_t j;                                                                 \
-            for(j=0;j<(_N_);++j)                                                                \
-                temp_m[j] = 1.0;                                                                \
-            for(j=0;j<dim;++j){                                                                 \
-                maxentmc_float_t const * const __restrict _x_ = x_pow[j*p1+d_p[j]];             \
-                maxentmc_index_t k;                                                             \
-                for(k=0;k<(_N_);++k)                                                            \
-                    temp_m[k] *= _x_[k];                                                        \
-            }                                                                                   \
-            for(j=0;j<(_N_);++j)                                                                \
-                rho[j] += d_data[i]*temp_m[j];                                                  \
+    for(l=0;l<n;l+=MAXENTMC_SIMD_##_V_##_WIDTH)                                                 \
+        MAXENTMC_SIMD_##_V_##_STORE(rho+l,MAXENTMC_SIMD_##_V_##_ZERO());                        \
+                                                                                                \
+    for(i=0;i+4<=d_size;i+=4){                                                                  \
+        MAXENTMC_SIMD_##_V_##_T const c0 = MAXENTMC_SIMD_##_V_##_SET1(d_data[i]);               \
+        MAXENTMC_SIMD_##_V_##_T const c1 = MAXENTMC_SIMD_##_V_##_SET1(d_data[i+1]);             \
+        MAXENTMC_SIMD_##_V_##_T const c2 = MAXENTMC_SIMD_##_V_##_SET1(d_data[i+2]);             \
+        MAXENTMC_SIMD_##_V_##_T const c3 = MAXENTMC_SIMD_##_V_##_SET1(d_data[i+3]);             \
+        maxentmc_float_t const * const _m0_ = mono+d_index[i]*tile;                             \
+        maxentmc_float_t const * const _m1_ = mono+d_index[i+1]*tile;                           \
+        maxentmc_float_t const * const _m2_ = mono+d_index[i+2]*tile;                           \
+        maxentmc_float_t const * const _m3_ = mono+d_index[i+3]*tile;                           \
+        for(l=0;l<n;l+=MAXENTMC_SIMD_##_V_##_WIDTH){                                            \
+            MAXENTMC_SIMD_##_V_##_T _r_ = MAXENTMC_SIMD_##_V_##_LOAD(rho+l);                    \
+            _r_ = MAXENTMC_SIMD_##_V_##_FMADD(c0,MAXENTMC_SIMD_##_V_##_LOAD(_m0_+l),_r_);       \
+            _r_ = MAXENTMC_SIMD_##_V_##_FMADD(c1,MAXENTMC_SIMD_##_V_##_LOAD(_m1_+l),_r_);       \
+            _r_ = MAXENTMC_SIMD_##_V_##_FMADD(c2,MAXENTMC_SIMD_##_V_##_LOAD(_m2_+l),_r_);       \
+            _r_ = MAXENTMC_SIMD_##_V_##_FMADD(c3,MAXENTMC_SIMD_##_V_##_LOAD(_m3_+l),_r_);       \
+            MAXENTMC_SIMD_##_V_##_STORE(rho+l,_r_);                                             \
         }                                                                                       \
+    }                                                                                           \
+    for(;i<d_size;++i){                                                                         \
+        MAXENTMC_SIMD_##_V_##_T const c = MAXENTMC_SIMD_##_V_##_SET1(d_data[i]);                \
+        maxentmc_float_t const * const _m_ = mono+d_index[i]*tile;                              \
+        for(l=0;l<n;l+=MAXENTMC_SIMD_##_V_##_WIDTH)                                             \
+            MAXENTMC_SIMD_##_V_##_STORE(rho+l,MAXENTMC_SIMD_##_V_##_FMADD(c,                    \
+                MAXENTMC_SIMD_##_V_##_LOAD(_m_+l),MAXENTMC_SIMD_##_V_##_LOAD(rho+l)));          \
+    }                                                                                           \
                                                                                                 \
-        for(i=0;i<(_N_);++i)                                                                    \
-            rho[i] = exp(rho[i]) * w[i];                                                        \
+    /** Density at the quadrature points **/                                                    \
                                                                                                 \
-        if(shift_rotate)                                                                        \
-            for(i=0;i<(_N_);++i)                                                                \
-                rho[i] *= scale;                                                                \
+    {                                                                                           \
+        int const degree = maxentmc_quad_helper_exp_degree[q->exp_mode];                        \
+        MAXENTMC_SIMD_##_V_##_T const scale = MAXENTMC_SIMD_##_V_##_SET1(q->shift_rotate ? q->scale : 1.0); \
+        for(l=0;l<n;l+=MAXENTMC_SIMD_##_V_##_WIDTH)                                             \
+            MAXENTMC_SIMD_##_V_##_STORE(rho+l,MAXENTMC_SIMD_##_V_##_MUL(MAXENTMC_SIMD_##_V_##_MUL( \
+                maxentmc_simd_exp_##_V_(MAXENTMC_SIMD_##_V_##_LOAD(rho+l),degree),               \
+                MAXENTMC_SIMD_##_V_##_LOAD(qt->w+l)),scale));                                   \
+    }                                                                                           \
                                                                                                 \
-        for(i=0;i<m_size;++i){                                                                  \
-            maxentmc_index_t const * const __restrict m_p = m_powers[i];                        \
-            maxentmc_index_t j;                                                                 \
-            for(j=0;j<(_N_);++j)                                                                \
-                temp_m[j] = rho[j];                                                             \
-            for(j=0;j<dim;++j){                                                                 \
-                maxentmc_float_t const * const __restrict _x_ = x_pow[j*p1+m_p[j]];             \
-                maxentmc_index_t k;                                                             \
-                for(k=0;k<(_N_);++k)                                                            \
-                    temp_m[k] *= _x_[k];                                                        \
-            }                                                                                   \
-            for(j=0;j<(_N_);++j)                                                                \
-                m_data[i] += temp_m[j];                                                         \
-        }                                                                                       \
+    /** Moment accumulation **/                                                                 \
                                                                                                 \
-    }
+    for(i=0;i+4<=m_size;i+=4)                                                                   \
+        MAXENTMC_QUADRATURE_THREAD_ACCUMULATE_4(_V_)                                            \
+    for(;i<m_size;++i)                                                                          \
+        MAXENTMC_QUADRATURE_THREAD_ACCUMULATE_1(_V_)                                            \
+}
 
+MAXENTMC_QUADRATURE_THREAD_KERNEL(maxentmc_quad_helper_thread_kernel_scalar,SCALAR)
 
-int maxentmc_quad_helper_thread_compute_1(struct maxentmc_quad_helper_thread_struct * const qt,
-                                          maxentmc_float_t const * const x1, maxentmc_float_t const w1)
+#ifdef MAXENTMC_SIMD_X86
+MAXENTMC_QUADRATURE_THREAD_KERNEL(maxentmc_quad_helper_thread_kernel_sse2,SSE2)
+MAXENTMC_QUADRATURE_THREAD_KERNEL(maxentmc_quad_helper_thread_kernel_avx2,AVX2)
+MAXENTMC_QUADRATURE_THREAD_KERNEL(maxentmc_quad_helper_thread_kernel_avx512,AVX512)
+#endif
+
+#ifdef MAXENTMC_SIMD_NEON
+MAXENTMC_QUADRATURE_THREAD_KERNEL(maxentmc_quad_helper_thread_kernel_neon,NEON)
+#endif
+
+static maxentmc_quad_helper_kernel_t maxentmc_quad_helper_select_kernel(void)
 {
-    MAXENTMC_CHECK_NULL(qt);
-    MAXENTMC_CHECK_NULL(x1);
+    switch(maxentmc_cpu_isa()){
+#ifdef MAXENTMC_SIMD_X86
+        case MAXENTMC_CPU_AVX512:
+            return maxentmc_quad_helper_thread_kernel_avx512;
+        case MAXENTMC_CPU_AVX2:
+            return maxentmc_quad_helper_thread_kernel_avx2;
+        case MAXENTMC_CPU_SSE2:
+            return maxentmc_quad_helper_thread_kernel_sse2;
+#endif
+#ifdef MAXENTMC_SIMD_NEON
+        case MAXENTMC_CPU_NEON:
+            return maxentmc_quad_helper_thread_kernel_neon;
+#endif
+        default:
+            return maxentmc_quad_helper_thread_kernel_scalar;
+    }
+}
+
+/** Loads n points stored in the structure-of-arrays form, x[i][offset+k] for the i-th coordinate of the k-th point
+    and w[offset+k] for its weight, into the tile of the thread scratch **/
 
+static void maxentmc_quad_helper_thread_load_n(struct maxentmc_quad_helper_thread_struct * const qt,
+                                               maxentmc_float_t const * const * const x, maxentmc_float_t const * const w,
+                                               size_t const offset, size_t const n)
+{
     struct maxentmc_quad_helper_struct const * const q = qt->main_quadrature;
-    maxentmc_index_t const dim = q->multipliers->powers->dimension;
-    maxentmc_index_t const p1 = q->max_power+1;
-    maxentmc_index_t const shift_rotate = q->shift_rotate;
+    maxentmc_index_t const dim = q->dimension;
+    size_t const tile = qt->tile;
     maxentmc_float_t const * const __restrict shift = q->shift;
     maxentmc_float_t const * const __restrict rotate = q->rotate;
 
-    maxentmc_float_t x_pow[dim*p1][1];
+    maxentmc_index_t i;
+    size_t k;
 
-    maxentmc_float_t w[1];
+    if(q->shift_rotate){
 
-    size_t i;
+        for(i=0;i<dim;++i){
+            maxentmc_float_t * const __restrict _xi_ = qt->x+i*tile;
+            maxentmc_index_t j;
+            for(k=0;k<n;++k)
+                _xi_[k] = shift[i];
+            for(j=0;j<dim;++j){
+                maxentmc_float_t const r = rotate[i*dim+j];
+                maxentmc_float_t const * const __restrict _xj_ = x[j]+offset;
+                for(k=0;k<n;++k)
+                    _xi_[k] += r*_xj_[k];
+            }
+        }
 
-    for(i=0;i<dim;++i)
-        x_pow[i*p1][0] = 1.0;
+    }
+    else
+        for(i=0;i<dim;++i)
+            memcpy(qt->x+i*tile,x[i]+offset,sizeof(maxentmc_float_t)*n);
+
+    memcpy(qt->w,w+offset,sizeof(maxentmc_float_t)*n);
+}
+
+/** The same with the shift and rotation unrolled for a fixed dimension: each point is read once and all its rotated
+    coordinates are computed together **/
+
+#define MAXENTMC_QUAD_HELPER_THREAD_LOAD(_name_,_D_)                                            \
+static void _name_(struct maxentmc_quad_helper_thread_struct * const qt,                        \
+                   maxentmc_float_t const * const * const x, maxentmc_float_t const * const w,  \
+                   size_t const offset, size_t const n)                                         \
+{                                                                                               \
+    struct maxentmc_quad_helper_struct const * const q = qt->main_quadrature;                   \
+    size_t const tile = qt->tile;                                                               \
+    maxentmc_float_t shift[_D_], rotate[(_D_)*(_D_)];                                           \
+    maxentmc_float_t const * xj[_D_];                                                           \
+    maxentmc_float_t * xi[_D_];                                                                 \
+    maxentmc_index_t i, j;                                                                      \
+    size_t k;                                                                                   \
+                                                                                                \
+    for(i=0;i<(_D_);++i){                                                                       \
+        shift[i] = q->shift[i];                                                                 \
+        for(j=0;j<(_D_);++j)                                                                    \
+            rotate[i*(_D_)+j] = q->rotate[i*(_D_)+j];                                           \
+        xj[i] = x[i]+offset;                                                                    \
+        xi[i] = qt->x+i*tile;                                                                   \
+    }                                                                                           \
+                                                                                                \
+    for(k=0;k<n;++k){                                                                           \
+        maxentmc_float_t p[_D_];                                                                \
+        for(j=0;j<(_D_);++j)                                                                    \
+            p[j] = xj[j][k];                                                                    \
+        for(i=0;i<(_D_);++i){                                                                   \
+            maxentmc_float_t s = shift[i];                                                      \
+            for(j=0;j<(_D_);++j)                                                                \
+                s += rotate[i*(_D_)+j]*p[j];                                                    \
+            xi[i][k] = s;                                                                       \
+        }                                                                                       \
+    }                                                                                           \
+                                                                                                \
+    memcpy(qt->w,w+offset,sizeof(maxentmc_float_t)*n);                                          \
+}
+
+MAXENTMC_QUAD_HELPER_THREAD_LOAD(maxentmc_quad_helper_thread_load_1d,1)
+MAXENTMC_QUAD_HELPER_THREAD_LOAD(maxentmc_quad_helper_thread_load_2d,2)
+MAXENTMC_QUAD_HELPER_THREAD_LOAD(maxentmc_quad_helper_thread_load_3d,3)
+MAXENTMC_QUAD_HELPER_THREAD_LOAD(maxentmc_quad_helper_thread_load_4d,4)
+
+static maxentmc_quad_helper_load_t maxentmc_quad_helper_select_load(struct maxentmc_quad_helper_struct const * const q)
+{
+    if(!q->shift_rotate)
+        return maxentmc_quad_helper_thread_load_n;
+
+    switch(q->dimension){
+        case 1:
+            return maxentmc_quad_helper_thread_load_1d;
+        case 2:
+            return maxentmc_quad_helper_thread_load_2d;
+        case 3:
+            return maxentmc_quad_helper_thread_load_3d;
+        case 4:
+            return maxentmc_quad_helper_thread_load_4d;
+        default:
+            return maxentmc_quad_helper_thread_load_n;
+    }
+}
+
+/** Loads a single point into position k of the tile **/
+
+static void maxentmc_quad_helper_thread_load_1(struct maxentmc_quad_helper_thread_struct * const qt, size_t const k,
+                                               maxentmc_float_t const * const x, maxentmc_float_t const w)
+{
+    struct maxentmc_quad_helper_struct const * const q = qt->main_quadrature;
+    maxentmc_index_t const dim = q->dimension;
+    maxentmc_index_t i;
 
-    if(shift_rotate){
+    if(q->shift_rotate){
 
         for(i=0;i<dim;++i){
-            x_pow[i*p1+1][0] = shift[i];
+            maxentmc_float_t xi = q->shift[i];
             maxentmc_index_t j;
             for(j=0;j<dim;++j)
-                x_pow[i*p1+1][0] += rotate[i*dim+j]*x1[j];
+                xi += q->rotate[i*dim+j]*x[j];
+            qt->x[i*qt->tile+k] = xi;
         }
 
     }
     else
         for(i=0;i<dim;++i)
-            x_pow[i*p1+1][0] = x1[i];
+            qt->x[i*qt->tile+k] = x[i];
 
-    w[0] = w1;
+    qt->w[k] = w;
+}
 
-    MAXENTMC_QUADRATURE_THREAD_COMPUTE(1);
+/** Fills the tile after the first n points up to a multiple of MAXENTMC_QUAD_THREAD_HOWMANY_AT_ONCE with copies of
+    the last point of zero weight, and returns the padded number of points **/
 
-    return 0;
+static size_t maxentmc_quad_helper_thread_pad(struct maxentmc_quad_helper_thread_struct * const qt, size_t const n)
+{
+    size_t const padded = MAXENTMC_QUAD_THREAD_HOWMANY_AT_ONCE*((n+MAXENTMC_QUAD_THREAD_HOWMANY_AT_ONCE-1)/MAXENTMC_QUAD_THREAD_HOWMANY_AT_ONCE);
+    maxentmc_index_t const dim = qt->main_quadrature->dimension;
+    maxentmc_index_t i;
+    size_t k;
+
+    for(k=n;k<padded;++k){
+        for(i=0;i<dim;++i)
+            qt->x[i*qt->tile+k] = qt->x[i*qt->tile+n-1];
+        qt->w[k] = 0.0;
+    }
+
+    return padded;
 }
 
-int maxentmc_quad_helper_thread_compute_2(struct maxentmc_quad_helper_thread_struct * const qt,
-                                          maxentmc_float_t const * const x1, maxentmc_float_t const w1,
-                                          maxentmc_float_t const * const x2, maxentmc_float_t const w2)
+/** Single points are buffered in the tile until it is full, so that they go through the tile kernel like the bulk
+    entry. A partial tile is padded and computed before the points of maxentmc_quad_helper_thread_compute_n and before
+    the accumulator is merged **/
+
+static void maxentmc_quad_helper_thread_push(struct maxentmc_quad_helper_thread_struct * const qt,
+                                             maxentmc_float_t const * const x, maxentmc_float_t const w)
+{
+    maxentmc_quad_helper_thread_load_1(qt,qt->pending,x,w);
+
+    if(++(qt->pending) == qt->tile){
+        qt->main_quadrature->kernel(qt,qt->tile);
+        qt->pending = 0;
+    }
+}
+
+static void maxentmc_quad_helper_thread_flush(struct maxentmc_quad_helper_thread_struct * const qt)
+{
+    if(qt->pending){
+        qt->main_quadrature->kernel(qt,maxentmc_quad_helper_thread_pad(qt,qt->pending));
+        qt->pending = 0;
+    }
+}
+
+int maxentmc_quad_helper_thread_compute_n(struct maxentmc_quad_helper_thread_struct * const qt, size_t const n,
+                                          maxentmc_float_t const * const * const x, maxentmc_float_t const * const w)
 {
     MAXENTMC_CHECK_NULL(qt);
-    MAXENTMC_CHECK_NULL(x1);
-    MAXENTMC_CHECK_NULL(x2);
+    MAXENTMC_CHECK_NULL(x);
+    MAXENTMC_CHECK_NULL(w);
 
-    struct maxentmc_quad_helper_struct const * const q = qt->main_quadrature;
-    maxentmc_index_t const dim = q->multipliers->powers->dimension;
-    maxentmc_index_t const p1 = q->max_power+1;
-    maxentmc_index_t const shift_rotate = q->shift_rotate;
-    maxentmc_float_t const * const __restrict shift = q->shift;
-    maxentmc_float_t const * const __restrict rotate = q->rotate;
+    maxentmc_index_t const dim = qt->main_quadrature->dimension;
+    maxentmc_index_t i;
 
-    maxentmc_float_t x_pow[dim*p1][2];
-    maxentmc_float_t w[2];
+    for(i=0;i<dim;++i)
+        MAXENTMC_CHECK_NULL(x[i]);
 
-    size_t i;
+    if(maxentmc_quad_helper_thread_stale(qt))
+        return -1;
 
-    for(i=0;i<dim;++i){
-        maxentmc_index_t j;
-        for(j=0;j<2;++j)
-            x_pow[i*p1][j] = 1.0;
+    maxentmc_quad_helper_kernel_t const kernel = qt->main_quadrature->kernel;
+    maxentmc_quad_helper_load_t const load = qt->main_quadrature->load;
+    size_t offset = 0;
+
+    maxentmc_quad_helper_thread_flush(qt);
+
+    while(offset<n){
+        size_t const count = (n-offset<qt->tile)?(n-offset):qt->tile;
+        load(qt,x,w,offset,count);
+        kernel(qt,maxentmc_quad_helper_thread_pad(qt,count));
+        offset += count;
     }
 
-    if(shift_rotate){
+    return 0;
+}
 
-        for(i=0;i<dim;++i){
-            maxentmc_index_t j;
-            for(j=0;j<2;++j)
-                x_pow[i*p1+1][j] = shift[i];
-            for(j=0;j<dim;++j){
-                x_pow[i*p1+1][0] += rotate[i*dim+j]*x1[j];
-                x_pow[i*p1+1][1] += rotate[i*dim+j]*x2[j];
-            }
-        }
+int maxentmc_quad_helper_thread_compute_1(struct maxentmc_quad_helper_thread_struct * const qt,
+                                          maxentmc_float_t const * const x1, maxentmc_float_t const w1)
+{
+    MAXENTMC_CHECK_NULL(qt);
+    MAXENTMC_CHECK_NULL(x1);
 
-    }
-    else
-        for(i=0;i<dim;++i){
-            x_pow[i*p1+1][0] = x1[i];
-            x_pow[i*p1+1][1] = x2[i];
-        }
+    if(maxentmc_quad_helper_thread_stale(qt))
+        return -1;
+
+    maxentmc_quad_helper_thread_push(qt,x1,w1);
+
+    return 0;
+}
 
+int maxentmc_quad_helper_thread_compute_2(struct maxentmc_quad_helper_thread_struct * const qt,
+                                          maxentmc_float_t const * const x1, maxentmc_float_t const w1,
+                                          maxentmc_float_t const * const x2, maxentmc_float_t const w2)
+{
+    MAXENTMC_CHECK_NULL(qt);
+    MAXENTMC_CHECK_NULL(x1);
+    MAXENTMC_CHECK_NULL(x2);
 
-    w[0] = w1;
-    w[1] = w2;
+    if(maxentmc_quad_helper_thread_stale(qt))
+        return -1;
 
-    MAXENTMC_QUADRATURE_THREAD_COMPUTE(2);
+    maxentmc_quad_helper_thread_push(qt,x1,w1);
+    maxentmc_quad_helper_thread_push(qt,x2,w2);
 
     return 0;
 }
@@ -689,51 +1434,12 @@ int maxentmc_quad_helper_thread_compute_3(struct maxentmc_quad_helper_thread_str
     MAXENTMC_CHECK_NULL(x2);
     MAXENTMC_CHECK_NULL(x3);
 
-    struct maxentmc_quad_helper_struct const * const q = qt->main_quadrature;
-    maxentmc_index_t const dim = q->multipliers->powers->dimension;
-    maxentmc_index_t const p1 = q->max_power+1;
-    maxentmc_index_t const shift_rotate = q->shift_rotate;
-    maxentmc_float_t const * const __restrict shift = q->shift;
-    maxentmc_float_t const * const __restrict rotate = q->rotate;
-
-    maxentmc_float_t x_pow[dim*p1][3];
-    maxentmc_float_t w[3];
-
-    size_t i;
-
-    for(i=0;i<dim;++i){
-        maxentmc_index_t j;
-        for(j=0;j<3;++j)
-            x_pow[i*p1][j] = 1.0;
-    }
-
-
-    if(shift_rotate){
-
-        for(i=0;i<dim;++i){
-            maxentmc_index_t j;
-            for(j=0;j<3;++j)
-                x_pow[i*p1+1][j] = shift[i];
-            for(j=0;j<dim;++j){
-                x_pow[i*p1+1][0] += rotate[i*dim+j]*x1[j];
-                x_pow[i*p1+1][1] += rotate[i*dim+j]*x2[j];
-                x_pow[i*p1+1][2] += rotate[i*dim+j]*x3[j];
-            }
-        }
-
-    }
-    else
-        for(i=0;i<dim;++i){
-            x_pow[i*p1+1][0] = x1[i];
-            x_pow[i*p1+1][1] = x2[i];
-            x_pow[i*p1+1][2] = x3[i];
-        }
-
-    w[0] = w1;
-    w[1] = w2;
-    w[2] = w3;
+    if(maxentmc_quad_helper_thread_stale(qt))
+        return -1;
 
-    MAXENTMC_QUADRATURE_THREAD_COMPUTE(3);
+    maxentmc_quad_helper_thread_push(qt,x1,w1);
+    maxentmc_quad_helper_thread_push(qt,x2,w2);
+    maxentmc_quad_helper_thread_push(qt,x3,w3);
 
     return 0;
 }
@@ -750,82 +1456,336 @@ int maxentmc_quad_helper_thread_compute_4(struct maxentmc_quad_helper_thread_str
     MAXENTMC_CHECK_NULL(x3);
     MAXENTMC_CHECK_NULL(x4);
 
-    struct maxentmc_quad_helper_struct const * const q = qt->main_quadrature;
-    maxentmc_index_t const dim = q->multipliers->powers->dimension;
-    maxentmc_index_t const p1 = q->max_power+1;
-    maxentmc_index_t const shift_rotate = q->shift_rotate;
-    maxentmc_float_t const * const __restrict shift = q->shift;
-    maxentmc_float_t const * const __restrict rotate = q->rotate;
+    if(maxentmc_quad_helper_thread_stale(qt))
+        return -1;
+
+    maxentmc_quad_helper_thread_push(qt,x1,w1);
+    maxentmc_quad_helper_thread_push(qt,x2,w2);
+    maxentmc_quad_helper_thread_push(qt,x3,w3);
+    maxentmc_quad_helper_thread_push(qt,x4,w4);
+
+    return 0;
+}
 
-    maxentmc_float_t x_pow[dim*p1][4];
-    maxentmc_float_t w[4];
+/** Adds sum[acc_size] to the armed moment sets, the caller holds the lock of the helper **/
 
+static void maxentmc_quad_helper_scatter_locked(struct maxentmc_quad_helper_struct * const q, maxentmc_float_t const * const sum)
+{
     size_t i;
+    maxentmc_index_t s;
 
-    for(i=0;i<dim;++i){
-        maxentmc_index_t j;
-        for(j=0;j<4;++j)
-            x_pow[i*p1][j] = 1.0;
+    for(s=0;s<q->n_sets;++s){
+        struct maxentmc_power_vector_struct * const moments = q->moments[s];
+        size_t const * const pos = q->plan->acc_pos[s];
+        for(i=0;i<moments->gsl_vec.size;++i)
+            moments->gsl_vec.data[i] += sum[pos[i]];
     }
+}
 
-    if(shift_rotate){
+/** Sums the lanes of the accumulators of qt, in a fixed order, with compensation if requested **/
 
-        for(i=0;i<dim;++i){
-            maxentmc_index_t j;
-            for(j=0;j<4;++j)
-                x_pow[i*p1+1][j] = shift[i];
-            for(j=0;j<dim;++j){
-                x_pow[i*p1+1][0] += rotate[i*dim+j]*x1[j];
-                x_pow[i*p1+1][1] += rotate[i*dim+j]*x2[j];
-                x_pow[i*p1+1][2] += rotate[i*dim+j]*x3[j];
-                x_pow[i*p1+1][3] += rotate[i*dim+j]*x4[j];
-            }
+static void maxentmc_quad_helper_thread_sum_lanes(struct maxentmc_quad_helper_thread_struct const * const qt, maxentmc_float_t * const sum,
+                                                  int const compensated)
+{
+    size_t const acc_size = qt->plan->acc_size;
+    size_t i;
+
+    for(i=0;i<acc_size;++i){
+        maxentmc_float_t const * const lanes = qt->moments + i*MAXENTMC_QUAD_THREAD_HOWMANY_AT_ONCE;
+        maxentmc_float_t a = 0.0, c = 0.0;
+        maxentmc_index_t k;
+        for(k=0;k<MAXENTMC_QUAD_THREAD_HOWMANY_AT_ONCE;++k){
+            maxentmc_float_t const t = a + lanes[k];
+            if(compensated)
+                c += (fabs(a) >= fabs(lanes[k]))?((a - t) + lanes[k]):((lanes[k] - t) + a);
+            a = t;
         }
+        sum[i] = a + c;
+    }
+}
+
+/** Adds the accumulators of qt to the armed moment sets, the caller holds the lock of the helper **/
 
+static int maxentmc_quad_helper_thread_merge_locked(struct maxentmc_quad_helper_thread_struct * const qt)
+{
+    if(!qt->main_quadrature->armed){
+        MAXENTMC_MESSAGE(stderr,"error: quad helper not armed");
+        return -1;
     }
-    else
-        for(i=0;i<dim;++i){
-            x_pow[i*p1+1][0] = x1[i];
-            x_pow[i*p1+1][1] = x2[i];
-            x_pow[i*p1+1][2] = x3[i];
-            x_pow[i*p1+1][3] = x4[i];
-        }
 
-    w[0] = w1;
-    w[1] = w2;
-    w[2] = w3;
-    w[3] = w4;
+    maxentmc_float_t sum[qt->plan->acc_size];
 
-    MAXENTMC_QUADRATURE_THREAD_COMPUTE(4);
+    maxentmc_quad_helper_thread_sum_lanes(qt,sum,0);
+
+    maxentmc_quad_helper_scatter_locked(qt->main_quadrature,sum);
 
     return 0;
 }
 
-
 int maxentmc_quad_helper_thread_merge(struct maxentmc_quad_helper_thread_struct * const qt)
 {
     MAXENTMC_CHECK_NULL(qt);
 
+    if(maxentmc_quad_helper_thread_stale(qt))
+        return -1;
+
+    maxentmc_quad_helper_thread_flush(qt);
+
+    struct maxentmc_quad_helper_struct * const q = qt->main_quadrature;
+
+    pthread_mutex_lock(&q->lock);
+
+    int const status = maxentmc_quad_helper_thread_merge_locked(qt);
+
+    /** The buffer goes to the spare list of the helper, the next pass takes it from there **/
+
+    if(!status){
+        if(qt->pass == q->pass)
+            --(q->live);
+        qt->next = q->spare;
+        q->spare = qt;
+    }
+
+    pthread_mutex_unlock(&q->lock);
+
+    return status;
+}
+
+int maxentmc_quad_helper_thread_merge_reset(struct maxentmc_quad_helper_thread_struct * const qt)
+{
+    MAXENTMC_CHECK_NULL(qt);
+
+    if(maxentmc_quad_helper_thread_stale(qt))
+        return -1;
+
+    maxentmc_quad_helper_thread_flush(qt);
+
     pthread_mutex_lock(&qt->main_quadrature->lock);
 
-    if(!qt->main_quadrature->armed){
-        pthread_mutex_unlock(&qt->main_quadrature->lock);
+    int const status = maxentmc_quad_helper_thread_merge_locked(qt);
+
+    pthread_mutex_unlock(&qt->main_quadrature->lock);
+
+    if(!status)
+        memset(qt->moments,0,sizeof(maxentmc_float_t)*qt->plan->acc_size*MAXENTMC_QUAD_THREAD_HOWMANY_AT_ONCE);
+
+    return status;
+}
+
+int maxentmc_quad_helper_reduce_begin(struct maxentmc_quad_helper_struct * const q, size_t const num_threads)
+{
+    MAXENTMC_CHECK_NULL(q);
+
+    if(!q->armed){
         MAXENTMC_MESSAGE(stderr,"error: quad helper not armed");
         return -1;
     }
 
-    size_t i;
+    if(num_threads == 0){
+        MAXENTMC_MESSAGE(stderr,"error: zero number of threads");
+        return -1;
+    }
 
-    for(i=0;i<qt->main_quadrature->moments->gsl_vec.size;++i)
-        qt->main_quadrature->moments->gsl_vec.data[i] += qt->moments[i];
+    if(num_threads > q->reduce_capacity){
+        /** The three arrays share one allocation, the atomic counters go last **/
+        void * const temp = malloc((2*sizeof(struct maxentmc_quad_helper_thread_struct *)+sizeof(atomic_uint))*num_threads);
+        if(temp == NULL){
+            MAXENTMC_MESSAGE(stderr,"error: insufficient memory");
+            return -1;
+        }
+        free(q->reduce_thread);
+        q->reduce_thread = temp;
+        q->reduce_partial = q->reduce_thread + num_threads;
+        q->reduce_node = (atomic_uint *)(q->reduce_partial + num_threads);
+        q->reduce_capacity = num_threads;
+    }
 
-    free(qt);
+    size_t t;
 
-    pthread_mutex_unlock(&qt->main_quadrature->lock);
+    for(t=0;t<num_threads;++t){
+        q->reduce_thread[t] = NULL;
+        q->reduce_partial[t] = NULL;
+        atomic_init(q->reduce_node+t,0);
+    }
+
+    q->reduce_size = num_threads;
+
+    return 0;
+}
+
+int maxentmc_quad_helper_reduce_blocks(struct maxentmc_quad_helper_struct * const q, size_t const num_blocks)
+{
+    MAXENTMC_CHECK_NULL(q);
+
+    if(q->reduce_size == 0){
+        MAXENTMC_MESSAGE(stderr,"error: reduction not started");
+        return -1;
+    }
+
+    size_t const size = num_blocks*q->plan->acc_size;
+
+    if(size > q->reduce_blocks_capacity){
+        maxentmc_float_t * const temp = malloc(sizeof(maxentmc_float_t)*size);
+        if(temp == NULL){
+            MAXENTMC_MESSAGE(stderr,"error: insufficient memory");
+            return -1;
+        }
+        free(q->reduce_block_sums);
+        q->reduce_block_sums = temp;
+        q->reduce_blocks_capacity = size;
+    }
+
+    /** A block nobody deposits into contributes nothing **/
+
+    memset(q->reduce_block_sums,0,sizeof(maxentmc_float_t)*size);
+
+    q->reduce_blocks = num_blocks;
+
+    return 0;
+}
+
+int maxentmc_quad_helper_thread_deposit(struct maxentmc_quad_helper_thread_struct * const qt, size_t const block)
+{
+    MAXENTMC_CHECK_NULL(qt);
+
+    struct maxentmc_quad_helper_struct * const q = qt->main_quadrature;
+
+    if(block >= q->reduce_blocks){
+        MAXENTMC_MESSAGE(stderr,"error: block exceeds the number of blocks of the reduction");
+        return -1;
+    }
+
+    if(maxentmc_quad_helper_thread_stale(qt))
+        return -1;
+
+    maxentmc_quad_helper_thread_flush(qt);
+
+    size_t const acc_size = qt->plan->acc_size;
+
+    maxentmc_quad_helper_thread_sum_lanes(qt,q->reduce_block_sums+block*acc_size,
+                                          q->reduction_mode == MAXENTMC_QUAD_HELPER_REDUCTION_COMPENSATED);
+
+    memset(qt->moments,0,sizeof(maxentmc_float_t)*acc_size*MAXENTMC_QUAD_THREAD_HOWMANY_AT_ONCE);
 
     return 0;
 }
 
+static void maxentmc_quad_helper_thread_add(struct maxentmc_quad_helper_thread_struct * const qt,
+                                            struct maxentmc_quad_helper_thread_struct const * const other)
+{
+    size_t const n = qt->plan->acc_size*MAXENTMC_QUAD_THREAD_HOWMANY_AT_ONCE;
+    maxentmc_float_t * const restrict a = qt->moments;
+    maxentmc_float_t const * const restrict b = other->moments;
+    size_t i;
+
+    for(i=0;i<n;++i)
+        a[i] += b[i];
+}
+
+int maxentmc_quad_helper_reduce(struct maxentmc_quad_helper_struct * const q, struct maxentmc_quad_helper_thread_struct * const qt,
+                                size_t const index)
+{
+    MAXENTMC_CHECK_NULL(q);
+
+    if(index >= q->reduce_size){
+        MAXENTMC_MESSAGE(stderr,"error: index exceeds the number of threads of the reduction");
+        return -1;
+    }
+
+    if(qt && (qt->main_quadrature != q)){
+        MAXENTMC_MESSAGE(stderr,"error: accumulator belongs to another quad helper");
+        return -1;
+    }
+
+    /** Participants are the leaves of a binary tree, the node at level l joins the subtrees rooted at p and c = p+2^l,
+        with p a multiple of 2^(l+1). Whoever arrives at a node second adds the partial sum of the other subtree into its
+        own and goes up, the first one leaves. Nobody waits, and since the shape of the tree is fixed, so is the order of
+        the additions. **/
+
+    struct maxentmc_quad_helper_thread_struct * mine = qt;
+    size_t const n = q->reduce_size;
+    size_t step;
+    int status = 0;
+
+    q->reduce_thread[index] = qt;
+
+    /** An accumulator laid out for another plan still joins the tree, without its sums, so that the others are not lost **/
+
+    if(qt){
+        if(maxentmc_quad_helper_thread_stale(qt)){
+            mine = NULL;
+            status = -1;
+        }
+        else
+            maxentmc_quad_helper_thread_flush(qt);
+    }
+
+    for(step=1;step<n;step<<=1){
+        size_t const p = index & ~(2*step-1);
+        size_t const c = p + step;
+        if(c >= n)
+            continue;
+        size_t const side = (index < c)?p:c;
+        q->reduce_partial[side] = mine;
+        if(atomic_fetch_add_explicit(q->reduce_node+c,1,memory_order_acq_rel) == 0)
+            return status;
+        struct maxentmc_quad_helper_thread_struct * const other = q->reduce_partial[(side == p)?c:p];
+        if(mine == NULL)
+            mine = other;
+        else if(other && (q->reduce_blocks == 0))
+            maxentmc_quad_helper_thread_add(mine,other);
+    }
+
+    /** The root: the only thread left in this pass, so it writes the moments and hands the buffers back to the helper **/
+
+    pthread_mutex_lock(&q->lock);
+
+    if(q->reduce_blocks){
+        /** Deposited blocks are summed in block order, independently of which thread computed them **/
+        if(q->armed){
+            size_t const acc_size = q->plan->acc_size;
+            int const compensated = (q->reduction_mode == MAXENTMC_QUAD_HELPER_REDUCTION_COMPENSATED);
+            maxentmc_float_t sum[acc_size];
+            size_t i, b;
+            for(i=0;i<acc_size;++i){
+                maxentmc_float_t a = 0.0, c = 0.0;
+                for(b=0;b<q->reduce_blocks;++b){
+                    maxentmc_float_t const x = q->reduce_block_sums[b*acc_size+i];
+                    maxentmc_float_t const t = a + x;
+                    if(compensated)
+                        c += (fabs(a) >= fabs(x))?((a - t) + x):((x - t) + a);
+                    a = t;
+                }
+                sum[i] = a + c;
+            }
+            maxentmc_quad_helper_scatter_locked(q,sum);
+        }
+        else{
+            MAXENTMC_MESSAGE(stderr,"error: quad helper not armed");
+            status = -1;
+        }
+        q->reduce_blocks = 0;
+    }
+    else if(mine && maxentmc_quad_helper_thread_merge_locked(mine))
+        status = -1;
+
+    size_t t;
+
+    for(t=0;t<n;++t)
+        if(q->reduce_thread[t]){
+            if(q->reduce_thread[t]->pass == q->pass)
+                --(q->live);
+            q->reduce_thread[t]->next = q->spare;
+            q->spare = q->reduce_thread[t];
+        }
+
+    q->reduce_size = 0;
+
+    pthread_mutex_unlock(&q->lock);
+
+    return status;
+}
+
 int maxentmc_quad_helper_get_moments(struct maxentmc_quad_helper_struct * const q, struct maxentmc_power_vector_struct * const moments)
 {
     MAXENTMC_CHECK_NULL(q);
@@ -839,21 +1799,61 @@ int maxentmc_quad_helper_get_moments(struct maxentmc_quad_helper_struct * const
         return -1;
     }
 
-    if(q->moments->powers != moments->powers){
-        pthread_mutex_unlock(&q->lock);
-        MAXENTMC_MESSAGE(stderr,"error: powers do not match");
-        return -1;
+    size_t const stride = moments->gsl_vec.stride;
+    size_t i;
+    maxentmc_index_t s = 0;
+
+#ifdef MAXENTMC_MPI
+    /** Collective: every rank extracts the moments of a pass **/
+    if((q->num_ranks > 1) && !q->ranks_reduced){
+        for(s=0;s<q->n_sets;++s)
+            MPI_Allreduce(MPI_IN_PLACE,q->moments[s]->gsl_vec.data,(int)q->moments[s]->gsl_vec.size,
+                          (sizeof(maxentmc_float_t) == sizeof(double))?MPI_DOUBLE:MPI_FLOAT,MPI_SUM,q->comm);
+        q->ranks_reduced = 1;
+        s = 0;
     }
+#endif
 
+    while((s<q->n_sets) && (q->moments[s]->powers != moments->powers))
+        ++s;
+
+    if(s<q->n_sets){
 /*
-    memcpy(moments->gsl_vec.data,q->moments->gsl_vec.data,sizeof(maxentmc_float_t)*moments->gsl_vec.size);
+        memcpy(moments->gsl_vec.data,q->moments[s]->gsl_vec.data,sizeof(maxentmc_float_t)*moments->gsl_vec.size);
 */
-    size_t const stride = moments->gsl_vec.stride;
-    size_t i;
-    for(i=0;i<moments->gsl_vec.size;++i)
-        moments->gsl_vec.data[i*stride] = q->moments->gsl_vec.data[i];
+        for(i=0;i<moments->gsl_vec.size;++i)
+            moments->gsl_vec.data[i*stride] = q->moments[s]->gsl_vec.data[i];
+    }
+    else{
+        /** Extracting a subset of the computed moments (e.g. gradient moments out of the Hessian moments) **/
+        if(moments->powers->dimension != q->dimension){
+            pthread_mutex_unlock(&q->lock);
+            MAXENTMC_MESSAGE(stderr,"error: powers do not match");
+            return -1;
+        }
+        maxentmc_index_t p[q->dimension];
+        size_t pos[moments->gsl_vec.size];
+        s = 0;
+        do{
+            i = 0;
+            while((i<moments->gsl_vec.size) && !maxentmc_power_get_power(moments->powers,i,p)
+                  && !maxentmc_power_find(q->moments[s]->powers,p,pos+i))
+                ++i;
+        }while((i<moments->gsl_vec.size) && (++s<q->n_sets));
+        if(s == q->n_sets){
+            pthread_mutex_unlock(&q->lock);
+            MAXENTMC_MESSAGE(stderr,"error: powers are not contained in the computed moments");
+            return -1;
+        }
+        for(i=0;i<moments->gsl_vec.size;++i)
+            moments->gsl_vec.data[i*stride] = q->moments[s]->gsl_vec.data[pos[i]];
+    }
 
-    q->armed = 0;
+    /** The helper stays armed until every moment set has been extracted **/
+
+    q->collected |= 1u<<s;
+    if(q->collected == (1u<<q->n_sets)-1)
+        q->armed = 0;
 
     pthread_mutex_unlock(&q->lock);
 
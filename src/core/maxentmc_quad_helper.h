@@ -16,25 +16,101 @@
 #define MAXENTMC_QUAD_HELPER_H_INCLUDED
 
 #include <pthread.h>
+#include <stdatomic.h>
+#ifdef MAXENTMC_MPI
+#include <mpi.h>
+#endif
 #include "maxentmc_vector.h"
+#include "maxentmc_quad_plan.h"
+#include "maxentmc_thread_pool.h"
 
 #define MAXENTMC_QUAD_THREAD_HOWMANY_AT_ONCE 8
 
+/** Points are processed in tiles of up to MAXENTMC_QUAD_THREAD_MAX_TILE points (a multiple of MAXENTMC_QUAD_THREAD_HOWMANY_AT_ONCE),
+    sized so that the monomials of the tile take a fraction of the L2 cache **/
+
+#define MAXENTMC_QUAD_THREAD_MAX_TILE 256
+
 struct maxentmc_quad_helper_power_list_struct {
     struct maxentmc_power_vector_struct * power_vector;
     struct maxentmc_quad_helper_power_list_struct * next;
 };
 
+/** Several moment sets can be armed at once, all of them are computed in the same sweep over the quadrature points **/
+
+#define MAXENTMC_QUAD_HELPER_MAX_MOMENT_SETS 8
+
+/** Monomial plans are built for multiplier powers together with the armed moment powers, so that the moment monomials
+    reuse the multiplier ones, and monomials shared by several moment sets are accumulated only once **/
+
+struct maxentmc_quad_helper_plan_list_struct {
+    struct maxentmc_power_struct const * multiplier_powers, * moment_powers[MAXENTMC_QUAD_HELPER_MAX_MOMENT_SETS];
+    maxentmc_index_t num_sets;
+    struct maxentmc_quad_plan_struct * plan; /** index[0] for multipliers, index[1+s] for moment set s **/
+    size_t acc_size;
+    size_t * acc_index; /** [acc_size], distinct monomials of all moment sets, accumulated against the density **/
+    size_t * acc_pos[MAXENTMC_QUAD_HELPER_MAX_MOMENT_SETS]; /** [num_sets][size of the set], position of each moment among acc_index **/
+    struct maxentmc_quad_helper_plan_list_struct * next;
+};
+
+struct maxentmc_quad_helper_thread_struct;
+
+typedef void (*maxentmc_quad_helper_kernel_t)(struct maxentmc_quad_helper_thread_struct * const, size_t const);
+
+typedef void (*maxentmc_quad_helper_load_t)(struct maxentmc_quad_helper_thread_struct * const,
+                                            maxentmc_float_t const * const * const, maxentmc_float_t const * const,
+                                            size_t const, size_t const);
+
 struct maxentmc_quad_helper_struct {
 
-    maxentmc_index_t dimension, max_power, shift_rotate, armed;
-    maxentmc_index_t n_mult, n_mom;
+    maxentmc_index_t dimension, shift_rotate, armed;
+    maxentmc_index_t n_mult, n_mom, n_sets;
+    unsigned int collected; /** bit s is set once moment set s has been extracted, the helper is disarmed when all are **/
+    size_t pass, live; /** pass counts the arming calls, live the accumulators allocated in the current pass and not yet merged **/
     maxentmc_float_t scale, * shift, * rotate;
 
-    struct maxentmc_power_vector_struct * multipliers, * moments;
+    struct maxentmc_power_vector_struct * multipliers, * moments[MAXENTMC_QUAD_HELPER_MAX_MOMENT_SETS];
+
+    struct maxentmc_quad_helper_plan_list_struct * plan;
 
     struct maxentmc_quad_helper_power_list_struct * multiplier_list, * moment_list;
 
+    struct maxentmc_quad_helper_plan_list_struct * plan_list;
+
+    enum MAXENTMC_QUAD_HELPER_EXP_MODE exp_mode;
+
+    maxentmc_quad_helper_kernel_t kernel; /** tile kernel for the instruction set of the running processor **/
+
+    maxentmc_quad_helper_load_t load; /** point loader, specialized for the dimension when armed **/
+
+    struct maxentmc_thread_pool_struct * pool; /** used by the quadrature drivers, not owned **/
+
+    struct maxentmc_quad_helper_thread_struct * spare; /** merged thread accumulators, reused by the next pass **/
+
+    /** Tree reduction of the accumulators of one pass: participant t owns reduce_thread[t], the sum over the subtree
+        rooted at t is passed through reduce_partial[t], and reduce_node[c] counts the arrivals at the node whose
+        right child is c **/
+
+    size_t reduce_size, reduce_capacity;
+    struct maxentmc_quad_helper_thread_struct ** reduce_thread, ** reduce_partial;
+    atomic_uint * reduce_node;
+
+    /** In the deterministic reduction modes the accumulators are deposited per block of a fixed partition of the points,
+        and the blocks are summed in order at the root of the reduction **/
+
+    enum MAXENTMC_QUAD_HELPER_REDUCTION_MODE reduction_mode;
+    size_t reduce_blocks, reduce_blocks_capacity;
+    maxentmc_float_t * reduce_block_sums; /** [reduce_blocks][acc_size of the plan] **/
+
+    /** With several MPI ranks, every rank computes its share of the points, and the armed moments are summed over the
+        ranks once, by the first maxentmc_quad_helper_get_moments after the pass **/
+
+    int rank, num_ranks, ranks_reduced;
+
+#ifdef MAXENTMC_MPI
+    MPI_Comm comm;
+#endif
+
     pthread_mutex_t lock;
 
 };
@@ -42,8 +118,18 @@ struct maxentmc_quad_helper_struct {
 struct maxentmc_quad_helper_thread_struct {
 
     struct maxentmc_quad_helper_struct * main_quadrature;
-    maxentmc_float_t * moments;
-    maxentmc_float_t * scratch;
+    struct maxentmc_quad_helper_thread_struct * next; /** in the spare list of the helper **/
+    struct maxentmc_quad_helper_plan_list_struct const * plan; /** plan the accumulator is laid out for **/
+    size_t pass;                  /** pass of the helper the accumulator is counted in **/
+    int node;                     /** NUMA node the buffer was allocated on, -1 if unknown **/
+    size_t capacity;              /** bytes allocated, including this header **/
+    size_t tile;                  /** number of points in a tile **/
+    size_t pending;               /** single points loaded into the tile and not yet computed **/
+    maxentmc_float_t * moments;   /** [acc_size of the plan][MAXENTMC_QUAD_THREAD_HOWMANY_AT_ONCE], one accumulator per lane **/
+    maxentmc_float_t * monomials; /** [plan size][tile] **/
+    maxentmc_float_t * x;         /** [dimension][tile], shifted and rotated abscissas **/
+    maxentmc_float_t * w;         /** [tile] **/
+    maxentmc_float_t * rho;       /** [tile], the polynomial under the exponent, then the density **/
 
 };
 
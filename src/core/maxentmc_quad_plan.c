@@ -0,0 +1,262 @@
+/** This file is part of MaxEntMC, a maximum entropy algorithm with moment constraints. **/
+/** Copyright (C) 2014 Rafail V. Abramov.                                               **/
+/**                                                                                     **/
+/** This program is free software: you can redistribute it and/or modify it under the   **/
+/** terms of the GNU General Public License as published by the Free Software           **/
+/** Foundation, either version 3 of the License, or (at your option) any later version. **/
+/**                                                                                     **/
+/** This program is distributed in the hope that it will be useful, but WITHOUT ANY     **/
+/** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     **/
+/** PARTICULAR PURPOSE.  See the GNU General Public License for more details.           **/
+/**                                                                                     **/
+/** You should have received a copy of the GNU General Public License along with this   **/
+/** program.  If not, see <http://www.gnu.org/licenses/>.                               **/
+
+#include <string.h>
+#include "maxentmc_quad_plan.h"
+
+/** Monomials collected while a plan is built, hashed by their powers (open addressing with linear probing) **/
+
+struct maxentmc_quad_plan_builder_struct {
+
+    maxentmc_index_t dimension;
+    size_t size, capacity, table_size;
+    maxentmc_index_t * power;   /** [capacity][dimension] **/
+    size_t * parent;            /** [capacity] **/
+    maxentmc_index_t * coord;   /** [capacity] **/
+    size_t * table;             /** [table_size], positions of monomials, MAXENTMC_QUAD_PLAN_NONE when empty **/
+
+};
+
+static size_t maxentmc_quad_plan_hash(maxentmc_index_t const dim, maxentmc_index_t const * const p)
+{
+    uint64_t h = 14695981039346656037ULL;
+    maxentmc_index_t i;
+    for(i=0;i<dim;++i){
+        h ^= p[i];
+        h *= 1099511628211ULL;
+    }
+    return (size_t)h;
+}
+
+static size_t maxentmc_quad_plan_lookup(struct maxentmc_quad_plan_builder_struct const * const b, maxentmc_index_t const * const p)
+{
+    size_t const mask = b->table_size-1;
+    size_t h = maxentmc_quad_plan_hash(b->dimension,p) & mask;
+
+    while(b->table[h] != MAXENTMC_QUAD_PLAN_NONE){
+        if(!memcmp(b->power+b->table[h]*b->dimension,p,sizeof(maxentmc_index_t)*b->dimension))
+            return b->table[h];
+        h = (h+1) & mask;
+    }
+
+    return MAXENTMC_QUAD_PLAN_NONE;
+}
+
+static size_t maxentmc_quad_plan_insert(struct maxentmc_quad_plan_builder_struct * const b, maxentmc_index_t const * const p,
+                                        size_t const parent, maxentmc_index_t const coord)
+{
+    maxentmc_index_t const dim = b->dimension;
+    size_t i;
+
+    if(b->size == b->capacity){
+        size_t const capacity = 2*b->capacity;
+        maxentmc_index_t * const power = realloc(b->power,sizeof(maxentmc_index_t)*capacity*dim);
+        if(power == NULL){
+            MAXENTMC_MESSAGE(stderr,"error: insufficient memory");
+            return MAXENTMC_QUAD_PLAN_NONE;
+        }
+        b->power = power;
+        size_t * const parents = realloc(b->parent,sizeof(size_t)*capacity);
+        if(parents == NULL){
+            MAXENTMC_MESSAGE(stderr,"error: insufficient memory");
+            return MAXENTMC_QUAD_PLAN_NONE;
+        }
+        b->parent = parents;
+        maxentmc_index_t * const coords = realloc(b->coord,sizeof(maxentmc_index_t)*capacity);
+        if(coords == NULL){
+            MAXENTMC_MESSAGE(stderr,"error: insufficient memory");
+            return MAXENTMC_QUAD_PLAN_NONE;
+        }
+        b->coord = coords;
+        b->capacity = capacity;
+    }
+
+    /** Keep the table at most half full **/
+
+    if(2*(b->size+1) > b->table_size){
+        size_t const table_size = 2*b->table_size;
+        size_t * const table = malloc(sizeof(size_t)*table_size);
+        if(table == NULL){
+            MAXENTMC_MESSAGE(stderr,"error: insufficient memory");
+            return MAXENTMC_QUAD_PLAN_NONE;
+        }
+        for(i=0;i<table_size;++i)
+            table[i] = MAXENTMC_QUAD_PLAN_NONE;
+        for(i=0;i<b->size;++i){
+            size_t h = maxentmc_quad_plan_hash(dim,b->power+i*dim) & (table_size-1);
+            while(table[h] != MAXENTMC_QUAD_PLAN_NONE)
+                h = (h+1) & (table_size-1);
+            table[h] = i;
+        }
+        free(b->table);
+        b->table = table;
+        b->table_size = table_size;
+    }
+
+    size_t h = maxentmc_quad_plan_hash(dim,p) & (b->table_size-1);
+    while(b->table[h] != MAXENTMC_QUAD_PLAN_NONE)
+        h = (h+1) & (b->table_size-1);
+
+    b->table[h] = b->size;
+    memcpy(b->power+b->size*dim,p,sizeof(maxentmc_index_t)*dim);
+    b->parent[b->size] = parent;
+    b->coord[b->size] = coord;
+
+    return (b->size)++;
+}
+
+/** Position of the monomial p (modified during the call, but restored on return), adding it and any missing predecessors.
+    A predecessor which is already there is preferred, otherwise the chain continues along the last nonzero coordinate. **/
+
+static size_t maxentmc_quad_plan_monomial(struct maxentmc_quad_plan_builder_struct * const b, maxentmc_index_t * const p)
+{
+    size_t pos = maxentmc_quad_plan_lookup(b,p);
+
+    if(pos != MAXENTMC_QUAD_PLAN_NONE)
+        return pos;
+
+    maxentmc_index_t j, last = 0;
+
+    for(j=0;j<b->dimension;++j)
+        if(p[j]){
+            last = j;
+            --p[j];
+            pos = maxentmc_quad_plan_lookup(b,p);
+            ++p[j];
+            if(pos != MAXENTMC_QUAD_PLAN_NONE)
+                return maxentmc_quad_plan_insert(b,p,pos,j);
+        }
+
+    --p[last];
+    pos = maxentmc_quad_plan_monomial(b,p);
+    ++p[last];
+
+    if(pos == MAXENTMC_QUAD_PLAN_NONE)
+        return MAXENTMC_QUAD_PLAN_NONE;
+
+    return maxentmc_quad_plan_insert(b,p,pos,last);
+}
+
+/** Collects the monomials of all sets and copies the result into a single block **/
+
+static struct maxentmc_quad_plan_struct * maxentmc_quad_plan_build(struct maxentmc_quad_plan_builder_struct * const b, size_t const num_sets,
+                                                                   struct maxentmc_power_struct const * const * const powers,
+                                                                   size_t const total, size_t * const index)
+{
+    maxentmc_index_t const dim = b->dimension;
+    maxentmc_index_t p[dim];
+    size_t s, i, k = 0;
+
+    /** The constant monomial comes first **/
+
+    memset(p,0,sizeof(maxentmc_index_t)*dim);
+
+    if(maxentmc_quad_plan_insert(b,p,0,0) == MAXENTMC_QUAD_PLAN_NONE)
+        return NULL;
+
+    for(s=0;s<num_sets;++s)
+        for(i=0;i<powers[s]->size;++i){
+            memcpy(p,powers[s]->power[i],sizeof(maxentmc_index_t)*dim);
+            index[k] = maxentmc_quad_plan_monomial(b,p);
+            if(index[k] == MAXENTMC_QUAD_PLAN_NONE)
+                return NULL;
+            ++k;
+        }
+
+    size_t const header_size = MAXENTMC_ALIGNED_SIZE(sizeof(size_t),sizeof(struct maxentmc_quad_plan_struct)+sizeof(size_t *)*num_sets);
+    size_t const data_size = sizeof(size_t)*(b->size+total);
+    int status;
+
+    struct maxentmc_quad_plan_struct * plan;
+
+    MAXENTMC_ALLOC(plan,header_size+data_size+sizeof(maxentmc_index_t)*b->size,status);
+
+    if(status)
+        return NULL;
+
+    plan->size = b->size;
+    plan->num_sets = num_sets;
+    plan->index = MAXENTMC_INCREMENT_POINTER(plan,sizeof(struct maxentmc_quad_plan_struct));
+    plan->parent = MAXENTMC_INCREMENT_POINTER(plan,header_size);
+    plan->coord = MAXENTMC_INCREMENT_POINTER(plan,header_size+data_size);
+
+    memcpy(plan->parent,b->parent,sizeof(size_t)*b->size);
+    memcpy(plan->coord,b->coord,sizeof(maxentmc_index_t)*b->size);
+
+    plan->index[0] = plan->parent + b->size;
+    for(s=1;s<num_sets;++s)
+        plan->index[s] = plan->index[s-1] + powers[s-1]->size;
+    memcpy(plan->index[0],index,sizeof(size_t)*total);
+
+    return plan;
+}
+
+struct maxentmc_quad_plan_struct * maxentmc_quad_plan_alloc(size_t const num_sets, struct maxentmc_power_struct const * const * const powers)
+{
+    MAXENTMC_CHECK_NULL_PT(powers);
+
+    if(num_sets == 0){
+        MAXENTMC_MESSAGE(stderr,"error: no power sets provided");
+        return NULL;
+    }
+
+    size_t s, i, total = 0;
+
+    for(s=0;s<num_sets;++s){
+        MAXENTMC_CHECK_NULL_PT(powers[s]);
+        if(powers[s]->dimension != powers[0]->dimension){
+            MAXENTMC_MESSAGE(stderr,"error: dimensions do not match");
+            return NULL;
+        }
+        total += powers[s]->size;
+    }
+
+    struct maxentmc_quad_plan_builder_struct b;
+
+    b.dimension = powers[0]->dimension;
+    b.size = 0;
+    b.capacity = total+1;
+    b.table_size = 1;
+    while(b.table_size < 2*b.capacity)
+        b.table_size *= 2;
+    b.power = malloc(sizeof(maxentmc_index_t)*b.capacity*b.dimension);
+    b.parent = malloc(sizeof(size_t)*b.capacity);
+    b.coord = malloc(sizeof(maxentmc_index_t)*b.capacity);
+    b.table = malloc(sizeof(size_t)*b.table_size);
+
+    size_t * const index = malloc(sizeof(size_t)*total);
+
+    struct maxentmc_quad_plan_struct * plan = NULL;
+
+    if(b.power && b.parent && b.coord && b.table && index){
+        for(i=0;i<b.table_size;++i)
+            b.table[i] = MAXENTMC_QUAD_PLAN_NONE;
+        plan = maxentmc_quad_plan_build(&b,num_sets,powers,total,index);
+    }
+    else
+        MAXENTMC_MESSAGE(stderr,"error: insufficient memory");
+
+    free(b.power);
+    free(b.parent);
+    free(b.coord);
+    free(b.table);
+    free(index);
+
+    return plan;
+}
+
+void maxentmc_quad_plan_free(struct maxentmc_quad_plan_struct * const plan)
+{
+    free(plan);
+}
@@ -0,0 +1,40 @@
+/** This file is part of MaxEntMC, a maximum entropy algorithm with moment constraints. **/
+/** Copyright (C) 2014 Rafail V. Abramov.                                               **/
+/**                                                                                     **/
+/** This program is free software: you can redistribute it and/or modify it under the   **/
+/** terms of the GNU General Public License as published by the Free Software           **/
+/** Foundation, either version 3 of the License, or (at your option) any later version. **/
+/**                                                                                     **/
+/** This program is distributed in the hope that it will be useful, but WITHOUT ANY     **/
+/** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     **/
+/** PARTICULAR PURPOSE.  See the GNU General Public License for more details.           **/
+/**                                                                                     **/
+/** You should have received a copy of the GNU General Public License along with this   **/
+/** program.  If not, see <http://www.gnu.org/licenses/>.                               **/
+
+#ifndef MAXENTMC_QUAD_PLAN_H_INCLUDED
+#define MAXENTMC_QUAD_PLAN_H_INCLUDED
+
+#include "maxentmc_power.h"
+
+#define MAXENTMC_QUAD_PLAN_NONE ((size_t)(-1))
+
+/** Evaluation plan for the monomials of one or several power sets. Monomial 0 is the constant 1, and every
+    monomial k>0 is monomial parent[k] times coordinate coord[k], with parent[k] < k, so that the monomials can be
+    evaluated in order with one multiplication each. Monomials which are not in any of the sets, but are needed
+    as intermediate steps, are included too. **/
+
+struct maxentmc_quad_plan_struct {
+
+    size_t size, num_sets;
+    size_t * parent;            /** [size] **/
+    maxentmc_index_t * coord;   /** [size] **/
+    size_t ** index;            /** [num_sets][size of the set], position of each power of the set among the monomials **/
+
+};
+
+struct maxentmc_quad_plan_struct * maxentmc_quad_plan_alloc(size_t const num_sets, struct maxentmc_power_struct const * const * const powers);
+
+void maxentmc_quad_plan_free(struct maxentmc_quad_plan_struct * const plan);
+
+#endif // MAXENTMC_QUAD_PLAN_H_INCLUDED
@@ -0,0 +1,222 @@
+/** This file is part of MaxEntMC, a maximum entropy algorithm with moment constraints. **/
+/** Copyright (C) 2014 Rafail V. Abramov.                                               **/
+/**                                                                                     **/
+/** This program is free software: you can redistribute it and/or modify it under the   **/
+/** terms of the GNU General Public License as published by the Free Software           **/
+/** Foundation, either version 3 of the License, or (at your option) any later version. **/
+/**                                                                                     **/
+/** This program is distributed in the hope that it will be useful, but WITHOUT ANY     **/
+/** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     **/
+/** PARTICULAR PURPOSE.  See the GNU General Public License for more details.           **/
+/**                                                                                     **/
+/** You should have received a copy of the GNU General Public License along with this   **/
+/** program.  If not, see <http://www.gnu.org/licenses/>.                               **/
+
+#ifndef MAXENTMC_SIMD_H_INCLUDED
+#define MAXENTMC_SIMD_H_INCLUDED
+
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include "../user/maxentmc.h"
+#include "maxentmc_defs.h"
+
+/** Vector operations for the quadrature kernels. Every instruction set is described by the same
+    set of macros, MAXENTMC_SIMD_<ISA>_<OPERATION>, so that a kernel written in terms of them can be
+    instantiated for any of the sets by token pasting. All loads and stores are aligned.
+    MAXENTMC_SIMD_<ISA>_TARGET is the function attribute that lets the compiler emit the
+    instructions regardless of the build flags; the set actually used is chosen at run time
+    (maxentmc_cpu_isa), so one build serves every processor of the family. **/
+
+/** Scalar fallback, always available **/
+
+#define MAXENTMC_SIMD_SCALAR_WIDTH 1
+#define MAXENTMC_SIMD_SCALAR_TARGET
+#define MAXENTMC_SIMD_SCALAR_T maxentmc_float_t
+#define MAXENTMC_SIMD_SCALAR_LOAD(_p_) (*(_p_))
+#define MAXENTMC_SIMD_SCALAR_STORE(_p_,_a_) (*(_p_) = (_a_))
+#define MAXENTMC_SIMD_SCALAR_SET1(_a_) ((maxentmc_float_t)(_a_))
+#define MAXENTMC_SIMD_SCALAR_ZERO() ((maxentmc_float_t)0)
+#define MAXENTMC_SIMD_SCALAR_ADD(_a_,_b_) ((_a_)+(_b_))
+#define MAXENTMC_SIMD_SCALAR_SUB(_a_,_b_) ((_a_)-(_b_))
+#define MAXENTMC_SIMD_SCALAR_MUL(_a_,_b_) ((_a_)*(_b_))
+#define MAXENTMC_SIMD_SCALAR_FMADD(_a_,_b_,_c_) ((_a_)*(_b_)+(_c_))
+#define MAXENTMC_SIMD_SCALAR_MIN(_a_,_b_) (((_a_)<(_b_))?(_a_):(_b_))
+#define MAXENTMC_SIMD_SCALAR_MAX(_a_,_b_) (((_a_)>(_b_))?(_a_):(_b_))
+#define MAXENTMC_SIMD_SCALAR_SHL52(_a_) maxentmc_simd_scalar_shl52(_a_)
+
+#ifndef MAXENTMC_SINGLE_PRECISION
+static inline maxentmc_float_t maxentmc_simd_scalar_shl52(maxentmc_float_t const a)
+{
+    uint64_t i;
+    maxentmc_float_t b;
+    memcpy(&i,&a,sizeof(i));
+    i <<= 52;
+    memcpy(&b,&i,sizeof(b));
+    return b;
+}
+#endif
+
+#ifndef MAXENTMC_SINGLE_PRECISION
+
+#if defined(__x86_64__) || defined(__i386__)
+
+#include <immintrin.h>
+
+/** SSE2, 2 doubles. There is no fused multiply-add before AVX2, so FMADD is a multiply and an add, rounded twice
+    (as in the scalar code): the SSE2 kernel rounds differently from the AVX2, AVX-512 and NEON kernels in the last bits **/
+
+#define MAXENTMC_SIMD_SSE2_WIDTH 2
+#define MAXENTMC_SIMD_SSE2_TARGET __attribute__((target("sse2")))
+#define MAXENTMC_SIMD_SSE2_T __m128d
+#define MAXENTMC_SIMD_SSE2_LOAD(_p_) _mm_load_pd(_p_)
+#define MAXENTMC_SIMD_SSE2_STORE(_p_,_a_) _mm_store_pd((_p_),(_a_))
+#define MAXENTMC_SIMD_SSE2_SET1(_a_) _mm_set1_pd(_a_)
+#define MAXENTMC_SIMD_SSE2_ZERO() _mm_setzero_pd()
+#define MAXENTMC_SIMD_SSE2_ADD(_a_,_b_) _mm_add_pd((_a_),(_b_))
+#define MAXENTMC_SIMD_SSE2_SUB(_a_,_b_) _mm_sub_pd((_a_),(_b_))
+#define MAXENTMC_SIMD_SSE2_MUL(_a_,_b_) _mm_mul_pd((_a_),(_b_))
+#define MAXENTMC_SIMD_SSE2_FMADD(_a_,_b_,_c_) _mm_add_pd(_mm_mul_pd((_a_),(_b_)),(_c_))
+#define MAXENTMC_SIMD_SSE2_MIN(_a_,_b_) _mm_min_pd((_a_),(_b_))
+#define MAXENTMC_SIMD_SSE2_MAX(_a_,_b_) _mm_max_pd((_a_),(_b_))
+#define MAXENTMC_SIMD_SSE2_SHL52(_a_) _mm_castsi128_pd(_mm_slli_epi64(_mm_castpd_si128(_a_),52))
+
+/** AVX2 with FMA, 4 doubles **/
+
+#define MAXENTMC_SIMD_AVX2_WIDTH 4
+#define MAXENTMC_SIMD_AVX2_TARGET __attribute__((target("avx2,fma")))
+#define MAXENTMC_SIMD_AVX2_T __m256d
+#define MAXENTMC_SIMD_AVX2_LOAD(_p_) _mm256_load_pd(_p_)
+#define MAXENTMC_SIMD_AVX2_STORE(_p_,_a_) _mm256_store_pd((_p_),(_a_))
+#define MAXENTMC_SIMD_AVX2_SET1(_a_) _mm256_set1_pd(_a_)
+#define MAXENTMC_SIMD_AVX2_ZERO() _mm256_setzero_pd()
+#define MAXENTMC_SIMD_AVX2_ADD(_a_,_b_) _mm256_add_pd((_a_),(_b_))
+#define MAXENTMC_SIMD_AVX2_SUB(_a_,_b_) _mm256_sub_pd((_a_),(_b_))
+#define MAXENTMC_SIMD_AVX2_MUL(_a_,_b_) _mm256_mul_pd((_a_),(_b_))
+#define MAXENTMC_SIMD_AVX2_FMADD(_a_,_b_,_c_) _mm256_fmadd_pd((_a_),(_b_),(_c_))
+#define MAXENTMC_SIMD_AVX2_MIN(_a_,_b_) _mm256_min_pd((_a_),(_b_))
+#define MAXENTMC_SIMD_AVX2_MAX(_a_,_b_) _mm256_max_pd((_a_),(_b_))
+#define MAXENTMC_SIMD_AVX2_SHL52(_a_) _mm256_castsi256_pd(_mm256_slli_epi64(_mm256_castpd_si256(_a_),52))
+
+/** AVX-512, 8 doubles **/
+
+#define MAXENTMC_SIMD_AVX512_WIDTH 8
+#define MAXENTMC_SIMD_AVX512_TARGET __attribute__((target("avx512f,avx2,fma")))
+#define MAXENTMC_SIMD_AVX512_T __m512d
+#define MAXENTMC_SIMD_AVX512_LOAD(_p_) _mm512_load_pd(_p_)
+#define MAXENTMC_SIMD_AVX512_STORE(_p_,_a_) _mm512_store_pd((_p_),(_a_))
+#define MAXENTMC_SIMD_AVX512_SET1(_a_) _mm512_set1_pd(_a_)
+#define MAXENTMC_SIMD_AVX512_ZERO() _mm512_setzero_pd()
+#define MAXENTMC_SIMD_AVX512_ADD(_a_,_b_) _mm512_add_pd((_a_),(_b_))
+#define MAXENTMC_SIMD_AVX512_SUB(_a_,_b_) _mm512_sub_pd((_a_),(_b_))
+#define MAXENTMC_SIMD_AVX512_MUL(_a_,_b_) _mm512_mul_pd((_a_),(_b_))
+#define MAXENTMC_SIMD_AVX512_FMADD(_a_,_b_,_c_) _mm512_fmadd_pd((_a_),(_b_),(_c_))
+#define MAXENTMC_SIMD_AVX512_MIN(_a_,_b_) _mm512_min_pd((_a_),(_b_))
+#define MAXENTMC_SIMD_AVX512_MAX(_a_,_b_) _mm512_max_pd((_a_),(_b_))
+#define MAXENTMC_SIMD_AVX512_SHL52(_a_) _mm512_castsi512_pd(_mm512_slli_epi64(_mm512_castpd_si512(_a_),52))
+
+#define MAXENTMC_SIMD_X86
+
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+
+#include <arm_neon.h>
+
+/** NEON (AArch64), 2 doubles **/
+
+#define MAXENTMC_SIMD_NEON_WIDTH 2
+#define MAXENTMC_SIMD_NEON_TARGET
+#define MAXENTMC_SIMD_NEON_T float64x2_t
+#define MAXENTMC_SIMD_NEON_LOAD(_p_) vld1q_f64(_p_)
+#define MAXENTMC_SIMD_NEON_STORE(_p_,_a_) vst1q_f64((_p_),(_a_))
+#define MAXENTMC_SIMD_NEON_SET1(_a_) vdupq_n_f64(_a_)
+#define MAXENTMC_SIMD_NEON_ZERO() vdupq_n_f64(0.0)
+#define MAXENTMC_SIMD_NEON_ADD(_a_,_b_) vaddq_f64((_a_),(_b_))
+#define MAXENTMC_SIMD_NEON_SUB(_a_,_b_) vsubq_f64((_a_),(_b_))
+#define MAXENTMC_SIMD_NEON_MUL(_a_,_b_) vmulq_f64((_a_),(_b_))
+#define MAXENTMC_SIMD_NEON_FMADD(_a_,_b_,_c_) vfmaq_f64((_c_),(_a_),(_b_))
+#define MAXENTMC_SIMD_NEON_MIN(_a_,_b_) vminq_f64((_a_),(_b_))
+#define MAXENTMC_SIMD_NEON_MAX(_a_,_b_) vmaxq_f64((_a_),(_b_))
+#define MAXENTMC_SIMD_NEON_SHL52(_a_) vreinterpretq_f64_s64(vshlq_n_s64(vreinterpretq_s64_f64(_a_),52))
+
+#define MAXENTMC_SIMD_NEON
+
+#endif
+
+#endif
+
+/** Vectorized exponential. The argument is reduced as x = n ln2 + r, |r| <= ln2/2, with the two-part
+    (Cody-Waite) ln2 so that n ln2_hi is exact (with or without a fused FMADD, since ln2_hi has trailing zero
+    bits), and exp(r) is summed as a Taylor polynomial of the
+    given degree: 13 terms reach full double precision, 10 terms give about 1e-12 relative error, 6 terms
+    about 1e-7. The integer n is obtained by rounding against 1.5*2^52, which leaves n in the low bits of
+    the mantissa, and 2^n is assembled by shifting n+1023 into the exponent field. 2^n is applied in two
+    halves, which keeps both factors normal for |x| <= 1000, so overflow gives inf and underflow gives 0
+    (through the subnormals) in the final product. The clamp is written as MAX(lo,x), MIN(hi,x) with x
+    second, which returns x when it is NaN on every instruction set, so NaN propagates. **/
+
+#define MAXENTMC_SIMD_EXP_DEGREE_MAX 13
+
+#define MAXENTMC_SIMD_EXP_ROUND 6755399441055744.0      /** 1.5*2^52 **/
+#define MAXENTMC_SIMD_EXP_BIAS  6755399441056767.0      /** 1.5*2^52+1023 **/
+#define MAXENTMC_SIMD_EXP_LIMIT 1000.0
+#define MAXENTMC_SIMD_EXP_LOG2E 1.44269504088896338700e+00
+#define MAXENTMC_SIMD_EXP_LN2HI 6.93147180369123816490e-01
+#define MAXENTMC_SIMD_EXP_LN2LO 1.90821492927058770002e-10
+
+static maxentmc_float_t const maxentmc_simd_exp_coefficients[MAXENTMC_SIMD_EXP_DEGREE_MAX+1] = {
+    1.0, 1.0, 1.0/2.0, 1.0/6.0, 1.0/24.0, 1.0/120.0, 1.0/720.0, 1.0/5040.0, 1.0/40320.0, 1.0/362880.0,
+    1.0/3628800.0, 1.0/39916800.0, 1.0/479001600.0, 1.0/6227020800.0
+};
+
+#define MAXENTMC_SIMD_EXP_FUNCTION(_V_)                                                                 \
+MAXENTMC_SIMD_##_V_##_TARGET static inline MAXENTMC_SIMD_##_V_##_T                                      \
+maxentmc_simd_exp_##_V_(MAXENTMC_SIMD_##_V_##_T x, int const degree)                                    \
+{                                                                                                       \
+    MAXENTMC_SIMD_##_V_##_T const round = MAXENTMC_SIMD_##_V_##_SET1(MAXENTMC_SIMD_EXP_ROUND);          \
+    MAXENTMC_SIMD_##_V_##_T const bias = MAXENTMC_SIMD_##_V_##_SET1(MAXENTMC_SIMD_EXP_BIAS);            \
+    MAXENTMC_SIMD_##_V_##_T n, n1, r, p;                                                                \
+    int k;                                                                                              \
+                                                                                                        \
+    x = MAXENTMC_SIMD_##_V_##_MAX(MAXENTMC_SIMD_##_V_##_SET1(-MAXENTMC_SIMD_EXP_LIMIT),x);              \
+    x = MAXENTMC_SIMD_##_V_##_MIN(MAXENTMC_SIMD_##_V_##_SET1(MAXENTMC_SIMD_EXP_LIMIT),x);               \
+                                                                                                        \
+    n = MAXENTMC_SIMD_##_V_##_SUB(                                                                      \
+            MAXENTMC_SIMD_##_V_##_FMADD(x,MAXENTMC_SIMD_##_V_##_SET1(MAXENTMC_SIMD_EXP_LOG2E),round),   \
+            round);                                                                                     \
+    r = MAXENTMC_SIMD_##_V_##_FMADD(n,MAXENTMC_SIMD_##_V_##_SET1(-MAXENTMC_SIMD_EXP_LN2HI),x);          \
+    r = MAXENTMC_SIMD_##_V_##_FMADD(n,MAXENTMC_SIMD_##_V_##_SET1(-MAXENTMC_SIMD_EXP_LN2LO),r);          \
+                                                                                                        \
+    p = MAXENTMC_SIMD_##_V_##_SET1(maxentmc_simd_exp_coefficients[degree]);                             \
+    for(k=degree-1;k>=0;--k)                                                                            \
+        p = MAXENTMC_SIMD_##_V_##_FMADD(p,r,MAXENTMC_SIMD_##_V_##_SET1(maxentmc_simd_exp_coefficients[k])); \
+                                                                                                        \
+    n1 = MAXENTMC_SIMD_##_V_##_SUB(                                                                     \
+            MAXENTMC_SIMD_##_V_##_FMADD(n,MAXENTMC_SIMD_##_V_##_SET1(0.5),round),round);                \
+    n = MAXENTMC_SIMD_##_V_##_SUB(n,n1);                                                                \
+                                                                                                        \
+    p = MAXENTMC_SIMD_##_V_##_MUL(p,MAXENTMC_SIMD_##_V_##_SHL52(MAXENTMC_SIMD_##_V_##_ADD(n1,bias)));   \
+    return MAXENTMC_SIMD_##_V_##_MUL(p,MAXENTMC_SIMD_##_V_##_SHL52(MAXENTMC_SIMD_##_V_##_ADD(n,bias)));  \
+}
+
+#ifdef MAXENTMC_SINGLE_PRECISION
+static inline maxentmc_float_t maxentmc_simd_exp_SCALAR(maxentmc_float_t const x, int const degree)
+{
+    return exp(x);
+}
+#else
+MAXENTMC_SIMD_EXP_FUNCTION(SCALAR)
+#endif
+
+#ifdef MAXENTMC_SIMD_X86
+MAXENTMC_SIMD_EXP_FUNCTION(SSE2)
+MAXENTMC_SIMD_EXP_FUNCTION(AVX2)
+MAXENTMC_SIMD_EXP_FUNCTION(AVX512)
+#endif
+
+#ifdef MAXENTMC_SIMD_NEON
+MAXENTMC_SIMD_EXP_FUNCTION(NEON)
+#endif
+
+#endif // MAXENTMC_SIMD_H_INCLUDED
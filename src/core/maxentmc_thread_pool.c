@@ -0,0 +1,459 @@
+/** This file is part of MaxEntMC, a maximum entropy algorithm with moment constraints. **/
+/** Copyright (C) 2014 Rafail V. Abramov.                                               **/
+/**                                                                                     **/
+/** This program is free software: you can redistribute it and/or modify it under the   **/
+/** terms of the GNU General Public License as published by the Free Software           **/
+/** Foundation, either version 3 of the License, or (at your option) any later version. **/
+/**                                                                                     **/
+/** This program is distributed in the hope that it will be useful, but WITHOUT ANY     **/
+/** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     **/
+/** PARTICULAR PURPOSE.  See the GNU General Public License for more details.           **/
+/**                                                                                     **/
+/** You should have received a copy of the GNU General Public License along with this   **/
+/** program.  If not, see <http://www.gnu.org/licenses/>.                               **/
+
+#ifdef __linux__
+#define _GNU_SOURCE /** pthread_attr_setaffinity_np **/
+#include <sched.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "maxentmc_cpu.h"
+#include "maxentmc_thread_pool.h"
+
+#define MAXENTMC_THREAD_POOL_MAX_CPUS 1024
+
+#define MAXENTMC_THREAD_POOL_WORKER(_pool_,_i_) ((struct maxentmc_thread_pool_worker_struct *)MAXENTMC_INCREMENT_POINTER((_pool_)->workers,(_i_)*(_pool_)->worker_size))
+
+static void * maxentmc_thread_pool_worker(void * const arg)
+{
+    struct maxentmc_thread_pool_worker_struct * const worker = arg;
+    struct maxentmc_thread_pool_struct * const pool = worker->pool;
+
+    unsigned long seen = 0; /** the generation at the start of the pool, a task may already be waiting **/
+
+    pthread_mutex_lock(&pool->lock);
+
+    for(;;){
+
+        while((pool->generation == seen) && !pool->stop)
+            pthread_cond_wait(&pool->start,&pool->lock);
+
+        if(pool->stop)
+            break;
+
+        seen = pool->generation;
+
+        maxentmc_thread_pool_task_t const task = pool->task;
+        void * const task_arg = pool->arg;
+
+        pthread_mutex_unlock(&pool->lock);
+
+        task(task_arg,worker->index);
+
+        pthread_mutex_lock(&pool->lock);
+
+        if(--(pool->running) == 0)
+            pthread_cond_signal(&pool->done);
+
+    }
+
+    pthread_mutex_unlock(&pool->lock);
+
+    return NULL;
+}
+
+/** Assigns a processor and a node to every worker. Workers are numbered node by node, so that contiguous ranges of work
+    and subtrees of the reduction stay on one node as far as possible. **/
+
+static void maxentmc_thread_pool_place(struct maxentmc_thread_pool_struct * const pool, size_t const num_threads)
+{
+    size_t i;
+
+    for(i=0;i<num_threads;++i){
+        MAXENTMC_THREAD_POOL_WORKER(pool,i)->cpu = -1;
+        MAXENTMC_THREAD_POOL_WORKER(pool,i)->node = 0;
+    }
+
+    pool->num_nodes = 1;
+
+    if(pool->placement == MAXENTMC_THREAD_POOL_PLACEMENT_NONE)
+        return;
+
+    int cpus[MAXENTMC_THREAD_POOL_MAX_CPUS], nodes[MAXENTMC_THREAD_POOL_MAX_CPUS];
+
+    size_t const num_cpus = maxentmc_cpu_topology(MAXENTMC_THREAD_POOL_MAX_CPUS,cpus,nodes);
+
+    if(num_cpus == 0){
+        MAXENTMC_MESSAGE(stderr,"warning: processors cannot be enumerated, workers are not pinned");
+        pool->placement = MAXENTMC_THREAD_POOL_PLACEMENT_NONE;
+        return;
+    }
+
+    /** first[k] is the position in cpus of the first processor of the k-th node present **/
+
+    size_t first[num_cpus+1], k;
+
+    pool->num_nodes = 0;
+
+    for(i=0;i<num_cpus;++i)
+        if((i == 0) || (nodes[i] != nodes[i-1]))
+            first[pool->num_nodes++] = i;
+
+    first[pool->num_nodes] = num_cpus;
+
+    for(i=0;i<num_threads;++i){
+        struct maxentmc_thread_pool_worker_struct * const worker = MAXENTMC_THREAD_POOL_WORKER(pool,i);
+        size_t c;
+        if(pool->placement == MAXENTMC_THREAD_POOL_PLACEMENT_COMPACT)
+            /** Fill the processors of a node before moving to the next one (several workers per processor if there are
+                more workers than processors) **/
+            c = (num_threads<=num_cpus)?i:i*num_cpus/num_threads;
+        else{
+            /** An equal share of the workers on every node **/
+            k = i*pool->num_nodes/num_threads;
+            size_t const j = i - (k*num_threads+pool->num_nodes-1)/pool->num_nodes;
+            c = first[k] + j%(first[k+1]-first[k]);
+        }
+        worker->cpu = cpus[c];
+        worker->node = nodes[c];
+    }
+
+    /** Only the nodes that got workers count **/
+
+    pool->num_nodes = 1;
+
+    for(i=1;i<num_threads;++i)
+        if(MAXENTMC_THREAD_POOL_WORKER(pool,i)->node != MAXENTMC_THREAD_POOL_WORKER(pool,i-1)->node)
+            ++(pool->num_nodes);
+}
+
+static int maxentmc_thread_pool_start(struct maxentmc_thread_pool_worker_struct * const worker)
+{
+#ifdef __linux__
+    if(worker->cpu >= 0){
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(worker->cpu,&set);
+        if(worker->index == 0){
+            /** Saved to be restored by maxentmc_thread_pool_free, the calling thread does not belong to the pool **/
+            struct maxentmc_thread_pool_struct * const pool = worker->pool;
+            pool->caller_affinity = malloc(sizeof(cpu_set_t));
+            if(pool->caller_affinity == NULL)
+                return -1;
+            if(pthread_getaffinity_np(worker->thread,sizeof(cpu_set_t),pool->caller_affinity)){
+                free(pool->caller_affinity);
+                pool->caller_affinity = NULL;
+                return -1;
+            }
+            return pthread_setaffinity_np(worker->thread,sizeof(cpu_set_t),&set);
+        }
+        /** Pinned from the start, so that the stack and everything the worker touches first is on its node **/
+        pthread_attr_t attr;
+        pthread_attr_init(&attr);
+        pthread_attr_setaffinity_np(&attr,sizeof(cpu_set_t),&set);
+        int const status = pthread_create(&worker->thread,&attr,maxentmc_thread_pool_worker,worker);
+        pthread_attr_destroy(&attr);
+        return status;
+    }
+#endif
+    if(worker->index == 0)
+        return 0;
+    return pthread_create(&worker->thread,NULL,maxentmc_thread_pool_worker,worker);
+}
+
+struct maxentmc_thread_pool_struct * maxentmc_thread_pool_alloc(size_t const num_threads)
+{
+    return maxentmc_thread_pool_alloc_placed(num_threads,MAXENTMC_THREAD_POOL_PLACEMENT_NONE);
+}
+
+struct maxentmc_thread_pool_struct * maxentmc_thread_pool_alloc_placed(size_t const num_threads, enum MAXENTMC_THREAD_POOL_PLACEMENT const placement)
+{
+    if(num_threads == 0){
+        MAXENTMC_MESSAGE(stderr,"error: zero number of threads");
+        return NULL;
+    }
+
+    switch(placement){
+        case MAXENTMC_THREAD_POOL_PLACEMENT_NONE:
+        case MAXENTMC_THREAD_POOL_PLACEMENT_COMPACT:
+        case MAXENTMC_THREAD_POOL_PLACEMENT_SPREAD:
+            break;
+        default:
+            MAXENTMC_MESSAGE(stderr,"error: unknown placement");
+            return NULL;
+    }
+
+    struct maxentmc_thread_pool_struct * const pool = malloc(sizeof(struct maxentmc_thread_pool_struct));
+    if(pool == NULL){
+        MAXENTMC_MESSAGE(stderr,"error: insufficient memory");
+        return NULL;
+    }
+
+    int status;
+
+    pool->worker_size = MAXENTMC_ALIGNED_SIZE(MAXENTMC_CACHE_LINE_SIZE,sizeof(struct maxentmc_thread_pool_worker_struct));
+
+    MAXENTMC_ALLOC(pool->workers,pool->worker_size*num_threads,status);
+
+    if(status){
+        free(pool);
+        return NULL;
+    }
+
+    pool->num_threads = 1;
+    pool->placement = placement;
+    pool->caller_affinity = NULL;
+    pool->task = NULL;
+    pool->arg = NULL;
+    pool->chunk = NULL;
+    pool->finish = NULL;
+    pool->chunk_arg = NULL;
+    pool->generation = 0;
+    pool->running = 0;
+    pool->stop = 0;
+
+    pthread_mutex_init(&pool->lock,NULL);
+    pthread_mutex_init(&pool->run_lock,NULL);
+    pthread_cond_init(&pool->start,NULL);
+    pthread_cond_init(&pool->done,NULL);
+
+    maxentmc_thread_pool_place(pool,num_threads);
+
+    /** Worker 0 is whichever thread calls maxentmc_thread_pool_run, the others are started here. With a placement, the
+        calling thread is pinned to the processor of worker 0 until the pool is freed. **/
+
+    struct maxentmc_thread_pool_worker_struct * const worker0 = MAXENTMC_THREAD_POOL_WORKER(pool,0);
+    worker0->pool = pool;
+    worker0->index = 0;
+    worker0->thread = pthread_self();
+
+    if(maxentmc_thread_pool_start(worker0))
+        MAXENTMC_MESSAGE(stderr,"warning: could not pin the calling thread");
+
+    while(pool->num_threads<num_threads){
+        struct maxentmc_thread_pool_worker_struct * const worker = MAXENTMC_THREAD_POOL_WORKER(pool,pool->num_threads);
+        worker->pool = pool;
+        worker->index = pool->num_threads;
+        if(maxentmc_thread_pool_start(worker)){
+            MAXENTMC_MESSAGE_VARARG(stderr,"warning: could only start %zu threads",pool->num_threads);
+            break;
+        }
+        ++(pool->num_threads);
+    }
+
+    return pool;
+}
+
+void maxentmc_thread_pool_free(struct maxentmc_thread_pool_struct * const pool)
+{
+    if(pool){
+
+        pthread_mutex_lock(&pool->lock);
+        pool->stop = 1;
+        pthread_cond_broadcast(&pool->start);
+        pthread_mutex_unlock(&pool->lock);
+
+        size_t i;
+        for(i=1;i<pool->num_threads;++i)
+            pthread_join(MAXENTMC_THREAD_POOL_WORKER(pool,i)->thread,NULL);
+
+#ifdef __linux__
+        if(pool->caller_affinity){
+            if(pthread_setaffinity_np(MAXENTMC_THREAD_POOL_WORKER(pool,0)->thread,sizeof(cpu_set_t),pool->caller_affinity))
+                MAXENTMC_MESSAGE(stderr,"warning: could not restore the processors of the calling thread");
+            free(pool->caller_affinity);
+        }
+#endif
+
+        pthread_cond_destroy(&pool->done);
+        pthread_cond_destroy(&pool->start);
+        pthread_mutex_destroy(&pool->run_lock);
+        pthread_mutex_destroy(&pool->lock);
+        free(pool->workers);
+        free(pool);
+
+    }
+}
+
+size_t maxentmc_thread_pool_get_num_threads(struct maxentmc_thread_pool_struct const * const pool)
+{
+    if(pool)
+        return pool->num_threads;
+    else{
+        MAXENTMC_MESSAGE(stderr,"error: NULL pointer provided");
+        return 0;
+    }
+}
+
+/** Runs the task on all workers, the caller holds run_lock **/
+
+static void maxentmc_thread_pool_run_locked(struct maxentmc_thread_pool_struct * const pool, maxentmc_thread_pool_task_t const task, void * const arg)
+{
+    pthread_mutex_lock(&pool->lock);
+    pool->task = task;
+    pool->arg = arg;
+    pool->running = pool->num_threads-1;
+    ++(pool->generation);
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->lock);
+
+    task(arg,0);
+
+    pthread_mutex_lock(&pool->lock);
+    while(pool->running)
+        pthread_cond_wait(&pool->done,&pool->lock);
+    pthread_mutex_unlock(&pool->lock);
+}
+
+int maxentmc_thread_pool_get_node(struct maxentmc_thread_pool_struct const * const pool, size_t const index)
+{
+    if(pool == NULL){
+        MAXENTMC_MESSAGE(stderr,"error: NULL pointer provided");
+        return -1;
+    }
+    if(index >= pool->num_threads){
+        MAXENTMC_MESSAGE(stderr,"error: index exceeds the number of threads");
+        return -1;
+    }
+    return MAXENTMC_THREAD_POOL_WORKER(pool,index)->node;
+}
+
+size_t maxentmc_thread_pool_get_num_nodes(struct maxentmc_thread_pool_struct const * const pool)
+{
+    if(pool)
+        return pool->num_nodes;
+    else{
+        MAXENTMC_MESSAGE(stderr,"error: NULL pointer provided");
+        return 0;
+    }
+}
+
+int maxentmc_thread_pool_run(struct maxentmc_thread_pool_struct * const pool, maxentmc_thread_pool_task_t const task, void * const arg)
+{
+    MAXENTMC_CHECK_NULL(pool);
+    MAXENTMC_CHECK_NULL(task);
+
+    /** One task at a time per pool **/
+
+    pthread_mutex_lock(&pool->run_lock);
+
+    maxentmc_thread_pool_run_locked(pool,task,arg);
+
+    pthread_mutex_unlock(&pool->run_lock);
+
+    return 0;
+}
+
+#define MAXENTMC_THREAD_POOL_RANGE(_begin_,_end_) ((uint64_t)(_begin_) | ((uint64_t)(_end_)<<32))
+#define MAXENTMC_THREAD_POOL_RANGE_BEGIN(_range_) ((size_t)((_range_) & 0xffffffffu))
+#define MAXENTMC_THREAD_POOL_RANGE_END(_range_) ((size_t)((_range_)>>32))
+
+static void maxentmc_thread_pool_chunk_task(void * const arg, size_t const index)
+{
+    struct maxentmc_thread_pool_struct * const pool = arg;
+    struct maxentmc_thread_pool_worker_struct * const self = MAXENTMC_THREAD_POOL_WORKER(pool,index);
+    size_t const n = pool->num_threads;
+    size_t done = 0;
+    int failed = 0;
+
+    for(;;){
+
+        /** Own chunks first, from the front of the range **/
+
+        uint64_t range = atomic_load_explicit(&self->range,memory_order_relaxed);
+        size_t begin, end;
+
+        while((begin = MAXENTMC_THREAD_POOL_RANGE_BEGIN(range)) < (end = MAXENTMC_THREAD_POOL_RANGE_END(range))){
+            if(atomic_compare_exchange_weak_explicit(&self->range,&range,MAXENTMC_THREAD_POOL_RANGE(begin+1,end),
+                                                     memory_order_relaxed,memory_order_relaxed)){
+                if(pool->chunk(pool->chunk_arg,begin,index))
+                    failed = 1;
+                ++done;
+                range = atomic_load_explicit(&self->range,memory_order_relaxed);
+            }
+        }
+
+        /** Then the back half of the range of the next worker that has some left, on the same node first. A range in
+            transit to a thief is not seen, but the thief works it off itself, so nothing is lost. **/
+
+        size_t k, pass;
+        int stolen = 0;
+
+        for(pass=0;(pass<2) && !stolen;++pass)
+            for(k=1;(k<n) && !stolen;++k){
+                struct maxentmc_thread_pool_worker_struct * const victim = MAXENTMC_THREAD_POOL_WORKER(pool,(index+k)%n);
+                if((victim->node == self->node) != (pass == 0))
+                    continue;
+                range = atomic_load_explicit(&victim->range,memory_order_relaxed);
+                while((begin = MAXENTMC_THREAD_POOL_RANGE_BEGIN(range)) < (end = MAXENTMC_THREAD_POOL_RANGE_END(range))){
+                    size_t const half = (end-begin+1)/2;
+                    if(atomic_compare_exchange_weak_explicit(&victim->range,&range,MAXENTMC_THREAD_POOL_RANGE(begin,end-half),
+                                                             memory_order_relaxed,memory_order_relaxed)){
+                        atomic_store_explicit(&self->range,MAXENTMC_THREAD_POOL_RANGE(end-half,end),memory_order_relaxed);
+                        stolen = 1;
+                        break;
+                    }
+                }
+            }
+
+        if(!stolen)
+            break;
+
+    }
+
+    atomic_fetch_add_explicit(&pool->chunks_done,done,memory_order_relaxed);
+    if(failed)
+        atomic_store_explicit(&pool->chunks_failed,1,memory_order_relaxed);
+
+    if(pool->finish)
+        pool->finish(pool->chunk_arg,index);
+}
+
+int maxentmc_thread_pool_run_chunks(struct maxentmc_thread_pool_struct * const pool, size_t const num_chunks,
+                                    maxentmc_thread_pool_chunk_t const chunk, maxentmc_thread_pool_task_t const finish, void * const arg)
+{
+    MAXENTMC_CHECK_NULL(pool);
+    MAXENTMC_CHECK_NULL(chunk);
+
+    if(num_chunks > 0xffffffffu){
+        MAXENTMC_MESSAGE(stderr,"error: too many chunks");
+        return -1;
+    }
+
+    pthread_mutex_lock(&pool->run_lock);
+
+    /** The ranges are published to the workers by the start of the task **/
+
+    size_t const n = pool->num_threads;
+    size_t i;
+
+    for(i=0;i<n;++i)
+        atomic_store_explicit(&MAXENTMC_THREAD_POOL_WORKER(pool,i)->range,
+                              MAXENTMC_THREAD_POOL_RANGE(i*num_chunks/n,(i+1)*num_chunks/n),memory_order_relaxed);
+
+    pool->chunk = chunk;
+    pool->finish = finish;
+    pool->chunk_arg = arg;
+    atomic_store_explicit(&pool->chunks_done,0,memory_order_relaxed);
+    atomic_store_explicit(&pool->chunks_failed,0,memory_order_relaxed);
+
+    maxentmc_thread_pool_run_locked(pool,maxentmc_thread_pool_chunk_task,pool);
+
+    /** The end of the task orders the counts of all workers before this point **/
+
+    int status = 0;
+
+    if(atomic_load_explicit(&pool->chunks_failed,memory_order_relaxed))
+        status = -1;
+    else if(atomic_load_explicit(&pool->chunks_done,memory_order_relaxed) != num_chunks){
+        MAXENTMC_MESSAGE(stderr,"error: not every chunk was computed");
+        status = -1;
+    }
+
+    pthread_mutex_unlock(&pool->run_lock);
+
+    return status;
+}
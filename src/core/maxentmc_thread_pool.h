@@ -0,0 +1,74 @@
+/** This file is part of MaxEntMC, a maximum entropy algorithm with moment constraints. **/
+/** Copyright (C) 2014 Rafail V. Abramov.                                               **/
+/**                                                                                     **/
+/** This program is free software: you can redistribute it and/or modify it under the   **/
+/** terms of the GNU General Public License as published by the Free Software           **/
+/** Foundation, either version 3 of the License, or (at your option) any later version. **/
+/**                                                                                     **/
+/** This program is distributed in the hope that it will be useful, but WITHOUT ANY     **/
+/** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     **/
+/** PARTICULAR PURPOSE.  See the GNU General Public License for more details.           **/
+/**                                                                                     **/
+/** You should have received a copy of the GNU General Public License along with this   **/
+/** program.  If not, see <http://www.gnu.org/licenses/>.                               **/
+
+#ifndef MAXENTMC_THREAD_POOL_H_INCLUDED
+#define MAXENTMC_THREAD_POOL_H_INCLUDED
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include "maxentmc_defs.h"
+#include "../user/maxentmc.h"
+
+/** Persistent worker threads for the quadrature passes. The workers sleep between passes, maxentmc_thread_pool_run
+    wakes them all for one task and returns once every worker (the calling thread is worker 0) has finished it. **/
+
+typedef void (*maxentmc_thread_pool_task_t)(void * arg, size_t index);
+
+/** maxentmc_thread_pool_run_chunks hands out chunks of work: every worker starts with a contiguous range of chunks, takes
+    them from the front, and once it runs out, steals the back half of the range of another worker. A chunk returns
+    non-zero if it failed **/
+
+typedef int (*maxentmc_thread_pool_chunk_t)(void * arg, size_t chunk, size_t index);
+
+struct maxentmc_thread_pool_struct;
+
+struct maxentmc_thread_pool_worker_struct {
+    struct maxentmc_thread_pool_struct * pool;
+    size_t index;
+    pthread_t thread;
+    int cpu, node;          /** cpu is -1 when the worker is not pinned **/
+    _Atomic uint64_t range; /** chunks not taken yet, begin in the low and end in the high 32 bits **/
+};
+
+struct maxentmc_thread_pool_struct {
+
+    size_t num_threads, num_nodes;
+
+    enum MAXENTMC_THREAD_POOL_PLACEMENT placement;
+
+    size_t worker_size; /** workers are padded to whole cache lines **/
+    void * workers;     /** [num_threads] **/
+
+    void * caller_affinity; /** processors of the allocating thread before it was pinned as worker 0, NULL if it was not **/
+
+    maxentmc_thread_pool_task_t task;
+    void * arg;
+
+    maxentmc_thread_pool_chunk_t chunk; /** the current maxentmc_thread_pool_run_chunks **/
+    maxentmc_thread_pool_task_t finish;
+    void * chunk_arg;
+    _Atomic size_t chunks_done; /** chunks computed by the current maxentmc_thread_pool_run_chunks **/
+    _Atomic int chunks_failed;
+
+    unsigned long generation; /** incremented for every task **/
+    size_t running;           /** workers still running the current task **/
+    int stop;
+
+    pthread_mutex_t lock, run_lock;
+    pthread_cond_t start, done;
+
+};
+
+#endif // MAXENTMC_THREAD_POOL_H_INCLUDED
@@ -20,6 +20,19 @@
 #include "test_quad.h"
 #include "test_gradient_hessian.h"
 #include "test_maxentmc_simple.h"
+#include "test_quad_bulk.h"
+#include "test_quad_exp.h"
+#include "test_quad_moment_sets.h"
+#include "test_quad_thread_reuse.h"
+#include "test_quad_reduction.h"
+#include "test_thread_pool.h"
+#include "test_basic_algorithm_batch.h"
+#include "test_basic_algorithm_speculative.h"
+#include "test_quad_gauss_hermite.h"
+#include "test_quad_box.h"
+#include "test_quad_smolyak.h"
+#include "test_quad_qmc.h"
+#include "test_quad_importance.h"
 
 int main(void)
 {
@@ -40,6 +53,49 @@ int main(void)
 
     test_maxentmc_simple();
 
-    return 0;
+    /** Checks of the quadrature helper, drivers and solvers, each prints whether it passed **/
+
+    int failed = 0;
+
+    if(test_quad_bulk())
+        failed = 1;
+
+    if(test_quad_exp())
+        failed = 1;
+
+    if(test_quad_moment_sets())
+        failed = 1;
+
+    if(test_quad_thread_reuse())
+        failed = 1;
+
+    if(test_quad_reduction())
+        failed = 1;
+
+    if(test_thread_pool())
+        failed = 1;
+
+    if(test_basic_algorithm_batch())
+        failed = 1;
+
+    if(test_basic_algorithm_speculative())
+        failed = 1;
+
+    if(test_quad_gauss_hermite())
+        failed = 1;
+
+    if(test_quad_box())
+        failed = 1;
+
+    if(test_quad_smolyak())
+        failed = 1;
+
+    if(test_quad_qmc())
+        failed = 1;
+
+    if(test_quad_importance())
+        failed = 1;
+
+    return failed;
 
 }
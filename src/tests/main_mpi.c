@@ -0,0 +1,34 @@
+/** This file is part of MaxEntMC, a maximum entropy algorithm with moment constraints. **/
+/** Copyright (C) 2014 Rafail V. Abramov.                                               **/
+/**                                                                                     **/
+/** This program is free software: you can redistribute it and/or modify it under the   **/
+/** terms of the GNU General Public License as published by the Free Software           **/
+/** Foundation, either version 3 of the License, or (at your option) any later version. **/
+/**                                                                                     **/
+/** This program is distributed in the hope that it will be useful, but WITHOUT ANY     **/
+/** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     **/
+/** PARTICULAR PURPOSE.  See the GNU General Public License for more details.           **/
+/**                                                                                     **/
+/** You should have received a copy of the GNU General Public License along with this   **/
+/** program.  If not, see <http://www.gnu.org/licenses/>.                               **/
+
+#include <mpi.h>
+
+#include "test_quad_mpi.h"
+
+/** Checks of the library built with MAXENTMC_MPI, run with mpirun on any number of ranks **/
+
+int main(int argc, char ** argv)
+{
+    MPI_Init(&argc,&argv);
+
+    int failed = 0;
+
+    if(test_quad_mpi())
+        failed = 1;
+
+    MPI_Finalize();
+
+    return failed;
+
+}
@@ -0,0 +1,90 @@
+/** This file is part of MaxEntMC, a maximum entropy algorithm with moment constraints. **/
+/** Copyright (C) 2014 Rafail V. Abramov.                                               **/
+/**                                                                                     **/
+/** This program is free software: you can redistribute it and/or modify it under the   **/
+/** terms of the GNU General Public License as published by the Free Software           **/
+/** Foundation, either version 3 of the License, or (at your option) any later version. **/
+/**                                                                                     **/
+/** This program is distributed in the hope that it will be useful, but WITHOUT ANY     **/
+/** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     **/
+/** PARTICULAR PURPOSE.  See the GNU General Public License for more details.           **/
+/**                                                                                     **/
+/** You should have received a copy of the GNU General Public License along with this   **/
+/** program.  If not, see <http://www.gnu.org/licenses/>.                               **/
+
+#include <math.h>
+#include "test_basic_algorithm_batch.h"
+
+/** The batch solver against maxentmc_basic_algorithm on each problem: problems of different dimensions and powers, so that
+    the workers reallocate their helpers and several groups of shared structures are built **/
+
+#define TEST_BASIC_ALGORITHM_BATCH_NUM 8
+#define TEST_BASIC_ALGORITHM_BATCH_NUM_THREADS 3
+
+int test_basic_algorithm_batch(void)
+{
+    char const * const files[TEST_BASIC_ALGORITHM_BATCH_NUM] = {
+        "data/data_1D/constraints_dim1_pow4_1.dat", "data/data_2D/constraints_dim2_pow4_1.dat",
+        "data/data_1D/constraints_dim1_pow8_1.dat", "data/data_1D/constraints_dim1_pow4_2.dat",
+        "data/data_2D/constraints_dim2_pow4_2.dat", "data/data_1D/constraints_dim1_pow8_2.dat",
+        "data/data_1D/constraints_dim1_pow4_3.dat", "data/data_2D/constraints_dim2_pow4_3.dat"};
+    size_t const quad_size[2] = {400, 120};
+    maxentmc_float_t const quad_start[2] = {-6.0, -6.0};
+    maxentmc_float_t const quad_end[2] = {6.0, 6.0};
+    maxentmc_float_t const tolerance = 1e-9;
+    maxentmc_power_vector_t batch[TEST_BASIC_ALGORITHM_BATCH_NUM], alone[TEST_BASIC_ALGORITHM_BATCH_NUM];
+    int status[TEST_BASIC_ALGORITHM_BATCH_NUM];
+    size_t num_iter[TEST_BASIC_ALGORITHM_BATCH_NUM];
+    size_t i, k;
+    int failed = 0;
+
+    for(i=0;i<TEST_BASIC_ALGORITHM_BATCH_NUM;++i){
+        FILE * const in = fopen(files[i],"r");
+        if(in == NULL){
+            printf("test_basic_algorithm_batch: could not open %s\n",files[i]);
+            puts("test_basic_algorithm_batch: FAILED");
+            return -1;
+        }
+        batch[i] = maxentmc_power_vector_fread_power(in);
+        maxentmc_power_vector_fread_values(batch[i],in);
+        fclose(in);
+        alone[i] = maxentmc_power_vector_alloc(batch[i]);
+        gsl_vector_memcpy(&alone[i]->gsl_vec,&batch[i]->gsl_vec);
+    }
+
+    maxentmc_thread_pool_t const pool = maxentmc_thread_pool_alloc(TEST_BASIC_ALGORITHM_BATCH_NUM_THREADS);
+
+    if(maxentmc_basic_algorithm_batch(batch,TEST_BASIC_ALGORITHM_BATCH_NUM,quad_size,quad_start,quad_end,tolerance,pool,
+                                      status,num_iter)){
+        puts("test_basic_algorithm_batch: batch solver returned an error");
+        failed = 1;
+    }
+
+    maxentmc_thread_pool_free(pool);
+
+    for(i=0;i<TEST_BASIC_ALGORITHM_BATCH_NUM;++i){
+        int const s = maxentmc_basic_algorithm(alone[i],quad_size,quad_start,quad_end,tolerance);
+        if(s != status[i]){
+            printf("test_basic_algorithm_batch: %s returned %d in the batch and %d alone\n",files[i],status[i],s);
+            failed = 1;
+            continue;
+        }
+        for(k=0;k<alone[i]->gsl_vec.size;++k){
+            maxentmc_float_t const v = alone[i]->gsl_vec.data[k];
+            if(!(fabs(batch[i]->gsl_vec.data[k]-v) <= 1e-7*(1.0+fabs(v)))){
+                printf("test_basic_algorithm_batch: multiplier %zu of %s is %.17g in the batch (%zu iterations) and %.17g alone\n",
+                       k,files[i],batch[i]->gsl_vec.data[k],num_iter[i],v);
+                failed = 1;
+            }
+        }
+    }
+
+    for(i=0;i<TEST_BASIC_ALGORITHM_BATCH_NUM;++i){
+        maxentmc_power_vector_free(batch[i]);
+        maxentmc_power_vector_free(alone[i]);
+    }
+
+    puts((failed)?"test_basic_algorithm_batch: FAILED":"test_basic_algorithm_batch: passed");
+
+    return (failed)?-1:0;
+}
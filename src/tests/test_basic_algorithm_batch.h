@@ -0,0 +1,25 @@
+/** This file is part of MaxEntMC, a maximum entropy algorithm with moment constraints. **/
+/** Copyright (C) 2014 Rafail V. Abramov.                                               **/
+/**                                                                                     **/
+/** This program is free software: you can redistribute it and/or modify it under the   **/
+/** terms of the GNU General Public License as published by the Free Software           **/
+/** Foundation, either version 3 of the License, or (at your option) any later version. **/
+/**                                                                                     **/
+/** This program is distributed in the hope that it will be useful, but WITHOUT ANY     **/
+/** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     **/
+/** PARTICULAR PURPOSE.  See the GNU General Public License for more details.           **/
+/**                                                                                     **/
+/** You should have received a copy of the GNU General Public License along with this   **/
+/** program.  If not, see <http://www.gnu.org/licenses/>.                               **/
+
+#ifndef TEST_BASIC_ALGORITHM_BATCH_H_INCLUDED
+#define TEST_BASIC_ALGORITHM_BATCH_H_INCLUDED
+
+#include <stdio.h>
+#include <gsl/gsl_vector.h>
+#include "../user/maxentmc.h"
+#include "../user/maxentmc_basic_algorithm.h"
+
+int test_basic_algorithm_batch(void);
+
+#endif // TEST_BASIC_ALGORITHM_BATCH_H_INCLUDED
@@ -0,0 +1,74 @@
+/** This file is part of MaxEntMC, a maximum entropy algorithm with moment constraints. **/
+/** Copyright (C) 2014 Rafail V. Abramov.                                               **/
+/**                                                                                     **/
+/** This program is free software: you can redistribute it and/or modify it under the   **/
+/** terms of the GNU General Public License as published by the Free Software           **/
+/** Foundation, either version 3 of the License, or (at your option) any later version. **/
+/**                                                                                     **/
+/** This program is distributed in the hope that it will be useful, but WITHOUT ANY     **/
+/** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     **/
+/** PARTICULAR PURPOSE.  See the GNU General Public License for more details.           **/
+/**                                                                                     **/
+/** You should have received a copy of the GNU General Public License along with this   **/
+/** program.  If not, see <http://www.gnu.org/licenses/>.                               **/
+
+#include <string.h>
+#include "test_basic_algorithm_speculative.h"
+
+/** With the deterministic reduction, the speculative line search must give the multipliers of the serial one bitwise, with
+    as many threads as trials and with more, and falling back to it with fewer **/
+
+#define TEST_BASIC_ALGORITHM_SPECULATIVE_NUM 3
+#define TEST_BASIC_ALGORITHM_SPECULATIVE_NUM_COUNTS 3
+
+int test_basic_algorithm_speculative(void)
+{
+    char const * const files[TEST_BASIC_ALGORITHM_SPECULATIVE_NUM] = {
+        "data/data_1D/constraints_dim1_pow8_1.dat", "data/data_2D/constraints_dim2_pow4_1.dat",
+        "data/data_2D/constraints_dim2_pow6_1.dat"};
+    size_t const num_threads[TEST_BASIC_ALGORITHM_SPECULATIVE_NUM_COUNTS] = {2, 4, 8};
+    size_t const quad_size[2] = {400, 120};
+    maxentmc_float_t const quad_start[2] = {-6.0, -6.0};
+    maxentmc_float_t const quad_end[2] = {6.0, 6.0};
+    maxentmc_float_t const tolerance = 1e-9;
+    enum MAXENTMC_QUAD_HELPER_REDUCTION_MODE const mode = MAXENTMC_QUAD_HELPER_REDUCTION_DETERMINISTIC;
+    size_t i, c;
+    int failed = 0;
+
+    for(i=0;i<TEST_BASIC_ALGORITHM_SPECULATIVE_NUM;++i){
+
+        FILE * const in = fopen(files[i],"r");
+        if(in == NULL){
+            printf("test_basic_algorithm_speculative: could not open %s\n",files[i]);
+            failed = 1;
+            continue;
+        }
+        maxentmc_power_vector_t const constraints = maxentmc_power_vector_fread_power(in);
+        maxentmc_power_vector_fread_values(constraints,in);
+        fclose(in);
+
+        maxentmc_power_vector_t const serial = maxentmc_power_vector_alloc(constraints);
+        maxentmc_power_vector_t const speculative = maxentmc_power_vector_alloc(constraints);
+
+        gsl_vector_memcpy(&serial->gsl_vec,&constraints->gsl_vec);
+        int const status = maxentmc_basic_algorithm_parallel(serial,quad_size,quad_start,quad_end,tolerance,1,mode);
+
+        for(c=0;c<TEST_BASIC_ALGORITHM_SPECULATIVE_NUM_COUNTS;++c){
+            gsl_vector_memcpy(&speculative->gsl_vec,&constraints->gsl_vec);
+            int const s = maxentmc_basic_algorithm_speculative(speculative,quad_size,quad_start,quad_end,tolerance,num_threads[c],mode);
+            if(s != status || memcmp(speculative->gsl_vec.data,serial->gsl_vec.data,sizeof(maxentmc_float_t)*serial->gsl_vec.size)){
+                printf("test_basic_algorithm_speculative: %s with %zu threads differs from the serial line search\n",
+                       files[i],num_threads[c]);
+                failed = 1;
+            }
+        }
+
+        maxentmc_power_vector_free(constraints);
+        maxentmc_power_vector_free(serial);
+        maxentmc_power_vector_free(speculative);
+    }
+
+    puts((failed)?"test_basic_algorithm_speculative: FAILED":"test_basic_algorithm_speculative: passed");
+
+    return (failed)?-1:0;
+}
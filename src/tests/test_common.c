@@ -0,0 +1,86 @@
+/** This file is part of MaxEntMC, a maximum entropy algorithm with moment constraints. **/
+/** Copyright (C) 2014 Rafail V. Abramov.                                               **/
+/**                                                                                     **/
+/** This program is free software: you can redistribute it and/or modify it under the   **/
+/** terms of the GNU General Public License as published by the Free Software           **/
+/** Foundation, either version 3 of the License, or (at your option) any later version. **/
+/**                                                                                     **/
+/** This program is distributed in the hope that it will be useful, but WITHOUT ANY     **/
+/** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     **/
+/** PARTICULAR PURPOSE.  See the GNU General Public License for more details.           **/
+/**                                                                                     **/
+/** You should have received a copy of the GNU General Public License along with this   **/
+/** program.  If not, see <http://www.gnu.org/licenses/>.                               **/
+
+#include <math.h>
+#include "test_common.h"
+
+maxentmc_power_vector_t test_common_powers(maxentmc_index_t const dim, maxentmc_index_t const total_pow)
+{
+    return test_common_powers_bounded(dim,total_pow,total_pow);
+}
+
+maxentmc_power_vector_t test_common_powers_bounded(maxentmc_index_t const dim, maxentmc_index_t const total_pow, maxentmc_index_t const max_pow)
+{
+    maxentmc_list_t list = maxentmc_list_alloc(dim,1,MAXENTMC_LIST_ORDERED,MAXENTMC_LIST_ASCEND);
+    maxentmc_index_t p[dim];
+    maxentmc_float_t const x = 0.0;
+    maxentmc_index_t i, total;
+    for(i=0;i<dim;++i)
+        p[i] = 0;
+    for(;;){
+        for(total=0,i=0;i<dim;++i)
+            total += p[i];
+        if(total <= total_pow)
+            maxentmc_list_insert_ca(list,p,&x);
+        for(i=0;i<dim && p[i] == max_pow;++i)
+            p[i] = 0;
+        if(i == dim)
+            break;
+        ++p[i];
+    }
+    maxentmc_power_vector_t v;
+    maxentmc_list_create_power_vectors(list,&v);
+    maxentmc_list_free(list);
+    return v;
+}
+
+void test_common_gaussian_multipliers(maxentmc_power_vector_t const multipliers, maxentmc_float_t const * const variances)
+{
+    maxentmc_index_t const dim = maxentmc_power_vector_get_dimension(multipliers);
+    maxentmc_index_t p[dim], i;
+    maxentmc_float_t log_det = 0.0;
+    size_t k;
+
+    for(i=0;i<dim;++i)
+        log_det += (variances)?log(variances[i]):0.0;
+
+    for(k=0;k<multipliers->gsl_vec.size;++k){
+        maxentmc_index_t total = 0, axis = 0;
+        maxentmc_power_vector_get_powers_ca(multipliers,k,p);
+        for(i=0;i<dim;++i){
+            total += p[i];
+            if(p[i])
+                axis = i;
+        }
+        if(total == 0)
+            multipliers->gsl_vec.data[k] = -0.5*(dim*log(8.0*atan(1.0))+log_det);
+        else if(total == 2 && p[axis] == 2)
+            multipliers->gsl_vec.data[k] = -0.5/((variances)?variances[axis]:1.0);
+        else
+            multipliers->gsl_vec.data[k] = 0.0;
+    }
+}
+
+maxentmc_float_t test_common_gaussian_moment(maxentmc_index_t const * const powers, maxentmc_index_t const dim, maxentmc_float_t const * const variances)
+{
+    maxentmc_float_t m = 1.0;
+    maxentmc_index_t i, k;
+    for(i=0;i<dim;++i){
+        if(powers[i]&1)
+            return 0.0;
+        for(k=1;k<powers[i];k+=2)
+            m *= k*((variances)?variances[i]:1.0);
+    }
+    return m;
+}
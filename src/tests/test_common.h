@@ -0,0 +1,34 @@
+/** This file is part of MaxEntMC, a maximum entropy algorithm with moment constraints. **/
+/** Copyright (C) 2014 Rafail V. Abramov.                                               **/
+/**                                                                                     **/
+/** This program is free software: you can redistribute it and/or modify it under the   **/
+/** terms of the GNU General Public License as published by the Free Software           **/
+/** Foundation, either version 3 of the License, or (at your option) any later version. **/
+/**                                                                                     **/
+/** This program is distributed in the hope that it will be useful, but WITHOUT ANY     **/
+/** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     **/
+/** PARTICULAR PURPOSE.  See the GNU General Public License for more details.           **/
+/**                                                                                     **/
+/** You should have received a copy of the GNU General Public License along with this   **/
+/** program.  If not, see <http://www.gnu.org/licenses/>.                               **/
+
+#ifndef TEST_COMMON_H_INCLUDED
+#define TEST_COMMON_H_INCLUDED
+
+#include <stdio.h>
+#include "../user/maxentmc.h"
+
+maxentmc_power_vector_t test_common_powers(maxentmc_index_t dim, maxentmc_index_t total_pow);
+/** All powers of total degree up to total_pow, with zero values **/
+
+maxentmc_power_vector_t test_common_powers_bounded(maxentmc_index_t dim, maxentmc_index_t total_pow, maxentmc_index_t max_pow);
+/** The same with every power also at most max_pow **/
+
+void test_common_gaussian_multipliers(maxentmc_power_vector_t multipliers, maxentmc_float_t const * variances);
+/** Sets the multipliers (which must contain the powers up to 2) to the centered Gaussian with the given variances along
+    the coordinates, or the standard one if variances is NULL **/
+
+maxentmc_float_t test_common_gaussian_moment(maxentmc_index_t const * powers, maxentmc_index_t dim, maxentmc_float_t const * variances);
+/** The moment with the given powers of the same Gaussian **/
+
+#endif // TEST_COMMON_H_INCLUDED
@@ -0,0 +1,96 @@
+/** This file is part of MaxEntMC, a maximum entropy algorithm with moment constraints. **/
+/** Copyright (C) 2014 Rafail V. Abramov.                                               **/
+/**                                                                                     **/
+/** This program is free software: you can redistribute it and/or modify it under the   **/
+/** terms of the GNU General Public License as published by the Free Software           **/
+/** Foundation, either version 3 of the License, or (at your option) any later version. **/
+/**                                                                                     **/
+/** This program is distributed in the hope that it will be useful, but WITHOUT ANY     **/
+/** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     **/
+/** PARTICULAR PURPOSE.  See the GNU General Public License for more details.           **/
+/**                                                                                     **/
+/** You should have received a copy of the GNU General Public License along with this   **/
+/** program.  If not, see <http://www.gnu.org/licenses/>.                               **/
+
+#include <math.h>
+#include "test_quad_box.h"
+#include "test_common.h"
+
+/** The Gauss-Legendre and Clenshaw-Curtis rules on [-1,1] must integrate the monomials up to the degree they are exact for,
+    then the box drivers must give the moments of a Gaussian on a box where its tails are negligible **/
+
+#define TEST_QUAD_BOX_MAX_NODES 64
+#define TEST_QUAD_BOX_MAX_DEGREE 40
+#define TEST_QUAD_BOX_MAX_POW 4
+#define TEST_QUAD_BOX_AMP 10.0
+
+int test_quad_box(void)
+{
+    enum MAXENTMC_QUADRATURE_RULE const rules[2] = {MAXENTMC_QUADRATURE_RULE_GAUSS_LEGENDRE, MAXENTMC_QUADRATURE_RULE_CLENSHAW_CURTIS};
+    char const * const names[2] = {"Gauss-Legendre", "Clenshaw-Curtis"};
+    size_t const box_points[2] = {64, 129};
+    maxentmc_float_t const s[2] = {1.0, 1.5};
+    size_t n, i, k;
+    int r, failed = 0;
+
+    for(r=0;r<2;++r)
+        for(n=1;n<=TEST_QUAD_BOX_MAX_NODES;++n){
+            maxentmc_float_t const * nodes, * weights;
+            if(maxentmc_quadrature_rule(rules[r],n,&nodes,&weights)){
+                printf("test_quad_box: %s rule with %zu nodes failed\n",names[r],n);
+                failed = 1;
+                continue;
+            }
+            size_t const degree = (rules[r] == MAXENTMC_QUADRATURE_RULE_GAUSS_LEGENDRE)?2*n-1:n-1;
+            for(k=0;k<=degree && k<=TEST_QUAD_BOX_MAX_DEGREE;++k){
+                maxentmc_float_t sum = 0.0;
+                for(i=0;i<n;++i)
+                    sum += weights[i]*pow(nodes[i],(double)k);
+                maxentmc_float_t const exact = (k%2)?0.0:2.0/(k+1);
+                if(!(fabs(sum-exact) <= 1e-13)){
+                    printf("test_quad_box: %s rule with %zu nodes integrates x^%zu to %.17g instead of %.17g\n",
+                           names[r],n,k,sum,exact);
+                    failed = 1;
+                }
+            }
+        }
+
+    /** Centered Gaussian with variances s[0] and s[1] **/
+
+    maxentmc_power_vector_t const multipliers = test_common_powers(2,2);
+    maxentmc_power_vector_t const moments = test_common_powers(2,TEST_QUAD_BOX_MAX_POW);
+    maxentmc_quad_helper_t const quad = maxentmc_quad_helper_alloc(2);
+    maxentmc_float_t const start[2] = {-TEST_QUAD_BOX_AMP, -TEST_QUAD_BOX_AMP};
+    maxentmc_float_t const end[2] = {TEST_QUAD_BOX_AMP, TEST_QUAD_BOX_AMP};
+    maxentmc_index_t p[2];
+
+    test_common_gaussian_multipliers(multipliers,s);
+
+    for(r=0;r<2;++r){
+        size_t const num_points[2] = {box_points[r], box_points[r]};
+        maxentmc_quad_helper_set_multipliers(quad,multipliers);
+        maxentmc_quad_helper_set_moments(quad,moments);
+        if(((rules[r] == MAXENTMC_QUADRATURE_RULE_GAUSS_LEGENDRE)?maxentmc_quadrature_gauss_legendre_ca:maxentmc_quadrature_clenshaw_curtis_ca)
+           (quad,num_points,start,end))
+            failed = 1;
+        maxentmc_quad_helper_get_moments(quad,moments);
+        for(k=0;k<moments->gsl_vec.size;++k){
+            maxentmc_power_vector_get_powers_ca(moments,k,p);
+            maxentmc_float_t const exact = test_common_gaussian_moment(p,2,s);
+            if(!(fabs(moments->gsl_vec.data[k]-exact) <= 1e-10*(1.0+exact))){
+                printf("test_quad_box: %s Gaussian moment [%u %u] is %.17g instead of %.17g\n",
+                       names[r],p[0],p[1],moments->gsl_vec.data[k],exact);
+                failed = 1;
+            }
+        }
+    }
+
+    maxentmc_quad_helper_free(quad);
+    maxentmc_power_vector_free(multipliers);
+    maxentmc_power_vector_free(moments);
+    maxentmc_quadrature_rule_cache_free();
+
+    puts((failed)?"test_quad_box: FAILED":"test_quad_box: passed");
+
+    return (failed)?-1:0;
+}
@@ -0,0 +1,97 @@
+/** This file is part of MaxEntMC, a maximum entropy algorithm with moment constraints. **/
+/** Copyright (C) 2014 Rafail V. Abramov.                                               **/
+/**                                                                                     **/
+/** This program is free software: you can redistribute it and/or modify it under the   **/
+/** terms of the GNU General Public License as published by the Free Software           **/
+/** Foundation, either version 3 of the License, or (at your option) any later version. **/
+/**                                                                                     **/
+/** This program is distributed in the hope that it will be useful, but WITHOUT ANY     **/
+/** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     **/
+/** PARTICULAR PURPOSE.  See the GNU General Public License for more details.           **/
+/**                                                                                     **/
+/** You should have received a copy of the GNU General Public License along with this   **/
+/** program.  If not, see <http://www.gnu.org/licenses/>.                               **/
+
+#include <stdlib.h>
+#include <math.h>
+#include "test_quad_bulk.h"
+#include "test_common.h"
+
+/** Moments of the standard Gaussian in 2D on a uniform grid, entered point by point, all at once in the
+    structure-of-arrays form, and in odd-sized pieces. The three must agree to rounding, and with the exact
+    Gaussian moments (the rectangle rule is spectrally accurate for the Gaussian) **/
+
+#define TEST_QUAD_BULK_DIM 2
+#define TEST_QUAD_BULK_POW 6
+#define TEST_QUAD_BULK_SIZE 60
+#define TEST_QUAD_BULK_AMP 8.0
+#define TEST_QUAD_BULK_CHUNK 7
+
+int test_quad_bulk(void)
+{
+    maxentmc_power_vector_t const multipliers = test_common_powers(TEST_QUAD_BULK_DIM,2);
+    maxentmc_power_vector_t moments[3];
+    maxentmc_index_t p[TEST_QUAD_BULK_DIM];
+    size_t const n = TEST_QUAD_BULK_SIZE*TEST_QUAD_BULK_SIZE;
+    maxentmc_float_t const dx = 2.0*TEST_QUAD_BULK_AMP/TEST_QUAD_BULK_SIZE;
+    size_t i, k;
+    int m, failed = 0;
+
+    test_common_gaussian_multipliers(multipliers,NULL);
+
+    maxentmc_float_t * const x0 = malloc(sizeof(maxentmc_float_t)*3*n);
+    maxentmc_float_t * const x1 = x0+n, * const w = x1+n;
+    maxentmc_float_t const * const x[TEST_QUAD_BULK_DIM] = {x0, x1};
+    for(i=0;i<n;++i){
+        x0[i] = -TEST_QUAD_BULK_AMP+(0.5+i%TEST_QUAD_BULK_SIZE)*dx;
+        x1[i] = -TEST_QUAD_BULK_AMP+(0.5+i/TEST_QUAD_BULK_SIZE)*dx;
+        w[i] = dx*dx;
+    }
+
+    maxentmc_quad_helper_t const quad = maxentmc_quad_helper_alloc(TEST_QUAD_BULK_DIM);
+
+    for(m=0;m<3;++m){
+        moments[m] = test_common_powers(TEST_QUAD_BULK_DIM,TEST_QUAD_BULK_POW);
+        maxentmc_quad_helper_set_multipliers(quad,multipliers);
+        maxentmc_quad_helper_set_moments(quad,moments[m]);
+        maxentmc_quad_helper_thread_t const qt = maxentmc_quad_helper_thread_alloc(quad);
+        if(m == 0){
+            for(i=0;i<n;++i){
+                maxentmc_float_t const y[TEST_QUAD_BULK_DIM] = {x0[i], x1[i]};
+                maxentmc_quad_helper_thread_compute_1(qt,y,w[i]);
+            }
+        }
+        else if(m == 1)
+            maxentmc_quad_helper_thread_compute_n(qt,n,x,w);
+        else{
+            for(i=0;i<n;i+=TEST_QUAD_BULK_CHUNK){
+                maxentmc_float_t const * const y[TEST_QUAD_BULK_DIM] = {x0+i, x1+i};
+                maxentmc_quad_helper_thread_compute_n(qt,(n-i<TEST_QUAD_BULK_CHUNK)?n-i:TEST_QUAD_BULK_CHUNK,y,w+i);
+            }
+        }
+        maxentmc_quad_helper_thread_merge(qt);
+        maxentmc_quad_helper_get_moments(quad,moments[m]);
+    }
+
+    for(k=0;k<moments[0]->gsl_vec.size;++k){
+        maxentmc_power_vector_get_powers_ca(moments[0],k,p);
+        maxentmc_float_t const exact = test_common_gaussian_moment(p,TEST_QUAD_BULK_DIM,NULL);
+        for(m=0;m<3;++m){
+            maxentmc_float_t const v = moments[m]->gsl_vec.data[k];
+            if(!(fabs(v-moments[0]->gsl_vec.data[k]) <= 1e-12*(1.0+fabs(exact))) || !(fabs(v-exact) <= 1e-10*(1.0+fabs(exact)))){
+                printf("test_quad_bulk: moment [%u %u] of input %d is %.17g, expected %.17g\n",p[0],p[1],m,v,exact);
+                failed = 1;
+            }
+        }
+    }
+
+    for(m=0;m<3;++m)
+        maxentmc_power_vector_free(moments[m]);
+    maxentmc_power_vector_free(multipliers);
+    maxentmc_quad_helper_free(quad);
+    free(x0);
+
+    puts((failed)?"test_quad_bulk: FAILED":"test_quad_bulk: passed");
+
+    return (failed)?-1:0;
+}
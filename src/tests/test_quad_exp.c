@@ -0,0 +1,77 @@
+/** This file is part of MaxEntMC, a maximum entropy algorithm with moment constraints. **/
+/** Copyright (C) 2014 Rafail V. Abramov.                                               **/
+/**                                                                                     **/
+/** This program is free software: you can redistribute it and/or modify it under the   **/
+/** terms of the GNU General Public License as published by the Free Software           **/
+/** Foundation, either version 3 of the License, or (at your option) any later version. **/
+/**                                                                                     **/
+/** This program is distributed in the hope that it will be useful, but WITHOUT ANY     **/
+/** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     **/
+/** PARTICULAR PURPOSE.  See the GNU General Public License for more details.           **/
+/**                                                                                     **/
+/** You should have received a copy of the GNU General Public License along with this   **/
+/** program.  If not, see <http://www.gnu.org/licenses/>.                               **/
+
+#include <math.h>
+#include "test_quad_exp.h"
+
+/** The exponential of the quadrature kernels in its three accuracy modes against exp of the C library: with the
+    multipliers 0 + x in 1D, the zero moment of a single point x with unit weight is exp(x). The points are entered
+    in bulk, so that they go through the vectorized kernel **/
+
+#define TEST_QUAD_EXP_POINTS 4001
+#define TEST_QUAD_EXP_AMP 700.0
+
+int test_quad_exp(void)
+{
+    maxentmc_list_t list = maxentmc_list_alloc(1,1,MAXENTMC_LIST_ORDERED,MAXENTMC_LIST_ASCEND);
+    maxentmc_list_insert(list,(maxentmc_index_t)0,0.0);
+    maxentmc_list_insert(list,(maxentmc_index_t)1,1.0);
+    maxentmc_power_vector_t multipliers;
+    maxentmc_list_create_power_vectors(list,&multipliers);
+    maxentmc_list_clear(list);
+    maxentmc_list_insert(list,(maxentmc_index_t)0,0.0);
+    maxentmc_power_vector_t moments;
+    maxentmc_list_create_power_vectors(list,&moments);
+    maxentmc_list_free(list);
+
+    maxentmc_quad_helper_t const quad = maxentmc_quad_helper_alloc(1);
+
+    enum MAXENTMC_QUAD_HELPER_EXP_MODE const mode[3] = {MAXENTMC_QUAD_HELPER_EXP_FAST, MAXENTMC_QUAD_HELPER_EXP_ACCURATE,
+                                                        MAXENTMC_QUAD_HELPER_EXP_FULL};
+    char const * const name[3] = {"fast", "accurate", "full"};
+    maxentmc_float_t const tolerance[3] = {2e-7, 2e-12, 4e-16};
+    int m, failed = 0;
+
+    for(m=0;m<3;++m){
+        maxentmc_float_t max_error = 0.0;
+        size_t k;
+        maxentmc_quad_helper_set_exp_mode(quad,mode[m]);
+        for(k=0;k<TEST_QUAD_EXP_POINTS;++k){
+            maxentmc_float_t const x = -TEST_QUAD_EXP_AMP+(2.0*TEST_QUAD_EXP_AMP*k)/(TEST_QUAD_EXP_POINTS-1)+1e-3*sin((double)k);
+            maxentmc_float_t const w = 1.0;
+            maxentmc_float_t const * const y = &x;
+            maxentmc_quad_helper_set_multipliers(quad,multipliers);
+            maxentmc_quad_helper_set_moments(quad,moments);
+            maxentmc_quad_helper_thread_t const qt = maxentmc_quad_helper_thread_alloc(quad);
+            maxentmc_quad_helper_thread_compute_n(qt,1,&y,&w);
+            maxentmc_quad_helper_thread_merge(qt);
+            maxentmc_quad_helper_get_moments(quad,moments);
+            maxentmc_float_t const error = fabs(moments->gsl_vec.data[0]/exp(x)-1.0);
+            if(!(error <= max_error))
+                max_error = error;
+        }
+        if(!(max_error <= tolerance[m])){
+            printf("test_quad_exp: relative error of the %s exponential is %g, more than %g\n",name[m],max_error,tolerance[m]);
+            failed = 1;
+        }
+    }
+
+    maxentmc_power_vector_free(moments);
+    maxentmc_power_vector_free(multipliers);
+    maxentmc_quad_helper_free(quad);
+
+    puts((failed)?"test_quad_exp: FAILED":"test_quad_exp: passed");
+
+    return (failed)?-1:0;
+}
@@ -0,0 +1,163 @@
+/** This file is part of MaxEntMC, a maximum entropy algorithm with moment constraints. **/
+/** Copyright (C) 2014 Rafail V. Abramov.                                               **/
+/**                                                                                     **/
+/** This program is free software: you can redistribute it and/or modify it under the   **/
+/** terms of the GNU General Public License as published by the Free Software           **/
+/** Foundation, either version 3 of the License, or (at your option) any later version. **/
+/**                                                                                     **/
+/** This program is distributed in the hope that it will be useful, but WITHOUT ANY     **/
+/** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     **/
+/** PARTICULAR PURPOSE.  See the GNU General Public License for more details.           **/
+/**                                                                                     **/
+/** You should have received a copy of the GNU General Public License along with this   **/
+/** program.  If not, see <http://www.gnu.org/licenses/>.                               **/
+
+#include <math.h>
+#include "test_quad_gauss_hermite.h"
+#include "test_common.h"
+
+/** Gauss-Hermite rules with 1 to 100 nodes must integrate the standard Gaussian moments up to the degree they are exact
+    for, plain and corrected. Then the tensor rule, corrected and aligned with the shift and rotation of the constraints,
+    must give the moments of a correlated Gaussian in two dimensions up to degree 4 in closed form **/
+
+#define TEST_QUAD_GAUSS_HERMITE_MAX_NODES 100
+#define TEST_QUAD_GAUSS_HERMITE_MAX_POW 4
+
+/** Centered moment E[X^i Y^j] of a Gaussian with covariance s, for i+j up to 4 **/
+
+static maxentmc_float_t test_quad_gauss_hermite_centered(size_t const i, size_t const j, maxentmc_float_t const s[3])
+{
+    switch(10*i+j){
+        case 0: return 1.0;
+        case 20: return s[0];
+        case 11: return s[1];
+        case 2: return s[2];
+        case 40: return 3.0*s[0]*s[0];
+        case 31: return 3.0*s[0]*s[1];
+        case 22: return s[0]*s[2]+2.0*s[1]*s[1];
+        case 13: return 3.0*s[2]*s[1];
+        case 4: return 3.0*s[2]*s[2];
+        default: return 0.0;
+    }
+}
+
+static maxentmc_float_t test_quad_gauss_hermite_binomial(size_t const n, size_t const k)
+{
+    maxentmc_float_t b = 1.0;
+    size_t i;
+    for(i=0;i<k;++i)
+        b = b*(n-i)/(i+1);
+    return b;
+}
+
+int test_quad_gauss_hermite(void)
+{
+    maxentmc_float_t const pi = 4.0*atan(1.0);
+    maxentmc_power_vector_t const uniform = test_common_powers(1,0);
+    maxentmc_power_vector_t const standard = test_common_powers(1,2);
+    maxentmc_power_vector_t const moments = test_common_powers(1,TEST_QUAD_GAUSS_HERMITE_MAX_POW);
+    maxentmc_float_t exact[TEST_QUAD_GAUSS_HERMITE_MAX_POW+1];
+    maxentmc_quad_helper_t quad = maxentmc_quad_helper_alloc(1);
+    maxentmc_index_t k_pow;
+    size_t n, k;
+    int corrected, failed = 0;
+
+    test_common_gaussian_multipliers(standard,NULL);
+
+    for(k=0;k<=TEST_QUAD_GAUSS_HERMITE_MAX_POW;++k){
+        maxentmc_power_vector_get_powers_ca(moments,k,&k_pow);
+        exact[k] = test_common_gaussian_moment(&k_pow,1,NULL);
+    }
+
+    for(corrected=0;corrected<2;++corrected)
+        for(n=1;n<=TEST_QUAD_GAUSS_HERMITE_MAX_NODES;++n){
+            maxentmc_quad_helper_set_multipliers(quad,(corrected)?standard:uniform);
+            maxentmc_quad_helper_set_moments(quad,moments);
+            if((corrected)?maxentmc_quadrature_gauss_hermite_corrected_ca(quad,&n,1.0):maxentmc_quadrature_gauss_hermite_ca(quad,&n)){
+                printf("test_quad_gauss_hermite: %s rule with %zu nodes failed\n",(corrected)?"corrected":"plain",n);
+                failed = 1;
+                maxentmc_quad_helper_get_moments(quad,moments);
+                continue;
+            }
+            maxentmc_quad_helper_get_moments(quad,moments);
+            for(k=0;k<=TEST_QUAD_GAUSS_HERMITE_MAX_POW && k<2*n;++k)
+                if(!(fabs(moments->gsl_vec.data[k]-exact[k]) <= 1e-12*(1.0+exact[k]))){
+                    printf("test_quad_gauss_hermite: moment %zu of the %s rule with %zu nodes is %.17g\n",
+                           k,(corrected)?"corrected":"plain",n,moments->gsl_vec.data[k]);
+                    failed = 1;
+                }
+        }
+
+    maxentmc_quad_helper_free(quad);
+    maxentmc_power_vector_free(uniform);
+    maxentmc_power_vector_free(standard);
+    maxentmc_power_vector_free(moments);
+
+    /** Mean m and covariance s = [s[0] s[1]; s[1] s[2]], the multipliers are the logarithm of the density **/
+
+    maxentmc_float_t const m[2] = {0.5, -0.3};
+    maxentmc_float_t const s[3] = {1.0, 0.6, 2.0};
+    maxentmc_float_t const det = s[0]*s[2]-s[1]*s[1];
+    maxentmc_float_t const inv[3] = {s[2]/det, -s[1]/det, s[0]/det};
+    size_t const num_points[2] = {5, 8};
+    maxentmc_power_vector_t const constraints = test_common_powers(2,2);
+    maxentmc_power_vector_t const multipliers = test_common_powers(2,2);
+    maxentmc_power_vector_t const gaussian = test_common_powers(2,TEST_QUAD_GAUSS_HERMITE_MAX_POW);
+    maxentmc_index_t p[2];
+
+    for(k=0;k<gaussian->gsl_vec.size;++k){
+        maxentmc_power_vector_get_powers_ca(gaussian,k,p);
+        maxentmc_float_t v = 0.0;
+        size_t i, j;
+        for(i=0;i<=p[0];++i)
+            for(j=0;j<=p[1];++j)
+                v += test_quad_gauss_hermite_binomial(p[0],i)*test_quad_gauss_hermite_binomial(p[1],j)
+                     *pow(m[0],p[0]-i)*pow(m[1],p[1]-j)*test_quad_gauss_hermite_centered(i,j,s);
+        gaussian->gsl_vec.data[k] = v;
+        if(p[0]+p[1] <= 2){
+            size_t pos;
+            maxentmc_power_vector_find_element_ca(constraints,p,&pos);
+            constraints->gsl_vec.data[pos] = v;
+            maxentmc_float_t lambda;
+            switch(10*p[0]+p[1]){
+                case 0: lambda = -0.5*(inv[0]*m[0]*m[0]+2.0*inv[1]*m[0]*m[1]+inv[2]*m[1]*m[1])-log(2.0*pi*sqrt(det)); break;
+                case 10: lambda = inv[0]*m[0]+inv[1]*m[1]; break;
+                case 1: lambda = inv[1]*m[0]+inv[2]*m[1]; break;
+                case 20: lambda = -0.5*inv[0]; break;
+                case 11: lambda = -inv[1]; break;
+                default: lambda = -0.5*inv[2]; break;
+            }
+            multipliers->gsl_vec.data[pos] = lambda;
+        }
+    }
+
+    maxentmc_power_vector_t const computed = test_common_powers(2,TEST_QUAD_GAUSS_HERMITE_MAX_POW);
+
+    quad = maxentmc_quad_helper_alloc(2);
+    maxentmc_quad_helper_set_shift_rotation(quad,constraints);
+    maxentmc_quad_helper_set_multipliers(quad,multipliers);
+    maxentmc_quad_helper_set_moments(quad,computed);
+    if(maxentmc_quadrature_gauss_hermite_corrected_ca(quad,num_points,1.0))
+        failed = 1;
+    maxentmc_quad_helper_get_moments(quad,computed);
+
+    for(k=0;k<computed->gsl_vec.size;++k){
+        maxentmc_float_t const v = gaussian->gsl_vec.data[k];
+        if(!(fabs(computed->gsl_vec.data[k]-v) <= 1e-12*(1.0+fabs(v)))){
+            maxentmc_power_vector_get_powers_ca(computed,k,p);
+            printf("test_quad_gauss_hermite: Gaussian moment [%u %u] is %.17g instead of %.17g\n",
+                   p[0],p[1],computed->gsl_vec.data[k],v);
+            failed = 1;
+        }
+    }
+
+    maxentmc_quad_helper_free(quad);
+    maxentmc_power_vector_free(constraints);
+    maxentmc_power_vector_free(multipliers);
+    maxentmc_power_vector_free(gaussian);
+    maxentmc_power_vector_free(computed);
+
+    puts((failed)?"test_quad_gauss_hermite: FAILED":"test_quad_gauss_hermite: passed");
+
+    return (failed)?-1:0;
+}
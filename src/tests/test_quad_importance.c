@@ -0,0 +1,138 @@
+/** This file is part of MaxEntMC, a maximum entropy algorithm with moment constraints. **/
+/** Copyright (C) 2014 Rafail V. Abramov.                                               **/
+/**                                                                                     **/
+/** This program is free software: you can redistribute it and/or modify it under the   **/
+/** terms of the GNU General Public License as published by the Free Software           **/
+/** Foundation, either version 3 of the License, or (at your option) any later version. **/
+/**                                                                                     **/
+/** This program is distributed in the hope that it will be useful, but WITHOUT ANY     **/
+/** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     **/
+/** PARTICULAR PURPOSE.  See the GNU General Public License for more details.           **/
+/**                                                                                     **/
+/** You should have received a copy of the GNU General Public License along with this   **/
+/** program.  If not, see <http://www.gnu.org/licenses/>.                               **/
+
+#include <math.h>
+#include <string.h>
+#include "test_quad_importance.h"
+#include "test_common.h"
+
+/** The importance sampled moments of a Gaussian must agree with the closed form within the Monte Carlo error, must not
+    depend on the number of threads with the deterministic reduction or on the helpers sharing the pass, and seeds differing by a multiple of the generator's
+    increment must not give the same samples shifted by one **/
+
+#define TEST_QUAD_IMPORTANCE_NUM_SAMPLES 100000
+#define TEST_QUAD_IMPORTANCE_WIDTH 1.5
+#define TEST_QUAD_IMPORTANCE_SEED 20140101
+#define TEST_QUAD_IMPORTANCE_INCREMENT 0x9E3779B97F4A7C15ULL
+#define TEST_QUAD_IMPORTANCE_NUM_THREADS 4
+
+static int test_quad_importance_pass(maxentmc_quad_helper_t const quad, maxentmc_power_vector_t const multipliers,
+                                     maxentmc_power_vector_t const moments, size_t const num_samples, uint64_t const seed)
+{
+    maxentmc_quad_helper_set_multipliers(quad,multipliers);
+    maxentmc_quad_helper_set_moments(quad,moments);
+    if(maxentmc_quadrature_importance_ca(quad,num_samples,TEST_QUAD_IMPORTANCE_WIDTH,seed))
+        return -1;
+    return maxentmc_quad_helper_get_moments(quad,moments);
+}
+
+int test_quad_importance(void)
+{
+    maxentmc_power_vector_t const multipliers = test_common_powers(2,2);
+    maxentmc_power_vector_t const moments = test_common_powers(2,4);
+    maxentmc_power_vector_t const threaded = test_common_powers(2,4);
+    maxentmc_power_vector_t const first = test_common_powers(2,4);
+    maxentmc_power_vector_t const second = test_common_powers(2,4);
+    maxentmc_power_vector_t const shifted = test_common_powers(2,4);
+    maxentmc_quad_helper_t const quad = maxentmc_quad_helper_alloc(2);
+    maxentmc_index_t p[2];
+    size_t k;
+    int failed = 0;
+
+    /** Standard Gaussian in two dimensions **/
+
+    test_common_gaussian_multipliers(multipliers,NULL);
+
+    maxentmc_quad_helper_set_reduction_mode(quad,MAXENTMC_QUAD_HELPER_REDUCTION_DETERMINISTIC);
+    if(test_quad_importance_pass(quad,multipliers,moments,TEST_QUAD_IMPORTANCE_NUM_SAMPLES,TEST_QUAD_IMPORTANCE_SEED))
+        failed = 1;
+
+    for(k=0;k<moments->gsl_vec.size;++k){
+        maxentmc_power_vector_get_powers_ca(moments,k,p);
+        maxentmc_float_t const exact = test_common_gaussian_moment(p,2,NULL);
+        if(!(fabs(moments->gsl_vec.data[k]-exact) <= 0.05*(1.0+exact))){
+            printf("test_quad_importance: Gaussian moment [%u %u] is %.17g instead of %.17g\n",
+                   p[0],p[1],moments->gsl_vec.data[k],exact);
+            failed = 1;
+        }
+    }
+
+    /** Every sample depends on the seed and its index alone, so a pool of threads gives the same moments bitwise **/
+
+    maxentmc_thread_pool_t const pool = maxentmc_thread_pool_alloc(TEST_QUAD_IMPORTANCE_NUM_THREADS);
+    maxentmc_quad_helper_t const threaded_quad = maxentmc_quad_helper_alloc(2);
+    maxentmc_quad_helper_set_reduction_mode(threaded_quad,MAXENTMC_QUAD_HELPER_REDUCTION_DETERMINISTIC);
+    maxentmc_quad_helper_set_thread_pool(threaded_quad,pool);
+    if(test_quad_importance_pass(threaded_quad,multipliers,threaded,TEST_QUAD_IMPORTANCE_NUM_SAMPLES,TEST_QUAD_IMPORTANCE_SEED))
+        failed = 1;
+    if(memcmp(moments->gsl_vec.data,threaded->gsl_vec.data,moments->gsl_vec.size*sizeof(maxentmc_float_t))){
+        printf("test_quad_importance: %d threads give different moments than one\n",TEST_QUAD_IMPORTANCE_NUM_THREADS);
+        failed = 1;
+    }
+
+    /** Several helpers in one pass see the same samples as one helper alone **/
+
+    maxentmc_quad_helper_t multi[2] = {threaded_quad, maxentmc_quad_helper_alloc(2)};
+    maxentmc_quad_helper_set_reduction_mode(multi[1],MAXENTMC_QUAD_HELPER_REDUCTION_DETERMINISTIC);
+    for(k=0;k<2;++k){
+        maxentmc_quad_helper_set_multipliers(multi[k],multipliers);
+        maxentmc_quad_helper_set_moments(multi[k],(k == 0)?threaded:shifted);
+    }
+    if(maxentmc_quadrature_importance_multi_ca(multi,2,TEST_QUAD_IMPORTANCE_NUM_SAMPLES,TEST_QUAD_IMPORTANCE_WIDTH,TEST_QUAD_IMPORTANCE_SEED) ||
+       maxentmc_quad_helper_get_moments(multi[0],threaded) || maxentmc_quad_helper_get_moments(multi[1],shifted))
+        failed = 1;
+    if(memcmp(moments->gsl_vec.data,threaded->gsl_vec.data,moments->gsl_vec.size*sizeof(maxentmc_float_t)) ||
+       memcmp(moments->gsl_vec.data,shifted->gsl_vec.data,moments->gsl_vec.size*sizeof(maxentmc_float_t))){
+        puts("test_quad_importance: helpers in one pass give different moments than one helper alone");
+        failed = 1;
+    }
+    maxentmc_quad_helper_free(multi[1]);
+    maxentmc_quad_helper_free(threaded_quad);
+    maxentmc_thread_pool_free(pool);
+
+    /** Another seed gives another estimate **/
+
+    if(test_quad_importance_pass(quad,multipliers,threaded,TEST_QUAD_IMPORTANCE_NUM_SAMPLES,TEST_QUAD_IMPORTANCE_SEED+1))
+        failed = 1;
+    if(!memcmp(moments->gsl_vec.data,threaded->gsl_vec.data,moments->gsl_vec.size*sizeof(maxentmc_float_t))){
+        puts("test_quad_importance: different seeds give the same moments");
+        failed = 1;
+    }
+
+    /** In two dimensions a sample takes two counters, so if the seed were only added to the counter times the increment,
+        the first sample of the seed plus twice the increment would be the second sample of the seed. The weights are
+        divided by the number of samples, which recovers the second sample from the passes with one and two samples. **/
+
+    if(test_quad_importance_pass(quad,multipliers,first,1,TEST_QUAD_IMPORTANCE_SEED) ||
+       test_quad_importance_pass(quad,multipliers,second,2,TEST_QUAD_IMPORTANCE_SEED) ||
+       test_quad_importance_pass(quad,multipliers,shifted,1,TEST_QUAD_IMPORTANCE_SEED+2*TEST_QUAD_IMPORTANCE_INCREMENT))
+        failed = 1;
+    maxentmc_float_t const sample = 2.0*second->gsl_vec.data[0]-first->gsl_vec.data[0];
+    if(fabs(shifted->gsl_vec.data[0]-sample) <= 1e-10*fabs(sample)){
+        puts("test_quad_importance: seeds differing by a multiple of the increment give shifted samples");
+        failed = 1;
+    }
+
+    maxentmc_quad_helper_free(quad);
+    maxentmc_power_vector_free(multipliers);
+    maxentmc_power_vector_free(moments);
+    maxentmc_power_vector_free(threaded);
+    maxentmc_power_vector_free(first);
+    maxentmc_power_vector_free(second);
+    maxentmc_power_vector_free(shifted);
+
+    puts((failed)?"test_quad_importance: FAILED":"test_quad_importance: passed");
+
+    return (failed)?-1:0;
+}
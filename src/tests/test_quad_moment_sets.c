@@ -0,0 +1,111 @@
+/** This file is part of MaxEntMC, a maximum entropy algorithm with moment constraints. **/
+/** Copyright (C) 2014 Rafail V. Abramov.                                               **/
+/**                                                                                     **/
+/** This program is free software: you can redistribute it and/or modify it under the   **/
+/** terms of the GNU General Public License as published by the Free Software           **/
+/** Foundation, either version 3 of the License, or (at your option) any later version. **/
+/**                                                                                     **/
+/** This program is distributed in the hope that it will be useful, but WITHOUT ANY     **/
+/** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     **/
+/** PARTICULAR PURPOSE.  See the GNU General Public License for more details.           **/
+/**                                                                                     **/
+/** You should have received a copy of the GNU General Public License along with this   **/
+/** program.  If not, see <http://www.gnu.org/licenses/>.                               **/
+
+#include <math.h>
+#include "test_quad_moment_sets.h"
+#include "test_common.h"
+
+/** Several moment sets armed in one pass (sharing the monomials of one plan) against the same sets computed in
+    separate passes: all powers up to total degree 2 and 8, and all powers up to 3 in each coordinate. The moments
+    that appear in several sets must also agree within the pass, and no set can be added once an accumulator of the
+    pass is allocated **/
+
+#define TEST_QUAD_MOMENT_SETS_DIM 2
+#define TEST_QUAD_MOMENT_SETS_NUM 3
+#define TEST_QUAD_MOMENT_SETS_SIZE 50
+#define TEST_QUAD_MOMENT_SETS_AMP 6.0
+
+int test_quad_moment_sets(void)
+{
+    maxentmc_power_vector_t const multipliers = test_common_powers_bounded(TEST_QUAD_MOMENT_SETS_DIM,4,4);
+    maxentmc_power_vector_t together[TEST_QUAD_MOMENT_SETS_NUM], alone[TEST_QUAD_MOMENT_SETS_NUM];
+    maxentmc_index_t const total_pow[TEST_QUAD_MOMENT_SETS_NUM] = {2, 8, 6};
+    maxentmc_index_t const max_pow[TEST_QUAD_MOMENT_SETS_NUM] = {2, 8, 3};
+    maxentmc_index_t p[TEST_QUAD_MOMENT_SETS_DIM];
+    size_t num_points[TEST_QUAD_MOMENT_SETS_DIM];
+    maxentmc_float_t start[TEST_QUAD_MOMENT_SETS_DIM], end[TEST_QUAD_MOMENT_SETS_DIM];
+    size_t k;
+    int s, failed = 0;
+
+    for(k=0;k<multipliers->gsl_vec.size;++k){
+        maxentmc_power_vector_get_powers_ca(multipliers,k,p);
+        if(p[0]+p[1] == 0)
+            multipliers->gsl_vec.data[k] = -log(8.0*atan(1.0));
+        else if(p[0] == 2 || p[1] == 2)
+            multipliers->gsl_vec.data[k] = -0.5;
+        else
+            multipliers->gsl_vec.data[k] = (p[0]+p[1] == 4)?-0.01:0.05*sin(1.0+k);
+    }
+
+    for(k=0;k<TEST_QUAD_MOMENT_SETS_DIM;++k){
+        num_points[k] = TEST_QUAD_MOMENT_SETS_SIZE;
+        start[k] = -TEST_QUAD_MOMENT_SETS_AMP;
+        end[k] = TEST_QUAD_MOMENT_SETS_AMP;
+    }
+
+    maxentmc_quad_helper_t const quad = maxentmc_quad_helper_alloc(TEST_QUAD_MOMENT_SETS_DIM);
+
+    for(s=0;s<TEST_QUAD_MOMENT_SETS_NUM;++s){
+        together[s] = test_common_powers_bounded(TEST_QUAD_MOMENT_SETS_DIM,total_pow[s],max_pow[s]);
+        alone[s] = test_common_powers_bounded(TEST_QUAD_MOMENT_SETS_DIM,total_pow[s],max_pow[s]);
+    }
+
+    maxentmc_quad_helper_set_multipliers(quad,multipliers);
+    maxentmc_quad_helper_set_moments(quad,together[0]);
+    maxentmc_quad_helper_thread_t const qt = maxentmc_quad_helper_thread_alloc(quad);
+    if(qt == NULL || !maxentmc_quad_helper_add_moments(quad,together[1])){
+        puts("test_quad_moment_sets: a moment set was added with an accumulator of the pass allocated");
+        failed = 1;
+    }
+    maxentmc_quad_helper_thread_merge(qt);
+    for(s=1;s<TEST_QUAD_MOMENT_SETS_NUM;++s)
+        maxentmc_quad_helper_add_moments(quad,together[s]);
+    if(maxentmc_quadrature_rectangle_uniform_ca(quad,num_points,start,end))
+        failed = 1;
+    for(s=0;s<TEST_QUAD_MOMENT_SETS_NUM;++s)
+        maxentmc_quad_helper_get_moments(quad,together[s]);
+
+    for(s=0;s<TEST_QUAD_MOMENT_SETS_NUM;++s){
+        maxentmc_quad_helper_set_multipliers(quad,multipliers);
+        maxentmc_quad_helper_set_moments(quad,alone[s]);
+        if(maxentmc_quadrature_rectangle_uniform_ca(quad,num_points,start,end))
+            failed = 1;
+        maxentmc_quad_helper_get_moments(quad,alone[s]);
+    }
+
+    for(s=0;s<TEST_QUAD_MOMENT_SETS_NUM;++s)
+        for(k=0;k<together[s]->gsl_vec.size;++k){
+            maxentmc_float_t const v = together[s]->gsl_vec.data[k];
+            size_t pos;
+            maxentmc_power_vector_get_powers_ca(together[s],k,p);
+            maxentmc_power_vector_find_element_ca(together[1],p,&pos); /** The second set contains all the others **/
+            maxentmc_float_t const u = together[1]->gsl_vec.data[pos];
+            if(!(fabs(v-alone[s]->gsl_vec.data[k]) <= 1e-13*(1.0+fabs(v))) || !(fabs(v-u) <= 1e-13*(1.0+fabs(v)))){
+                printf("test_quad_moment_sets: moment [%u %u] of set %d is %.17g in one pass, %.17g alone, %.17g in set 1\n",
+                       p[0],p[1],s,v,alone[s]->gsl_vec.data[k],u);
+                failed = 1;
+            }
+        }
+
+    for(s=0;s<TEST_QUAD_MOMENT_SETS_NUM;++s){
+        maxentmc_power_vector_free(together[s]);
+        maxentmc_power_vector_free(alone[s]);
+    }
+    maxentmc_power_vector_free(multipliers);
+    maxentmc_quad_helper_free(quad);
+
+    puts((failed)?"test_quad_moment_sets: FAILED":"test_quad_moment_sets: passed");
+
+    return (failed)?-1:0;
+}
@@ -0,0 +1,100 @@
+/** This file is part of MaxEntMC, a maximum entropy algorithm with moment constraints. **/
+/** Copyright (C) 2014 Rafail V. Abramov.                                               **/
+/**                                                                                     **/
+/** This program is free software: you can redistribute it and/or modify it under the   **/
+/** terms of the GNU General Public License as published by the Free Software           **/
+/** Foundation, either version 3 of the License, or (at your option) any later version. **/
+/**                                                                                     **/
+/** This program is distributed in the hope that it will be useful, but WITHOUT ANY     **/
+/** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     **/
+/** PARTICULAR PURPOSE.  See the GNU General Public License for more details.           **/
+/**                                                                                     **/
+/** You should have received a copy of the GNU General Public License along with this   **/
+/** program.  If not, see <http://www.gnu.org/licenses/>.                               **/
+
+#include <math.h>
+#include "test_quad_mpi.h"
+#include "test_common.h"
+
+/** A quadrature split over the ranks of MPI_COMM_WORLD must give the moments every rank computes alone, and a helper
+    computes alone until it is given a communicator **/
+
+#define TEST_QUAD_MPI_DIM 2
+#define TEST_QUAD_MPI_SIZE 60
+#define TEST_QUAD_MPI_AMP 8.0
+
+int test_quad_mpi(void)
+{
+    maxentmc_power_vector_t const multipliers = test_common_powers(TEST_QUAD_MPI_DIM,4);
+    maxentmc_power_vector_t const alone = test_common_powers(TEST_QUAD_MPI_DIM,6);
+    maxentmc_power_vector_t const split = test_common_powers(TEST_QUAD_MPI_DIM,6);
+    size_t const num_points[TEST_QUAD_MPI_DIM] = {TEST_QUAD_MPI_SIZE, TEST_QUAD_MPI_SIZE};
+    maxentmc_float_t const start[TEST_QUAD_MPI_DIM] = {-TEST_QUAD_MPI_AMP, -TEST_QUAD_MPI_AMP};
+    maxentmc_float_t const end[TEST_QUAD_MPI_DIM] = {TEST_QUAD_MPI_AMP, TEST_QUAD_MPI_AMP};
+    maxentmc_index_t p[TEST_QUAD_MPI_DIM];
+    int rank, world_rank, world_size, num_ranks;
+    size_t k;
+    int failed = 0;
+
+    MPI_Comm_rank(MPI_COMM_WORLD,&world_rank);
+    MPI_Comm_size(MPI_COMM_WORLD,&world_size);
+
+    for(k=0;k<multipliers->gsl_vec.size;++k){
+        maxentmc_power_vector_get_powers_ca(multipliers,k,p);
+        if(p[0]+p[1] == 0)
+            multipliers->gsl_vec.data[k] = -log(8.0*atan(1.0));
+        else if(p[0]+p[1] == 2)
+            multipliers->gsl_vec.data[k] = (p[0] == 1)?0.1:-0.5;
+        else
+            multipliers->gsl_vec.data[k] = (p[0]+p[1] == 4)?-0.01:0.05*sin(1.0+k);
+    }
+
+    maxentmc_quad_helper_t const quad = maxentmc_quad_helper_alloc(TEST_QUAD_MPI_DIM);
+
+    maxentmc_quad_helper_get_rank(quad,&rank,&num_ranks);
+    if(rank != 0 || num_ranks != 1){
+        printf("test_quad_mpi: rank %d: a new helper is rank %d of %d\n",world_rank,rank,num_ranks);
+        failed = 1;
+    }
+
+    maxentmc_quad_helper_set_multipliers(quad,multipliers);
+    maxentmc_quad_helper_set_moments(quad,alone);
+    if(maxentmc_quadrature_rectangle_uniform_ca(quad,num_points,start,end))
+        failed = 1;
+    maxentmc_quad_helper_get_moments(quad,alone);
+
+    maxentmc_quad_helper_set_communicator(quad,MPI_COMM_WORLD);
+    maxentmc_quad_helper_get_rank(quad,&rank,&num_ranks);
+    if(rank != world_rank || num_ranks != world_size){
+        printf("test_quad_mpi: rank %d: helper with MPI_COMM_WORLD is rank %d of %d\n",world_rank,rank,num_ranks);
+        failed = 1;
+    }
+
+    maxentmc_quad_helper_set_multipliers(quad,multipliers);
+    maxentmc_quad_helper_set_moments(quad,split);
+    if(maxentmc_quadrature_rectangle_uniform_ca(quad,num_points,start,end))
+        failed = 1;
+    maxentmc_quad_helper_get_moments(quad,split);
+
+    for(k=0;k<split->gsl_vec.size;++k){
+        maxentmc_float_t const v = split->gsl_vec.data[k];
+        if(!(fabs(v-alone->gsl_vec.data[k]) <= 1e-13*(1.0+fabs(v)))){
+            maxentmc_power_vector_get_powers_ca(split,k,p);
+            printf("test_quad_mpi: rank %d: moment [%u %u] is %.17g over %d ranks and %.17g alone\n",
+                   world_rank,p[0],p[1],v,world_size,alone->gsl_vec.data[k]);
+            failed = 1;
+        }
+    }
+
+    maxentmc_quad_helper_free(quad);
+    maxentmc_power_vector_free(multipliers);
+    maxentmc_power_vector_free(alone);
+    maxentmc_power_vector_free(split);
+
+    MPI_Allreduce(MPI_IN_PLACE,&failed,1,MPI_INT,MPI_MAX,MPI_COMM_WORLD);
+
+    if(world_rank == 0)
+        printf("test_quad_mpi: %s on %d ranks\n",(failed)?"FAILED":"passed",world_size);
+
+    return (failed)?-1:0;
+}
@@ -0,0 +1,115 @@
+/** This file is part of MaxEntMC, a maximum entropy algorithm with moment constraints. **/
+/** Copyright (C) 2014 Rafail V. Abramov.                                               **/
+/**                                                                                     **/
+/** This program is free software: you can redistribute it and/or modify it under the   **/
+/** terms of the GNU General Public License as published by the Free Software           **/
+/** Foundation, either version 3 of the License, or (at your option) any later version. **/
+/**                                                                                     **/
+/** This program is distributed in the hope that it will be useful, but WITHOUT ANY     **/
+/** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     **/
+/** PARTICULAR PURPOSE.  See the GNU General Public License for more details.           **/
+/**                                                                                     **/
+/** You should have received a copy of the GNU General Public License along with this   **/
+/** program.  If not, see <http://www.gnu.org/licenses/>.                               **/
+
+#include <math.h>
+#include <string.h>
+#include "test_quad_qmc.h"
+#include "test_common.h"
+
+/** The randomized Halton moments of a Gaussian must agree with the closed form within a few standard errors, the errors
+    must shrink with the number of points, and the same seed must reproduce the same moments **/
+
+#define TEST_QUAD_QMC_NUM_POINTS 1024
+#define TEST_QUAD_QMC_NUM_RANDOMIZATIONS 16
+#define TEST_QUAD_QMC_WIDTH 1.5
+#define TEST_QUAD_QMC_SEED 20140101
+#define TEST_QUAD_QMC_NUM_ERRORS 5.0
+
+/** Sum of the standard errors over all moments **/
+
+static maxentmc_float_t test_quad_qmc_total_error(maxentmc_power_vector_t const error)
+{
+    maxentmc_float_t sum = 0.0;
+    size_t k;
+    for(k=0;k<error->gsl_vec.size;++k)
+        sum += error->gsl_vec.data[k];
+    return sum;
+}
+
+int test_quad_qmc(void)
+{
+    maxentmc_power_vector_t const multipliers = test_common_powers(2,2);
+    maxentmc_power_vector_t const moments = test_common_powers(2,4);
+    maxentmc_power_vector_t const error = test_common_powers(2,4);
+    maxentmc_power_vector_t const repeat = test_common_powers(2,4);
+    maxentmc_power_vector_t const repeat_error = test_common_powers(2,4);
+    maxentmc_quad_helper_t const quad = maxentmc_quad_helper_alloc(2);
+    maxentmc_index_t p[2];
+    size_t k;
+    int failed = 0;
+
+    /** Standard Gaussian in two dimensions **/
+
+    test_common_gaussian_multipliers(multipliers,NULL);
+
+    if(maxentmc_quadrature_qmc_moments(quad,multipliers,moments,error,TEST_QUAD_QMC_NUM_POINTS,
+                                       TEST_QUAD_QMC_NUM_RANDOMIZATIONS,TEST_QUAD_QMC_WIDTH,TEST_QUAD_QMC_SEED))
+        failed = 1;
+
+    for(k=0;k<moments->gsl_vec.size;++k){
+        maxentmc_power_vector_get_powers_ca(moments,k,p);
+        maxentmc_float_t const exact = test_common_gaussian_moment(p,2,NULL);
+        maxentmc_float_t const e = error->gsl_vec.data[k];
+        if(!(e >= 0.0 && e < 1e-2) ||
+           !(fabs(moments->gsl_vec.data[k]-exact) <= TEST_QUAD_QMC_NUM_ERRORS*e+1e-12)){
+            printf("test_quad_qmc: Gaussian moment [%u %u] is %.17g +- %.3g instead of %.17g\n",
+                   p[0],p[1],moments->gsl_vec.data[k],e,exact);
+            failed = 1;
+        }
+    }
+
+    /** The same seed reproduces the moments and errors bit for bit **/
+
+    if(maxentmc_quadrature_qmc_moments(quad,multipliers,repeat,repeat_error,TEST_QUAD_QMC_NUM_POINTS,
+                                       TEST_QUAD_QMC_NUM_RANDOMIZATIONS,TEST_QUAD_QMC_WIDTH,TEST_QUAD_QMC_SEED))
+        failed = 1;
+    if(memcmp(moments->gsl_vec.data,repeat->gsl_vec.data,moments->gsl_vec.size*sizeof(maxentmc_float_t)) ||
+       memcmp(error->gsl_vec.data,repeat_error->gsl_vec.data,error->gsl_vec.size*sizeof(maxentmc_float_t))){
+        puts("test_quad_qmc: the same seed gives different moments");
+        failed = 1;
+    }
+
+    /** Another seed gives another estimate **/
+
+    if(maxentmc_quadrature_qmc_moments(quad,multipliers,repeat,NULL,TEST_QUAD_QMC_NUM_POINTS,
+                                       TEST_QUAD_QMC_NUM_RANDOMIZATIONS,TEST_QUAD_QMC_WIDTH,TEST_QUAD_QMC_SEED+1))
+        failed = 1;
+    if(!memcmp(moments->gsl_vec.data,repeat->gsl_vec.data,moments->gsl_vec.size*sizeof(maxentmc_float_t))){
+        puts("test_quad_qmc: different seeds give the same moments");
+        failed = 1;
+    }
+
+    /** Sixteen times the points must give a clearly smaller error **/
+
+    if(maxentmc_quadrature_qmc_moments(quad,multipliers,repeat,repeat_error,16*TEST_QUAD_QMC_NUM_POINTS,
+                                       TEST_QUAD_QMC_NUM_RANDOMIZATIONS,TEST_QUAD_QMC_WIDTH,TEST_QUAD_QMC_SEED))
+        failed = 1;
+    if(!(test_quad_qmc_total_error(repeat_error) < 0.25*test_quad_qmc_total_error(error))){
+        printf("test_quad_qmc: error %.3g with %d points is not much smaller than %.3g with %d points\n",
+               test_quad_qmc_total_error(repeat_error),16*TEST_QUAD_QMC_NUM_POINTS,
+               test_quad_qmc_total_error(error),TEST_QUAD_QMC_NUM_POINTS);
+        failed = 1;
+    }
+
+    maxentmc_quad_helper_free(quad);
+    maxentmc_power_vector_free(multipliers);
+    maxentmc_power_vector_free(moments);
+    maxentmc_power_vector_free(error);
+    maxentmc_power_vector_free(repeat);
+    maxentmc_power_vector_free(repeat_error);
+
+    puts((failed)?"test_quad_qmc: FAILED":"test_quad_qmc: passed");
+
+    return (failed)?-1:0;
+}
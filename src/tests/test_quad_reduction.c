@@ -0,0 +1,127 @@
+/** This file is part of MaxEntMC, a maximum entropy algorithm with moment constraints. **/
+/** Copyright (C) 2014 Rafail V. Abramov.                                               **/
+/**                                                                                     **/
+/** This program is free software: you can redistribute it and/or modify it under the   **/
+/** terms of the GNU General Public License as published by the Free Software           **/
+/** Foundation, either version 3 of the License, or (at your option) any later version. **/
+/**                                                                                     **/
+/** This program is distributed in the hope that it will be useful, but WITHOUT ANY     **/
+/** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     **/
+/** PARTICULAR PURPOSE.  See the GNU General Public License for more details.           **/
+/**                                                                                     **/
+/** You should have received a copy of the GNU General Public License along with this   **/
+/** program.  If not, see <http://www.gnu.org/licenses/>.                               **/
+
+#include <math.h>
+#include <string.h>
+#include "test_quad_reduction.h"
+#include "test_common.h"
+
+/** In the deterministic and compensated reduction modes the moments must be bitwise identical for any number of
+    threads, including when the thread accumulators were last used by a pass with a larger moment set: each helper goes
+    through moment sets of decreasing total degree, so that for any cache size some pass could reuse buffers laid out
+    with a smaller tile than its own, and the rows are longer than a tile **/
+
+#define TEST_QUAD_REDUCTION_DIM 2
+#define TEST_QUAD_REDUCTION_ROW 1000 /** points of a row, summed one tile at a time **/
+#define TEST_QUAD_REDUCTION_ROWS 16
+#define TEST_QUAD_REDUCTION_AMP 7.0
+#define TEST_QUAD_REDUCTION_NUM_COUNTS 3
+#define TEST_QUAD_REDUCTION_MAX_POW 24
+#define TEST_QUAD_REDUCTION_MIN_POW 4
+
+static int test_quad_reduction_pass(maxentmc_quad_helper_t const quad, maxentmc_power_vector_t const multipliers,
+                                    maxentmc_power_vector_t const moments, size_t const num_threads)
+{
+    size_t const num_points[TEST_QUAD_REDUCTION_DIM] = {TEST_QUAD_REDUCTION_ROW, TEST_QUAD_REDUCTION_ROWS};
+    maxentmc_float_t const start[TEST_QUAD_REDUCTION_DIM] = {-TEST_QUAD_REDUCTION_AMP, -TEST_QUAD_REDUCTION_AMP};
+    maxentmc_float_t const end[TEST_QUAD_REDUCTION_DIM] = {TEST_QUAD_REDUCTION_AMP, TEST_QUAD_REDUCTION_AMP};
+    maxentmc_quad_helper_set_multipliers(quad,multipliers);
+    maxentmc_quad_helper_set_moments(quad,moments);
+    if(maxentmc_quadrature_rectangle_uniform_parallel_ca(quad,num_threads,num_points,start,end))
+        return -1;
+    return maxentmc_quad_helper_get_moments(quad,moments);
+}
+
+int test_quad_reduction(void)
+{
+    size_t const num_sets = TEST_QUAD_REDUCTION_MAX_POW-TEST_QUAD_REDUCTION_MIN_POW+1;
+    maxentmc_power_vector_t const multipliers = test_common_powers(TEST_QUAD_REDUCTION_DIM,4);
+    maxentmc_power_vector_t reference[num_sets], moments[num_sets];
+    size_t const num_threads[TEST_QUAD_REDUCTION_NUM_COUNTS] = {1, 2, 8};
+    enum MAXENTMC_QUAD_HELPER_REDUCTION_MODE const modes[2] = {MAXENTMC_QUAD_HELPER_REDUCTION_DETERMINISTIC,
+                                                              MAXENTMC_QUAD_HELPER_REDUCTION_COMPENSATED};
+    maxentmc_index_t p[TEST_QUAD_REDUCTION_DIM];
+    size_t k, c, s;
+    int m, failed = 0;
+
+    for(k=0;k<multipliers->gsl_vec.size;++k){
+        maxentmc_power_vector_get_powers_ca(multipliers,k,p);
+        if(p[0]+p[1] == 0)
+            multipliers->gsl_vec.data[k] = -log(8.0*atan(1.0));
+        else if(p[0]+p[1] == 2)
+            multipliers->gsl_vec.data[k] = (p[0] == 1)?0.1:-0.5;
+        else
+            multipliers->gsl_vec.data[k] = (p[0]+p[1] == 4)?-0.01:0.05*sin(1.0+k);
+    }
+
+    for(s=0;s<num_sets;++s){
+        reference[s] = test_common_powers(TEST_QUAD_REDUCTION_DIM,TEST_QUAD_REDUCTION_MAX_POW-s);
+        moments[s] = test_common_powers(TEST_QUAD_REDUCTION_DIM,TEST_QUAD_REDUCTION_MAX_POW-s);
+    }
+
+    size_t const size = moments[num_sets-1]->gsl_vec.size;
+    maxentmc_float_t deterministic[size];
+
+    for(m=0;m<2;++m){
+
+        /** The reference of every set comes from one thread on a fresh helper **/
+
+        for(s=0;s<num_sets;++s){
+            maxentmc_quad_helper_t const quad = maxentmc_quad_helper_alloc(TEST_QUAD_REDUCTION_DIM);
+            maxentmc_quad_helper_set_reduction_mode(quad,modes[m]);
+            if(test_quad_reduction_pass(quad,multipliers,reference[s],1))
+                failed = 1;
+            maxentmc_quad_helper_free(quad);
+        }
+
+        for(c=0;c<TEST_QUAD_REDUCTION_NUM_COUNTS;++c){
+            maxentmc_quad_helper_t const quad = maxentmc_quad_helper_alloc(TEST_QUAD_REDUCTION_DIM);
+            maxentmc_quad_helper_set_reduction_mode(quad,modes[m]);
+            for(s=0;s<num_sets;++s){
+                if(test_quad_reduction_pass(quad,multipliers,moments[s],num_threads[c]))
+                    failed = 1;
+                if(memcmp(moments[s]->gsl_vec.data,reference[s]->gsl_vec.data,sizeof(maxentmc_float_t)*moments[s]->gsl_vec.size)){
+                    printf("test_quad_reduction: mode %d with %zu threads differs from 1 thread for total degree %zu\n",
+                           (int)modes[m],num_threads[c],TEST_QUAD_REDUCTION_MAX_POW-s);
+                    failed = 1;
+                }
+            }
+            maxentmc_quad_helper_free(quad);
+        }
+
+        /** Both modes compute the same moments up to rounding **/
+
+        for(k=0;k<size;++k){
+            maxentmc_float_t const v = reference[num_sets-1]->gsl_vec.data[k];
+            if(m == 0)
+                deterministic[k] = v;
+            else if(!(fabs(v-deterministic[k]) <= 1e-13*(1.0+fabs(v)))){
+                maxentmc_power_vector_get_powers_ca(reference[num_sets-1],k,p);
+                printf("test_quad_reduction: moment [%u %u] is %.17g deterministic and %.17g compensated\n",
+                       p[0],p[1],deterministic[k],v);
+                failed = 1;
+            }
+        }
+    }
+
+    for(s=0;s<num_sets;++s){
+        maxentmc_power_vector_free(reference[s]);
+        maxentmc_power_vector_free(moments[s]);
+    }
+    maxentmc_power_vector_free(multipliers);
+
+    puts((failed)?"test_quad_reduction: FAILED":"test_quad_reduction: passed");
+
+    return (failed)?-1:0;
+}
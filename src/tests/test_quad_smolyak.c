@@ -0,0 +1,106 @@
+/** This file is part of MaxEntMC, a maximum entropy algorithm with moment constraints. **/
+/** Copyright (C) 2014 Rafail V. Abramov.                                               **/
+/**                                                                                     **/
+/** This program is free software: you can redistribute it and/or modify it under the   **/
+/** terms of the GNU General Public License as published by the Free Software           **/
+/** Foundation, either version 3 of the License, or (at your option) any later version. **/
+/**                                                                                     **/
+/** This program is distributed in the hope that it will be useful, but WITHOUT ANY     **/
+/** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     **/
+/** PARTICULAR PURPOSE.  See the GNU General Public License for more details.           **/
+/**                                                                                     **/
+/** You should have received a copy of the GNU General Public License along with this   **/
+/** program.  If not, see <http://www.gnu.org/licenses/>.                               **/
+
+#include <math.h>
+#include "test_quad_smolyak.h"
+#include "test_common.h"
+
+/** The sparse grid must have the known number of points, integrate the monomials up to total degree 2 level+1 on the
+    box exactly, and give the moments of a Gaussian through the Gaussian mapped grid **/
+
+#define TEST_QUAD_SMOLYAK_MAX_DIM 3
+#define TEST_QUAD_SMOLYAK_MAX_LEVEL 4
+#define TEST_QUAD_SMOLYAK_GAUSSIAN_LEVEL 8
+#define TEST_QUAD_SMOLYAK_GAUSSIAN_WIDTH 1.5
+
+int test_quad_smolyak(void)
+{
+    /** Clenshaw-Curtis sparse grid sizes in 2 and 3 dimensions for levels 0 to 4 **/
+    size_t const sizes[2][TEST_QUAD_SMOLYAK_MAX_LEVEL+1] = {{1, 5, 13, 29, 65}, {1, 7, 25, 69, 177}};
+    maxentmc_index_t dim, i;
+    size_t level, k;
+    int failed = 0;
+
+    for(dim=2;dim<=TEST_QUAD_SMOLYAK_MAX_DIM;++dim){
+        maxentmc_float_t start[dim], end[dim];
+        maxentmc_index_t p[dim];
+        for(i=0;i<dim;++i){
+            start[i] = -1.0;
+            end[i] = 1.0;
+        }
+        maxentmc_quad_helper_t const quad = maxentmc_quad_helper_alloc(dim);
+        maxentmc_power_vector_t const constant = test_common_powers(dim,0);
+        constant->gsl_vec.data[0] = 0.0;
+
+        for(level=0;level<=TEST_QUAD_SMOLYAK_MAX_LEVEL;++level){
+            size_t const num_points = maxentmc_quadrature_smolyak_num_points(dim,level);
+            if(num_points != sizes[dim-2][level]){
+                printf("test_quad_smolyak: level %zu grid in %u dimensions has %zu points instead of %zu\n",
+                       level,dim,num_points,sizes[dim-2][level]);
+                failed = 1;
+            }
+
+            /** Unit density, so the moments are the integrals of the monomials over [-1,1]^dim **/
+
+            maxentmc_power_vector_t const moments = test_common_powers(dim,2*level+1);
+            maxentmc_quad_helper_set_multipliers(quad,constant);
+            maxentmc_quad_helper_set_moments(quad,moments);
+            if(maxentmc_quadrature_smolyak_ca(quad,level,start,end))
+                failed = 1;
+            maxentmc_quad_helper_get_moments(quad,moments);
+            for(k=0;k<moments->gsl_vec.size;++k){
+                maxentmc_power_vector_get_powers_ca(moments,k,p);
+                maxentmc_float_t exact = 1.0;
+                for(i=0;i<dim;++i)
+                    exact *= (p[i]%2)?0.0:2.0/(p[i]+1);
+                if(!(fabs(moments->gsl_vec.data[k]-exact) <= 1e-12)){
+                    printf("test_quad_smolyak: level %zu grid in %u dimensions integrates moment %zu to %.17g instead of %.17g\n",
+                           level,dim,k,moments->gsl_vec.data[k],exact);
+                    failed = 1;
+                }
+            }
+            maxentmc_power_vector_free(moments);
+        }
+
+        /** Standard Gaussian density through the grid mapped by a wider Gaussian, so that the mapped integrand vanishes
+            smoothly at the ends of [-1,1] instead of growing like a power of the logarithm **/
+
+        maxentmc_power_vector_t const multipliers = test_common_powers(dim,2);
+        maxentmc_power_vector_t const moments = test_common_powers(dim,4);
+        test_common_gaussian_multipliers(multipliers,NULL);
+        maxentmc_quad_helper_set_multipliers(quad,multipliers);
+        maxentmc_quad_helper_set_moments(quad,moments);
+        if(maxentmc_quadrature_smolyak_gaussian_ca(quad,TEST_QUAD_SMOLYAK_GAUSSIAN_LEVEL,TEST_QUAD_SMOLYAK_GAUSSIAN_WIDTH))
+            failed = 1;
+        maxentmc_quad_helper_get_moments(quad,moments);
+        for(k=0;k<moments->gsl_vec.size;++k){
+            maxentmc_power_vector_get_powers_ca(moments,k,p);
+            maxentmc_float_t const exact = test_common_gaussian_moment(p,dim,NULL);
+            if(!(fabs(moments->gsl_vec.data[k]-exact) <= 1e-6*(1.0+exact))){
+                printf("test_quad_smolyak: Gaussian moment %zu in %u dimensions is %.17g instead of %.17g\n",
+                       k,dim,moments->gsl_vec.data[k],exact);
+                failed = 1;
+            }
+        }
+
+        maxentmc_power_vector_free(multipliers);
+        maxentmc_power_vector_free(moments);
+        maxentmc_power_vector_free(constant);
+        maxentmc_quad_helper_free(quad);
+    }
+
+    puts((failed)?"test_quad_smolyak: FAILED":"test_quad_smolyak: passed");
+
+    return (failed)?-1:0;
+}
@@ -0,0 +1,120 @@
+/** This file is part of MaxEntMC, a maximum entropy algorithm with moment constraints. **/
+/** Copyright (C) 2014 Rafail V. Abramov.                                               **/
+/**                                                                                     **/
+/** This program is free software: you can redistribute it and/or modify it under the   **/
+/** terms of the GNU General Public License as published by the Free Software           **/
+/** Foundation, either version 3 of the License, or (at your option) any later version. **/
+/**                                                                                     **/
+/** This program is distributed in the hope that it will be useful, but WITHOUT ANY     **/
+/** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     **/
+/** PARTICULAR PURPOSE.  See the GNU General Public License for more details.           **/
+/**                                                                                     **/
+/** You should have received a copy of the GNU General Public License along with this   **/
+/** program.  If not, see <http://www.gnu.org/licenses/>.                               **/
+
+#include <math.h>
+#include "test_quad_thread_reuse.h"
+#include "test_common.h"
+
+/** One accumulator kept with maxentmc_quad_helper_thread_merge_reset through passes armed with degree 2, then 8 moments:
+    compute and merge must refuse it until maxentmc_quad_helper_thread_realloc lays it out for the larger moments. It is
+    then reused in place for degree 2 again, merged into the spare list of the helper, and taken back from there by
+    maxentmc_quad_helper_thread_alloc for degree 4. Every pass must give the exact moments of the standard Gaussian **/
+
+#define TEST_QUAD_THREAD_REUSE_DIM 2
+#define TEST_QUAD_THREAD_REUSE_SIZE 80
+#define TEST_QUAD_THREAD_REUSE_AMP 10.0
+#define TEST_QUAD_THREAD_REUSE_PASSES 4
+
+static int test_quad_thread_reuse_grid(maxentmc_quad_helper_thread_t const qt)
+{
+    maxentmc_float_t const dx = 2.0*TEST_QUAD_THREAD_REUSE_AMP/TEST_QUAD_THREAD_REUSE_SIZE;
+    size_t i, j;
+
+    for(j=0;j<TEST_QUAD_THREAD_REUSE_SIZE;++j)
+        for(i=0;i<TEST_QUAD_THREAD_REUSE_SIZE;++i){
+            maxentmc_float_t const y[TEST_QUAD_THREAD_REUSE_DIM] = {-TEST_QUAD_THREAD_REUSE_AMP+(0.5+i)*dx,
+                                                                    -TEST_QUAD_THREAD_REUSE_AMP+(0.5+j)*dx};
+            if(maxentmc_quad_helper_thread_compute_1(qt,y,dx*dx))
+                return -1;
+        }
+
+    return 0;
+}
+
+int test_quad_thread_reuse(void)
+{
+    maxentmc_power_vector_t const multipliers = test_common_powers(TEST_QUAD_THREAD_REUSE_DIM,2);
+    maxentmc_index_t const total_pow[TEST_QUAD_THREAD_REUSE_PASSES] = {2, 8, 2, 4};
+    maxentmc_index_t p[TEST_QUAD_THREAD_REUSE_DIM];
+    maxentmc_quad_helper_thread_t qt = NULL, kept = NULL;
+    size_t k;
+    int m, failed = 0;
+
+    test_common_gaussian_multipliers(multipliers,NULL);
+
+    maxentmc_quad_helper_t const quad = maxentmc_quad_helper_alloc(TEST_QUAD_THREAD_REUSE_DIM);
+
+    for(m=0;m<TEST_QUAD_THREAD_REUSE_PASSES && !failed;++m){
+        maxentmc_power_vector_t const moments = test_common_powers(TEST_QUAD_THREAD_REUSE_DIM,total_pow[m]);
+        maxentmc_quad_helper_set_multipliers(quad,multipliers);
+        maxentmc_quad_helper_set_moments(quad,moments);
+
+        if(m == 0)
+            qt = maxentmc_quad_helper_thread_alloc(quad);
+        else if(m == 1){
+            maxentmc_float_t const y[TEST_QUAD_THREAD_REUSE_DIM] = {0.0, 0.0};
+            if(!maxentmc_quad_helper_thread_compute_1(qt,y,1.0) || !maxentmc_quad_helper_thread_merge_reset(qt)){
+                puts("test_quad_thread_reuse: an accumulator laid out for smaller moments was accepted");
+                failed = 1;
+            }
+            qt = maxentmc_quad_helper_thread_realloc(qt);
+        }
+        else if(m == 2){
+            kept = qt;
+            qt = maxentmc_quad_helper_thread_realloc(qt);
+            if(qt != kept){
+                puts("test_quad_thread_reuse: the buffer was not reused for smaller moments");
+                failed = 1;
+            }
+        }
+        else{
+            qt = maxentmc_quad_helper_thread_alloc(quad);
+            if(qt != kept){
+                puts("test_quad_thread_reuse: the merged buffer was not taken from the spare list");
+                failed = 1;
+            }
+        }
+
+        if((qt == NULL) || test_quad_thread_reuse_grid(qt)){
+            printf("test_quad_thread_reuse: the accumulator of pass %d could not be computed\n",m);
+            failed = 1;
+        }
+        else if(((m < 2)?maxentmc_quad_helper_thread_merge_reset(qt):maxentmc_quad_helper_thread_merge(qt)) ||
+                maxentmc_quad_helper_get_moments(quad,moments)){
+            printf("test_quad_thread_reuse: the accumulator of pass %d could not be merged\n",m);
+            failed = 1;
+        }
+        else
+            for(k=0;k<moments->gsl_vec.size;++k){
+                maxentmc_power_vector_get_powers_ca(moments,k,p);
+                maxentmc_float_t const exact = test_common_gaussian_moment(p,TEST_QUAD_THREAD_REUSE_DIM,NULL);
+                maxentmc_float_t const v = moments->gsl_vec.data[k];
+                if(!(fabs(v-exact) <= 1e-10*(1.0+fabs(exact)))){
+                    printf("test_quad_thread_reuse: moment [%u %u] of pass %d is %.17g, expected %.17g\n",p[0],p[1],m,v,exact);
+                    failed = 1;
+                }
+            }
+
+        maxentmc_power_vector_free(moments);
+    }
+
+    /** The last accumulator was merged into the spare list, which the helper frees **/
+
+    maxentmc_power_vector_free(multipliers);
+    maxentmc_quad_helper_free(quad);
+
+    puts((failed)?"test_quad_thread_reuse: FAILED":"test_quad_thread_reuse: passed");
+
+    return (failed)?-1:0;
+}
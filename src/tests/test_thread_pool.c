@@ -0,0 +1,183 @@
+/** This file is part of MaxEntMC, a maximum entropy algorithm with moment constraints. **/
+/** Copyright (C) 2014 Rafail V. Abramov.                                               **/
+/**                                                                                     **/
+/** This program is free software: you can redistribute it and/or modify it under the   **/
+/** terms of the GNU General Public License as published by the Free Software           **/
+/** Foundation, either version 3 of the License, or (at your option) any later version. **/
+/**                                                                                     **/
+/** This program is distributed in the hope that it will be useful, but WITHOUT ANY     **/
+/** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     **/
+/** PARTICULAR PURPOSE.  See the GNU General Public License for more details.           **/
+/**                                                                                     **/
+/** You should have received a copy of the GNU General Public License along with this   **/
+/** program.  If not, see <http://www.gnu.org/licenses/>.                               **/
+
+#ifdef __linux__
+#define _GNU_SOURCE /** pthread_getaffinity_np **/
+#endif
+
+#include <math.h>
+#include <pthread.h>
+#include "test_thread_pool.h"
+
+/** The thread pool must run every chunk exactly once, merge the per-worker results in finish, and report a chunk that
+    failed. The chunks have very different costs so that the workers steal from each other. A pool with a placement must
+    number its workers node by node and give the calling thread back its processors when freed **/
+
+#define TEST_THREAD_POOL_NUM_THREADS 4
+#define TEST_THREAD_POOL_NUM_CHUNKS 1000
+#define TEST_THREAD_POOL_BAD_CHUNK 517
+
+struct test_thread_pool_struct{
+    int count[TEST_THREAD_POOL_NUM_CHUNKS];
+    double partial[TEST_THREAD_POOL_NUM_THREADS];
+    double work[TEST_THREAD_POOL_NUM_THREADS];
+    double sum;
+    size_t bad_chunk;
+};
+
+static int test_thread_pool_chunk(void * const arg, size_t const chunk, size_t const index)
+{
+    struct test_thread_pool_struct * const t = arg;
+    double x = 0.0;
+    size_t i;
+    for(i=0;i<(chunk%7)*(chunk%7)*200;++i) /** Irregular work **/
+        x += sin((double)i);
+    ++t->count[chunk];
+    t->partial[index] += (double)chunk;
+    t->work[index] += x;
+    return (chunk == t->bad_chunk)?-1:0;
+}
+
+static void test_thread_pool_finish(void * const arg, size_t const index)
+{
+    struct test_thread_pool_struct * const t = arg;
+    static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+    pthread_mutex_lock(&lock);
+    t->sum += t->partial[index];
+    pthread_mutex_unlock(&lock);
+}
+
+static void test_thread_pool_task(void * const arg, size_t const index)
+{
+    ++((int *)arg)[index];
+}
+
+static int test_thread_pool_placed(enum MAXENTMC_THREAD_POOL_PLACEMENT const placement)
+{
+    int failed = 0;
+
+#ifdef __linux__
+    cpu_set_t before, after;
+    pthread_getaffinity_np(pthread_self(),sizeof(cpu_set_t),&before);
+#endif
+
+    maxentmc_thread_pool_t const pool = maxentmc_thread_pool_alloc_placed(TEST_THREAD_POOL_NUM_THREADS,placement);
+    if(pool == NULL){
+        printf("test_thread_pool: could not allocate a pool with placement %d\n",(int)placement);
+        return 1;
+    }
+
+    size_t const num_threads = maxentmc_thread_pool_get_num_threads(pool);
+    size_t const num_nodes = maxentmc_thread_pool_get_num_nodes(pool);
+    size_t i;
+    for(i=0;i<num_threads;++i){
+        int const node = maxentmc_thread_pool_get_node(pool,i);
+        if(node < 0 || (i > 0 && node < maxentmc_thread_pool_get_node(pool,i-1))){
+            printf("test_thread_pool: worker %zu of placement %d is on node %d\n",i,(int)placement,node);
+            failed = 1;
+        }
+    }
+    if(num_nodes < 1 || num_nodes > num_threads){
+        printf("test_thread_pool: placement %d uses %zu nodes\n",(int)placement,num_nodes);
+        failed = 1;
+    }
+
+    static struct test_thread_pool_struct t;
+    for(i=0;i<TEST_THREAD_POOL_NUM_CHUNKS;++i)
+        t.count[i] = 0;
+    for(i=0;i<TEST_THREAD_POOL_NUM_THREADS;++i)
+        t.partial[i] = 0.0;
+    t.sum = 0.0;
+    t.bad_chunk = TEST_THREAD_POOL_NUM_CHUNKS;
+    if(maxentmc_thread_pool_run_chunks(pool,TEST_THREAD_POOL_NUM_CHUNKS,test_thread_pool_chunk,test_thread_pool_finish,&t)
+       || t.sum != 0.5*TEST_THREAD_POOL_NUM_CHUNKS*(TEST_THREAD_POOL_NUM_CHUNKS-1)){
+        printf("test_thread_pool: chunks of placement %d were not all computed\n",(int)placement);
+        failed = 1;
+    }
+
+    maxentmc_thread_pool_free(pool);
+
+#ifdef __linux__
+    pthread_getaffinity_np(pthread_self(),sizeof(cpu_set_t),&after);
+    if(!CPU_EQUAL(&before,&after)){
+        printf("test_thread_pool: placement %d left the calling thread pinned\n",(int)placement);
+        failed = 1;
+    }
+#endif
+
+    return failed;
+}
+
+int test_thread_pool(void)
+{
+    maxentmc_thread_pool_t const pool = maxentmc_thread_pool_alloc(TEST_THREAD_POOL_NUM_THREADS);
+    static struct test_thread_pool_struct t;
+    int runs[TEST_THREAD_POOL_NUM_THREADS];
+    size_t c, pass;
+    int failed = 0;
+
+    if(pool == NULL){
+        puts("test_thread_pool: FAILED to allocate the pool");
+        return -1;
+    }
+
+    for(c=0;c<TEST_THREAD_POOL_NUM_THREADS;++c)
+        runs[c] = 0;
+    for(pass=0;pass<3;++pass)
+        if(maxentmc_thread_pool_run(pool,test_thread_pool_task,runs))
+            failed = 1;
+    for(c=0;c<TEST_THREAD_POOL_NUM_THREADS;++c)
+        if(runs[c] != 3){
+            printf("test_thread_pool: worker %zu ran %d tasks instead of 3\n",c,runs[c]);
+            failed = 1;
+        }
+
+    /** A pass without failures, then a pass with one failing chunk, on the same pool **/
+
+    for(pass=0;pass<2;++pass){
+        for(c=0;c<TEST_THREAD_POOL_NUM_CHUNKS;++c)
+            t.count[c] = 0;
+        for(c=0;c<TEST_THREAD_POOL_NUM_THREADS;++c)
+            t.partial[c] = 0.0;
+        t.sum = 0.0;
+        t.bad_chunk = (pass)?TEST_THREAD_POOL_BAD_CHUNK:TEST_THREAD_POOL_NUM_CHUNKS;
+
+        int const status = maxentmc_thread_pool_run_chunks(pool,TEST_THREAD_POOL_NUM_CHUNKS,test_thread_pool_chunk,
+                                                           test_thread_pool_finish,&t);
+        if((status != 0) != (pass != 0)){
+            printf("test_thread_pool: run_chunks returned %d with%s a failing chunk\n",status,(pass)?"":"out");
+            failed = 1;
+        }
+        for(c=0;c<TEST_THREAD_POOL_NUM_CHUNKS;++c)
+            if(t.count[c] != 1){
+                printf("test_thread_pool: chunk %zu ran %d times\n",c,t.count[c]);
+                failed = 1;
+            }
+        if(t.sum != 0.5*TEST_THREAD_POOL_NUM_CHUNKS*(TEST_THREAD_POOL_NUM_CHUNKS-1)){
+            printf("test_thread_pool: merged sum of the chunks is %.17g\n",t.sum);
+            failed = 1;
+        }
+    }
+
+    maxentmc_thread_pool_free(pool);
+
+    if(test_thread_pool_placed(MAXENTMC_THREAD_POOL_PLACEMENT_COMPACT))
+        failed = 1;
+    if(test_thread_pool_placed(MAXENTMC_THREAD_POOL_PLACEMENT_SPREAD))
+        failed = 1;
+
+    puts((failed)?"test_thread_pool: FAILED":"test_thread_pool: passed");
+
+    return (failed)?-1:0;
+}
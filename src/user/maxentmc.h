@@ -18,6 +18,9 @@
 #include <stdio.h>
 #include <stdint.h>
 #include <stdarg.h>
+#ifdef MAXENTMC_MPI
+#include <mpi.h>
+#endif
 
 /********* Basic type definitions ********/
 
@@ -144,6 +147,46 @@ struct maxentmc_power_vector_struct ** maxentmc_list_create_power_vector_array(s
 
 int maxentmc_list_create_power_vectors(struct maxentmc_list_struct const *, ...);
 
+/** Thread pool structure and functions **/
+
+struct maxentmc_thread_pool_struct;
+typedef struct maxentmc_thread_pool_struct * maxentmc_thread_pool_t;
+
+struct maxentmc_thread_pool_struct * maxentmc_thread_pool_alloc(size_t num_threads);
+/** Starts num_threads-1 worker threads, which stay alive until maxentmc_thread_pool_free. The calling thread of
+    maxentmc_thread_pool_run is always the first worker. **/
+
+enum MAXENTMC_THREAD_POOL_PLACEMENT {MAXENTMC_THREAD_POOL_PLACEMENT_NONE, MAXENTMC_THREAD_POOL_PLACEMENT_COMPACT,
+                                     MAXENTMC_THREAD_POOL_PLACEMENT_SPREAD};
+/** Where the workers run: wherever the system schedules them, or pinned one per processor, filling the processors of one
+    NUMA node before the next (compact) or sharing the workers equally among the nodes (spread). Pinned workers are
+    numbered node by node, allocate their thread accumulators on their own node, steal work on their node first, and the
+    reduction of a pass crosses nodes only in its last steps. **/
+
+struct maxentmc_thread_pool_struct * maxentmc_thread_pool_alloc_placed(size_t num_threads, enum MAXENTMC_THREAD_POOL_PLACEMENT placement);
+/** Same as maxentmc_thread_pool_alloc with the given placement. The calling thread is pinned as worker 0, so the pool should
+    be run from the thread that allocated it, and maxentmc_thread_pool_free gives it back its previous processors. **/
+
+void maxentmc_thread_pool_free(struct maxentmc_thread_pool_struct * pool);
+
+size_t maxentmc_thread_pool_get_num_threads(struct maxentmc_thread_pool_struct const * pool);
+
+size_t maxentmc_thread_pool_get_num_nodes(struct maxentmc_thread_pool_struct const * pool);
+
+int maxentmc_thread_pool_get_node(struct maxentmc_thread_pool_struct const * pool, size_t index);
+/** NUMA node of worker index, 0 for every worker of a pool without placement **/
+
+int maxentmc_thread_pool_run(struct maxentmc_thread_pool_struct * pool, void (*task)(void * arg, size_t index), void * arg);
+/** Runs task(arg,index) on every worker, index from 0 to the number of threads-1, and returns when all are done **/
+
+int maxentmc_thread_pool_run_chunks(struct maxentmc_thread_pool_struct * pool, size_t num_chunks,
+                                    int (*chunk)(void * arg, size_t chunk, size_t index),
+                                    void (*finish)(void * arg, size_t index), void * arg);
+/** Runs chunk(arg,c,index) once for every c from 0 to num_chunks-1, on the worker index that took it: every worker starts
+    with a contiguous range of chunks and steals from the others when it runs out. Then every worker calls finish(arg,index)
+    (if not NULL), which is where per-worker results are merged. Returns non-zero if a chunk returned non-zero or
+    not every chunk was computed. **/
+
 /** Quadrature helper structures and functions **/
 
 struct maxentmc_quad_helper_struct;
@@ -159,21 +202,97 @@ maxentmc_index_t maxentmc_quad_helper_get_dimension(struct maxentmc_quad_helper_
 
 int maxentmc_quad_helper_set_shift_rotation(struct maxentmc_quad_helper_struct * q, struct maxentmc_power_vector_struct const * constraints);
 
+enum MAXENTMC_QUAD_HELPER_EXP_MODE {MAXENTMC_QUAD_HELPER_EXP_FULL, MAXENTMC_QUAD_HELPER_EXP_ACCURATE, MAXENTMC_QUAD_HELPER_EXP_FAST};
+/** Accuracy of the exponential in the vectorized kernels: full double precision (default), about 1e-12 relative error,
+    or about 1e-7 relative error for early iterations far from the solution **/
+
+int maxentmc_quad_helper_set_exp_mode(struct maxentmc_quad_helper_struct * q, enum MAXENTMC_QUAD_HELPER_EXP_MODE mode);
+
+enum MAXENTMC_QUAD_HELPER_REDUCTION_MODE {MAXENTMC_QUAD_HELPER_REDUCTION_FAST, MAXENTMC_QUAD_HELPER_REDUCTION_DETERMINISTIC,
+                                          MAXENTMC_QUAD_HELPER_REDUCTION_COMPENSATED};
+/** How the quadrature drivers combine the work of several threads: as fast as possible (default, the rounding depends on the
+    number of threads), over a fixed partition of the points summed in a fixed order (bitwise identical moments for any
+    number of threads, with a given number of MPI ranks), or the same with compensated summation of the partial sums **/
+
+int maxentmc_quad_helper_set_reduction_mode(struct maxentmc_quad_helper_struct * q, enum MAXENTMC_QUAD_HELPER_REDUCTION_MODE mode);
+
+enum MAXENTMC_QUAD_HELPER_REDUCTION_MODE maxentmc_quad_helper_get_reduction_mode(struct maxentmc_quad_helper_struct const * q);
+
+int maxentmc_quad_helper_set_thread_pool(struct maxentmc_quad_helper_struct * q, struct maxentmc_thread_pool_struct * pool);
+/** Attaches a thread pool (NULL detaches it), which the quadrature drivers then use for every pass. The pool is not
+    owned by the helper and must outlive it or be detached. **/
+
+struct maxentmc_thread_pool_struct * maxentmc_quad_helper_get_thread_pool(struct maxentmc_quad_helper_struct const * q);
+
+#ifdef MAXENTMC_MPI
+int maxentmc_quad_helper_set_communicator(struct maxentmc_quad_helper_struct * q, MPI_Comm comm);
+/** With the library built with MAXENTMC_MPI defined (and an MPI compiler), splits every quadrature pass of the helper over
+    the ranks of comm: the drivers compute the share of the points of their rank, and maxentmc_quad_helper_get_moments,
+    which then has to be called by all ranks of comm, sums the moments over them. A new helper, or one given
+    MPI_COMM_NULL, computes everything on this rank. **/
+#endif
+
+int maxentmc_quad_helper_get_rank(struct maxentmc_quad_helper_struct const * q, int * rank, int * num_ranks);
+/** This rank and the number of ranks the quadrature is split over (0 and 1 without MPI), either pointer may be NULL.
+    Quadrature drivers compute only the points of their rank. **/
+
 int maxentmc_quad_helper_set_multipliers(struct maxentmc_quad_helper_struct * q, struct maxentmc_power_vector_struct const * multipliers);
 
 int maxentmc_quad_helper_set_moments(struct maxentmc_quad_helper_struct * q, struct maxentmc_power_vector_struct const * moments);
 
+int maxentmc_quad_helper_add_moments(struct maxentmc_quad_helper_struct * q, struct maxentmc_power_vector_struct const * moments);
+/** Arms another set of moments after maxentmc_quad_helper_set_moments and before any thread is allocated (an error
+    otherwise), all armed sets are computed in the same pass over the quadrature points **/
+
 int maxentmc_quad_helper_get_moments(struct maxentmc_quad_helper_struct * q, struct maxentmc_power_vector_struct * moments);
+/** The powers of the moments may be a subset of the powers of an armed set (for example, the gradient moments are contained
+    in the Hessian moments), in which case the matching moments are extracted. The helper is disarmed once every armed
+    set has been extracted. **/
 
 struct maxentmc_quad_helper_thread_struct * maxentmc_quad_helper_thread_alloc(struct maxentmc_quad_helper_struct *);
 
+struct maxentmc_quad_helper_thread_struct * maxentmc_quad_helper_thread_alloc_on_node(struct maxentmc_quad_helper_struct *, int node);
+/** Same as maxentmc_quad_helper_thread_alloc for a thread pinned to the given NUMA node: a spare buffer is only reused if it
+    was allocated on the same node, otherwise a new one is allocated and first touched by the calling thread **/
+
 int maxentmc_quad_helper_thread_merge(struct maxentmc_quad_helper_thread_struct *);
+/** Adds the computed moments to the helper and releases the accumulator, whose buffer is kept by the helper for the next
+    maxentmc_quad_helper_thread_alloc **/
+
+int maxentmc_quad_helper_thread_merge_reset(struct maxentmc_quad_helper_thread_struct *);
+/** Adds the computed moments to the helper and zeroes the accumulator, which stays allocated. In a pass armed with other
+    moments it must first go through maxentmc_quad_helper_thread_realloc, the compute and merge functions return -1
+    otherwise **/
+
+struct maxentmc_quad_helper_thread_struct * maxentmc_quad_helper_thread_realloc(struct maxentmc_quad_helper_thread_struct *);
+/** Prepares a merged accumulator for the pass armed next, reusing its buffer if the new moments are not larger. Returns
+    NULL on error, in which case the old accumulator is still valid, otherwise the old pointer must not be used. **/
+
+void maxentmc_quad_helper_thread_free(struct maxentmc_quad_helper_thread_struct *);
+/** Frees an accumulator kept with maxentmc_quad_helper_thread_merge_reset **/
+
+int maxentmc_quad_helper_reduce_begin(struct maxentmc_quad_helper_struct *, size_t num_threads);
+/** Prepares a reduction of the accumulators of num_threads threads, before any of them calls maxentmc_quad_helper_reduce **/
+
+int maxentmc_quad_helper_reduce(struct maxentmc_quad_helper_struct *, struct maxentmc_quad_helper_thread_struct *, size_t index);
+/** Called once by every thread, index from 0 to num_threads-1, in place of maxentmc_quad_helper_thread_merge: the
+    accumulators are summed pairwise in a tree without a lock, and the last thread to arrive adds the total to the moments.
+    The accumulator (may be NULL if the thread has nothing to add) is released. **/
+
+int maxentmc_quad_helper_reduce_blocks(struct maxentmc_quad_helper_struct *, size_t num_blocks);
+/** Called after maxentmc_quad_helper_reduce_begin for a deterministic reduction: the points are partitioned into num_blocks
+    fixed blocks, each computed by one thread and deposited with maxentmc_quad_helper_thread_deposit, and the last thread
+    in maxentmc_quad_helper_reduce sums the blocks in order **/
+
+int maxentmc_quad_helper_thread_deposit(struct maxentmc_quad_helper_thread_struct *, size_t block);
+/** Stores the sums accumulated since the previous deposit as the given block and zeroes the accumulator **/
 
 int maxentmc_quad_helper_thread_compute(struct maxentmc_quad_helper_thread_struct *, ...);
 
 int maxentmc_quad_helper_thread_compute_1(struct maxentmc_quad_helper_thread_struct *,
                                           maxentmc_float_t const * x1, maxentmc_float_t w1);
-/** Length of x is [dimension] **/
+/** Length of x is [dimension]. Single points are buffered and computed a tile at a time, the last partial tile at the
+    latest in maxentmc_quad_helper_thread_merge **/
 
 int maxentmc_quad_helper_thread_compute_2(struct maxentmc_quad_helper_thread_struct *,
                                           maxentmc_float_t const * x1, maxentmc_float_t w1,
@@ -190,6 +309,11 @@ int maxentmc_quad_helper_thread_compute_4(struct maxentmc_quad_helper_thread_str
                                           maxentmc_float_t const * x3, maxentmc_float_t w3,
                                           maxentmc_float_t const * x4, maxentmc_float_t w4);
 
+int maxentmc_quad_helper_thread_compute_n(struct maxentmc_quad_helper_thread_struct *, size_t n,
+                                          maxentmc_float_t const * const * x, maxentmc_float_t const * w);
+/** Structure-of-arrays input: x is [dimension][n], so that x[i][k] is the i-th coordinate of the k-th point,
+    and w is [n]. Points are processed internally in fixed-size tiles **/
+
 
 /** Lagrangian, gradient and Hessian structures and functions **/
 
@@ -12,11 +12,207 @@
 /** You should have received a copy of the GNU General Public License along with this   **/
 /** program.  If not, see <http://www.gnu.org/licenses/>.                               **/
 
+#include <stdlib.h>
+#include <unistd.h>
 #include "maxentmc_basic_algorithm.h"
 
+/** Structures shared by all problems with the same set of powers: the constraint powers, the product powers for the hessian
+    moments and the LGH object. Problems solved with the same shared structures need constraint vectors with exactly these powers,
+    that is, allocated from shared->constraints **/
+
+struct maxentmc_basic_algorithm_shared_struct{
+    maxentmc_power_vector_t constraints; /** Any vector with the constraint powers (values are not used) **/
+    maxentmc_power_vector_t moments_hess; /** Any vector with the hessian moment powers (values are not used) **/
+    maxentmc_LGH_t LGH;
+};
+
+static int maxentmc_basic_algorithm_shared_init(struct maxentmc_basic_algorithm_shared_struct * const shared, maxentmc_power_vector_t const constraints)
+{
+    shared->constraints = maxentmc_power_vector_alloc(constraints);
+    shared->moments_hess = maxentmc_power_vector_product_alloc(constraints,constraints);
+    shared->LGH = maxentmc_LGH_alloc(shared->constraints); /** The LGH object is allocated from any vector with constraint powers **/
+    if(shared->constraints == NULL || shared->moments_hess == NULL || shared->LGH == NULL ||
+       maxentmc_LGH_add_power_vector(shared->LGH,shared->moments_hess)){ /** Add the hessian moments, to be able to extract the hessian **/
+        maxentmc_LGH_free(shared->LGH);
+        maxentmc_power_vector_free(shared->moments_hess);
+        maxentmc_power_vector_free(shared->constraints);
+        return -1;
+    }
+    return 0;
+}
+
+static void maxentmc_basic_algorithm_shared_free(struct maxentmc_basic_algorithm_shared_struct * const shared)
+{
+    maxentmc_LGH_free(shared->LGH);
+    maxentmc_power_vector_free(shared->moments_hess);
+    maxentmc_power_vector_free(shared->constraints);
+}
+
+/** Quadrature used by the solver: the rectangle uniform grid, or, if num_samples is not zero, importance sampling from the Gaussian
+    with the mean and covariance of the current iterate (widened by width), refreshed at every iteration while the exponential is
+    computed in the fast mode and then kept, so that the last iterations converge on a fixed set of samples **/
+
+struct maxentmc_basic_algorithm_quadrature_struct{
+    size_t const * quad_size;
+    maxentmc_float_t const * quad_start;
+    maxentmc_float_t const * quad_end;
+    size_t num_samples;
+    maxentmc_float_t width;
+    uint64_t seed;
+};
+
+static int maxentmc_basic_algorithm_quadrature(maxentmc_quad_helper_t const quad, struct maxentmc_basic_algorithm_quadrature_struct const * const method)
+{
+    if(method->num_samples)
+        return maxentmc_quadrature_importance_ca(quad, method->num_samples, method->width, method->seed);
+    return maxentmc_quadrature_rectangle_uniform_ca(quad, method->quad_size, method->quad_start, method->quad_end);
+}
+
+static int maxentmc_basic_algorithm_quadrature_multi(maxentmc_quad_helper_t const * const quads, size_t const num_quads,
+                                                     struct maxentmc_basic_algorithm_quadrature_struct const * const method)
+{
+    if(method->num_samples)
+        return maxentmc_quadrature_importance_multi_ca(quads, num_quads, method->num_samples, method->width, method->seed);
+    return maxentmc_quadrature_rectangle_uniform_multi_ca(quads, num_quads, method->quad_size, method->quad_start, method->quad_end);
+}
+
+/** Speculative line search: the first few step scales 1, 1/2, 1/4, ... are evaluated in one quadrature pass on the pool of the
+    solver, each trial with its own multipliers, moments and quadrature helper (hence its own thread accumulators), and the
+    largest acceptable scale is taken **/
+
+#define MAXENTMC_BASIC_ALGORITHM_SPECULATIVE_TRIALS 4
+
+struct maxentmc_basic_algorithm_trial_struct{
+    maxentmc_power_vector_t multipliers;
+    maxentmc_power_vector_t moments_grad;
+    maxentmc_power_vector_t moments; /** Either moments_grad of this trial or the hessian moments of the solver **/
+    gsl_vector * gradient;
+    maxentmc_float_t scale;
+};
+
+struct maxentmc_basic_algorithm_speculative_struct{
+    maxentmc_quad_helper_t quad[MAXENTMC_BASIC_ALGORITHM_SPECULATIVE_TRIALS]; /** Quadrature helper of each trial **/
+    struct maxentmc_basic_algorithm_trial_struct trial[MAXENTMC_BASIC_ALGORITHM_SPECULATIVE_TRIALS];
+};
+
+static void maxentmc_basic_algorithm_speculative_free(struct maxentmc_basic_algorithm_speculative_struct * const sp)
+{
+    size_t t;
+    for(t=0;t<MAXENTMC_BASIC_ALGORITHM_SPECULATIVE_TRIALS;++t){
+        maxentmc_quad_helper_free(sp->quad[t]);
+        maxentmc_power_vector_free(sp->trial[t].multipliers);
+        maxentmc_power_vector_free(sp->trial[t].moments_grad);
+        if(sp->trial[t].gradient)
+            gsl_vector_free(sp->trial[t].gradient);
+    }
+}
+
+/** The trial helpers take the pool, the reduction mode and the shift and rotation of the main quadrature helper **/
+
+static int maxentmc_basic_algorithm_speculative_init(struct maxentmc_basic_algorithm_speculative_struct * const sp, maxentmc_power_vector_t const constraints,
+                                                     maxentmc_quad_helper_t const quad)
+{
+    maxentmc_float_t scale = -1.0;
+    size_t t;
+    int error_flag = 0;
+
+    for(t=0;t<MAXENTMC_BASIC_ALGORITHM_SPECULATIVE_TRIALS;++t, scale*=0.5){
+        struct maxentmc_basic_algorithm_trial_struct * const trial = sp->trial+t;
+        sp->quad[t] = maxentmc_quad_helper_alloc(maxentmc_power_vector_get_dimension(constraints));
+        trial->multipliers = maxentmc_power_vector_alloc(constraints);
+        trial->moments_grad = maxentmc_power_vector_alloc(constraints);
+        trial->moments = trial->moments_grad;
+        trial->gradient = gsl_vector_alloc(constraints->gsl_vec.size);
+        trial->scale = scale;
+        if(sp->quad[t] == NULL || trial->multipliers == NULL || trial->moments_grad == NULL || trial->gradient == NULL ||
+           maxentmc_quad_helper_set_reduction_mode(sp->quad[t],maxentmc_quad_helper_get_reduction_mode(quad)))
+            error_flag = -1;
+        else{
+            maxentmc_quad_helper_set_shift_rotation(sp->quad[t],constraints);
+            maxentmc_quad_helper_set_thread_pool(sp->quad[t],maxentmc_quad_helper_get_thread_pool(quad));
+        }
+    }
+
+    if(error_flag)
+        maxentmc_basic_algorithm_speculative_free(sp);
+
+    return error_flag;
+}
+
+static int maxentmc_basic_algorithm_solve(struct maxentmc_basic_algorithm_shared_struct const * const shared, maxentmc_power_vector_t const constraints,
+                                          maxentmc_quad_helper_t const quad, struct maxentmc_basic_algorithm_quadrature_struct const * const method,
+                                          maxentmc_float_t const tolerance, int const speculative, int const verbose, size_t * const num_iter);
+
+/** Moves the importance sampling proposal of the helper (and of the speculative trials, if not NULL) to the mean and covariance
+    of the moments of the current iterate. If moments is NULL or they do not give a valid proposal, the one of the constraints is used **/
+
+static void maxentmc_basic_algorithm_set_proposal(maxentmc_quad_helper_t const quad, struct maxentmc_basic_algorithm_speculative_struct const * const sp,
+                                                  maxentmc_power_vector_t const moments, maxentmc_power_vector_t const constraints)
+{
+    if(moments == NULL || maxentmc_quadrature_importance_set_proposal(quad,moments))
+        maxentmc_quad_helper_set_shift_rotation(quad,constraints);
+    if(sp){
+        size_t t;
+        for(t=0;t<MAXENTMC_BASIC_ALGORITHM_SPECULATIVE_TRIALS;++t)
+            if(moments == NULL || maxentmc_quadrature_importance_set_proposal(sp->quad[t],moments))
+                maxentmc_quad_helper_set_shift_rotation(sp->quad[t],constraints);
+    }
+}
+
+/** The zero power moment, that is the normalization of the density **/
+
+static maxentmc_float_t maxentmc_basic_algorithm_normalization(maxentmc_power_vector_t const moments)
+{
+    maxentmc_index_t const dimension = maxentmc_power_vector_get_dimension(moments);
+    maxentmc_index_t powers[dimension], i;
+    size_t pos;
+    for(i=0;i<dimension;++i)
+        powers[i] = 0;
+    return (maxentmc_power_vector_find_element_ca(moments,powers,&pos))?NAN:moments->gsl_vec.data[pos];
+}
+
 int maxentmc_basic_algorithm(maxentmc_power_vector_t const constraints, size_t const * const quad_size, maxentmc_float_t const * const quad_start,
                              maxentmc_float_t const * const quad_end, maxentmc_float_t const tolerance)
 {
+    return maxentmc_basic_algorithm_parallel(constraints, quad_size, quad_start, quad_end, tolerance, 0, MAXENTMC_QUAD_HELPER_REDUCTION_FAST);
+}
+
+static int maxentmc_basic_algorithm_pooled(maxentmc_power_vector_t const constraints, struct maxentmc_basic_algorithm_quadrature_struct const * const method,
+                                          maxentmc_float_t const tolerance, size_t const num_threads,
+                                          enum MAXENTMC_QUAD_HELPER_REDUCTION_MODE const reduction_mode, int const speculative);
+
+int maxentmc_basic_algorithm_parallel(maxentmc_power_vector_t const constraints, size_t const * const quad_size, maxentmc_float_t const * const quad_start,
+                                      maxentmc_float_t const * const quad_end, maxentmc_float_t const tolerance, size_t const num_threads,
+                                      enum MAXENTMC_QUAD_HELPER_REDUCTION_MODE const reduction_mode)
+{
+    struct maxentmc_basic_algorithm_quadrature_struct const method = {quad_size, quad_start, quad_end, 0, 0, 0};
+    return maxentmc_basic_algorithm_pooled(constraints, &method, tolerance, num_threads, reduction_mode, 0);
+}
+
+int maxentmc_basic_algorithm_speculative(maxentmc_power_vector_t const constraints, size_t const * const quad_size, maxentmc_float_t const * const quad_start,
+                                         maxentmc_float_t const * const quad_end, maxentmc_float_t const tolerance, size_t const num_threads,
+                                         enum MAXENTMC_QUAD_HELPER_REDUCTION_MODE const reduction_mode)
+{
+    struct maxentmc_basic_algorithm_quadrature_struct const method = {quad_size, quad_start, quad_end, 0, 0, 0};
+    return maxentmc_basic_algorithm_pooled(constraints, &method, tolerance, num_threads, reduction_mode, 1);
+}
+
+int maxentmc_basic_algorithm_importance(maxentmc_power_vector_t const constraints, size_t const num_samples, maxentmc_float_t const width,
+                                        uint64_t const seed, maxentmc_float_t const tolerance, size_t const num_threads,
+                                        enum MAXENTMC_QUAD_HELPER_REDUCTION_MODE const reduction_mode)
+{
+    if(num_samples == 0 || !(width > 0)){
+        fputs(" MaxEntMC basic algorithm error: number of samples or width is not positive\n",stderr);
+        return -1;
+    }
+    struct maxentmc_basic_algorithm_quadrature_struct const method = {NULL, NULL, NULL, num_samples, width, seed};
+    return maxentmc_basic_algorithm_pooled(constraints, &method, tolerance, num_threads, reduction_mode, 0);
+}
+
+static int maxentmc_basic_algorithm_pooled(maxentmc_power_vector_t const constraints, struct maxentmc_basic_algorithm_quadrature_struct const * const method,
+                                          maxentmc_float_t const tolerance, size_t const num_threads,
+                                          enum MAXENTMC_QUAD_HELPER_REDUCTION_MODE const reduction_mode, int const speculative)
+{
 
     /** First, check that the constraints are valid **/
     if(constraints == NULL){
@@ -24,7 +220,37 @@ int maxentmc_basic_algorithm(maxentmc_power_vector_t const constraints, size_t c
         return -1;
     }
 
+    struct maxentmc_basic_algorithm_shared_struct shared;
+    if(maxentmc_basic_algorithm_shared_init(&shared,constraints))
+        return -1;
+
+    maxentmc_quad_helper_t quad = maxentmc_quad_helper_alloc(maxentmc_power_vector_get_dimension(constraints)); /** This is quadrature helper structure **/
+
+    long const num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    /** By default one quadrature thread per processor, kept for all iterations **/
+    maxentmc_thread_pool_t pool = maxentmc_thread_pool_alloc((num_threads>0)?num_threads:((num_cpus>0)?(size_t)num_cpus:1));
+    maxentmc_quad_helper_set_thread_pool(quad,pool);
 
+    int error_flag = -1;
+    size_t num_iter;
+
+    if(!maxentmc_quad_helper_set_reduction_mode(quad,reduction_mode)) /** With a deterministic reduction, the result does not depend on the number of threads **/
+        error_flag = maxentmc_basic_algorithm_solve(&shared, constraints, quad, method, tolerance, speculative, 1, &num_iter);
+
+    maxentmc_quad_helper_free(quad);
+    maxentmc_thread_pool_free(pool);
+    maxentmc_basic_algorithm_shared_free(&shared);
+
+    return error_flag;
+
+}
+
+/** Solves one problem with the given quadrature helper. The constraints must have the powers of shared->constraints **/
+
+static int maxentmc_basic_algorithm_solve(struct maxentmc_basic_algorithm_shared_struct const * const shared, maxentmc_power_vector_t const constraints,
+                                          maxentmc_quad_helper_t const quad, struct maxentmc_basic_algorithm_quadrature_struct const * const method,
+                                          maxentmc_float_t const tolerance, int const speculative, int const verbose, size_t * const num_iter)
+{
 
     /** Determine the dimension of the problem **/
     maxentmc_index_t const dimension = maxentmc_power_vector_get_dimension(constraints);
@@ -44,15 +270,19 @@ int maxentmc_basic_algorithm(maxentmc_power_vector_t const constraints, size_t c
     for(i=0;i<dimension;++i)
         powers[i] = 0;
     size_t pos;
-    if(maxentmc_power_vector_find_element_ca(multipliers,powers,&pos))
+    if(maxentmc_power_vector_find_element_ca(multipliers,powers,&pos)){
+        maxentmc_power_vector_free(multipliers);
         return -1;
+    }
     gsl_vector_set(&multipliers->gsl_vec,pos,-log(sqrt(8.0*atan(1.0)))*dimension); /** Use the formula pi = 4 atan 1 **/
 
     /** Set the corner multipliers of power 2 to -1/2 **/
     for(i=0;i<dimension;++i){
         powers[i] = 2;
-        if(maxentmc_power_vector_find_element_ca(multipliers,powers,&pos))
+        if(maxentmc_power_vector_find_element_ca(multipliers,powers,&pos)){
+            maxentmc_power_vector_free(multipliers);
             return -1;
+        }
         gsl_vector_set(&multipliers->gsl_vec,pos,-0.5);
         powers[i] = 0;
     }
@@ -61,17 +291,11 @@ int maxentmc_basic_algorithm(maxentmc_power_vector_t const constraints, size_t c
 
     maxentmc_power_vector_t moments_grad = maxentmc_power_vector_alloc(constraints); /** This is used to hold moments for gradient computation **/
 
-    maxentmc_power_vector_t moments_hess = maxentmc_power_vector_product_alloc(constraints,constraints); /** This is used to hold moments for hessian computation **/
-
-    maxentmc_quad_helper_t quad = maxentmc_quad_helper_alloc(dimension); /** This is quadrature helper structure **/
+    maxentmc_power_vector_t moments_hess = maxentmc_power_vector_alloc(shared->moments_hess); /** This is used to hold moments for hessian computation **/
 
     maxentmc_quad_helper_set_shift_rotation(quad,constraints); /** Automatic shift and rotation in quadrature (not necessary) **/
 
-    maxentmc_LGH_t LGH = maxentmc_LGH_alloc(moments_grad); /** This is the object for computing the lagrangian, gradient and hessian from moments.
-                                                         Allocated from any vector with constraint powers (gradient moments have suitable powers,
-                                                         constraints vector could have been used too) **/
-
-    maxentmc_LGH_add_power_vector(LGH,moments_hess);  /** Add the vector for hessian moments, to be able to extract the hessian **/
+    maxentmc_LGH_t const LGH = shared->LGH; /** This is the object for computing the lagrangian, gradient and hessian from moments **/
 
     /** Allocate the gradient, hessian and auxiliary data structures **/
 
@@ -81,27 +305,46 @@ int maxentmc_basic_algorithm(maxentmc_power_vector_t const constraints, size_t c
     gsl_vector * temp_gradient = gsl_vector_alloc(size);
     gsl_vector * step = gsl_vector_alloc(size);
 
-    /** This is diagnostics (can be commented out) **/
+    /** The speculative trials only pay off with a worker for each of them, with fewer the line search stays serial **/
+    maxentmc_thread_pool_t const pool = maxentmc_quad_helper_get_thread_pool(quad);
+    struct maxentmc_basic_algorithm_speculative_struct sp;
+    int const do_speculative = speculative && pool && (maxentmc_thread_pool_get_num_threads(pool) >= MAXENTMC_BASIC_ALGORITHM_SPECULATIVE_TRIALS) &&
+                               !maxentmc_basic_algorithm_speculative_init(&sp,constraints,quad);
+
+    /** This is diagnostics (only in verbose mode) **/
     maxentmc_float_t lagrangian;
-    maxentmc_gsl_matrix_t * eigvec = gsl_matrix_alloc(size,size);
-    maxentmc_gsl_vector_t * eigval = gsl_vector_alloc(size);
-    gsl_eigen_symm_workspace * eigen_workspace = gsl_eigen_symm_alloc(size);
+    maxentmc_gsl_matrix_t * eigvec = (verbose)?gsl_matrix_alloc(size,size):NULL;
+    maxentmc_gsl_vector_t * eigval = (verbose)?gsl_vector_alloc(size):NULL;
+    gsl_eigen_symm_workspace * eigen_workspace = (verbose)?gsl_eigen_symm_alloc(size):NULL;
     /** End diagnostics **/
 
 
     int do_it = 1; /** This is flag variable used to determine whether iterations ended or not **/
     int error_flag = 0; /** This is what is returned by this function. If non-zero, indicates error **/
-    size_t num_iter=0; /** This is iteration counter **/
+    size_t iter=0; /** This is iteration counter **/
+
+    /** The exponential in the quadrature is first computed in the fast (about 1e-7 accurate) mode, which is enough far from the solution,
+        then tightened to about 1e-12 once the gradient is small, and finally to full precision, which is the only mode where
+        convergence is accepted **/
 
-    /** Compute the initial gradient **/
+    maxentmc_float_t const accurate_exp_gnorm = 1e-2; /** Switch from fast to accurate exponential below this gradient norm **/
+    enum MAXENTMC_QUAD_HELPER_EXP_MODE exp_mode = MAXENTMC_QUAD_HELPER_EXP_FAST;
+    maxentmc_quad_helper_set_exp_mode(quad,exp_mode);
+
+    /** Compute the initial gradient. The hessian moments contain the gradient moments (and the zero power for the Lagrangian),
+        so the hessian moments are computed right away, and the first iteration does not need another pass at the same point **/
 
     maxentmc_quad_helper_set_multipliers(quad,multipliers); /** Setting Lagrange multipliers for quadrature **/
-    maxentmc_quad_helper_set_moments(quad,moments_grad);    /** Setting the moments for quadrature **/
-    maxentmc_quadrature_rectangle_uniform_ca(quad, quad_size, quad_start, quad_end); /** Use rectangular uniform quadrature **/
-    maxentmc_quad_helper_get_moments(quad,moments_grad); /** Extract computed moments **/
-    maxentmc_LGH_compute_gradient(LGH,moments_grad,constraints,gradient); /** Compute the gradient vector from the moments **/
+    maxentmc_quad_helper_set_moments(quad,moments_hess);    /** Setting the moments for quadrature **/
+    maxentmc_basic_algorithm_quadrature(quad,method); /** Use rectangular uniform quadrature **/
+    maxentmc_quad_helper_get_moments(quad,moments_hess); /** Extract computed moments **/
+    maxentmc_LGH_compute_gradient(LGH,moments_hess,constraints,gradient); /** Compute the gradient vector from the moments **/
 
     maxentmc_float_t gnorm;
+    maxentmc_power_vector_t current_moments = moments_hess; /** Moments computed at the current multipliers, for the importance sampling proposal **/
+    int have_hess = 1; /** Whether moments_hess are computed at the current multipliers **/
+    int full_step = 1; /** Whether the full Newton step was accepted at the previous iteration **/
+    int refresh_proposal = (method->num_samples != 0); /** Whether the importance sampling proposal follows the iterate **/
 
     do{
 
@@ -109,6 +352,26 @@ int maxentmc_basic_algorithm(maxentmc_power_vector_t const constraints, size_t c
 
         gnorm = gsl_blas_dnrm2(gradient);   /** Compute the square norm of the gradient (if small enough, the iterations will be stopped) **/
 
+        if(!(isnan(gnorm) || isinf(gnorm)) && exp_mode != MAXENTMC_QUAD_HELPER_EXP_FULL){
+            if(gnorm<tolerance){
+                /** Converged with approximate exponential, recompute the gradient in full precision before accepting **/
+                exp_mode = MAXENTMC_QUAD_HELPER_EXP_FULL;
+                maxentmc_quad_helper_set_exp_mode(quad,exp_mode);
+                maxentmc_quad_helper_set_multipliers(quad,multipliers);
+                maxentmc_quad_helper_set_moments(quad,moments_hess);
+                maxentmc_basic_algorithm_quadrature(quad,method);
+                maxentmc_quad_helper_get_moments(quad,moments_hess);
+                maxentmc_LGH_compute_gradient(LGH,moments_hess,constraints,gradient);
+                gnorm = gsl_blas_dnrm2(gradient);
+                have_hess = 1;
+            }
+            else if(exp_mode == MAXENTMC_QUAD_HELPER_EXP_FAST && gnorm<accurate_exp_gnorm){
+                exp_mode = MAXENTMC_QUAD_HELPER_EXP_ACCURATE;
+                refresh_proposal = 0;
+                maxentmc_quad_helper_set_exp_mode(quad,exp_mode);
+            }
+        }
+
         if(isnan(gnorm) || isinf(gnorm) || (gnorm<tolerance)){
             do_it = 0; /** The iterations are stopped **/
             if(isnan(gnorm) || isinf(gnorm))
@@ -118,21 +381,52 @@ int maxentmc_basic_algorithm(maxentmc_power_vector_t const constraints, size_t c
 
             /** Do stepping here **/
 
-            /** First, compute the gradient and Hessian from the current set of Lagrange multipliers **/
+            /** With importance sampling, the proposal first follows the current iterate, and the moments are recomputed with it.
+                Both the old and the new samples estimate the normalization of the iterate: if they disagree, the new samples miss
+                much of its mass, and the proposal of the constraints is used instead. Once the new samples give a larger gradient
+                than the old ones, the sampling error dominates the progress of the iterations, and the proposal is kept **/
+
+            if(refresh_proposal){
+                maxentmc_float_t const normalization = maxentmc_basic_algorithm_normalization(current_moments);
+                int proposal;
+                for(proposal=0;proposal<2;++proposal){
+                    maxentmc_basic_algorithm_set_proposal(quad,(do_speculative)?&sp:NULL,(proposal == 0)?current_moments:NULL,constraints);
+                    maxentmc_quad_helper_set_multipliers(quad,multipliers);
+                    maxentmc_quad_helper_set_moments(quad,moments_hess);
+                    maxentmc_basic_algorithm_quadrature(quad,method);
+                    maxentmc_quad_helper_get_moments(quad,moments_hess);
+                    if(fabs(maxentmc_basic_algorithm_normalization(moments_hess)/normalization-1.0) < 0.1)
+                        break;
+                }
+                current_moments = moments_hess;
+                maxentmc_LGH_compute_gradient(LGH,moments_hess,constraints,gradient); /** The step needs the gradient with the same samples **/
+                have_hess = 1;
+                if(!(gsl_blas_dnrm2(gradient) < gnorm))
+                    refresh_proposal = 0;
+            }
+
+            /** First, compute the Hessian from the current set of Lagrange multipliers (unless the hessian moments are already computed at this point) **/
 
-            maxentmc_quad_helper_set_multipliers(quad,multipliers); /** Setting Lagrange multipliers for quadrature **/
-            maxentmc_quad_helper_set_moments(quad,moments_hess);    /** Setting the moments for quadrature (currently hessian moments, since we will need the hessian at this stage **/
-            maxentmc_quadrature_rectangle_uniform_ca(quad, quad_size, quad_start, quad_end); /** Use rectangular uniform quadrature **/
-            maxentmc_quad_helper_get_moments(quad,moments_hess); /** Extract computed moments **/
+            if(!have_hess){
+                maxentmc_quad_helper_set_multipliers(quad,multipliers); /** Setting Lagrange multipliers for quadrature **/
+                maxentmc_quad_helper_set_moments(quad,moments_hess);    /** Setting the moments for quadrature (currently hessian moments, since we will need the hessian at this stage **/
+                maxentmc_basic_algorithm_quadrature(quad,method); /** Use rectangular uniform quadrature **/
+                maxentmc_quad_helper_get_moments(quad,moments_hess); /** Extract computed moments **/
+                current_moments = moments_hess;
+            }
             maxentmc_LGH_compute_hessian(LGH,moments_hess,hessian); /** Compute the hessian matrix from the same moments **/
 
-            /** Diagnostic info (can be commented out) **/
-            maxentmc_LGH_compute_lagrangian(LGH,moments_hess,constraints,multipliers,&lagrangian);
-            printf("----------- Iteration %zu -----------\nValue of Lagrangian %g\n",++num_iter,lagrangian);
-            printf("Norm of gradient %g\n",gnorm);
-            gsl_matrix_memcpy(eigvec,hessian);
-            gsl_eigen_symm(eigvec,eigval,eigen_workspace);
-            printf("Hessian condition number %g\n",eigval->data[0]/eigval->data[size-1]);
+            ++iter;
+
+            /** Diagnostic info (only in verbose mode) **/
+            if(verbose){
+                maxentmc_LGH_compute_lagrangian(LGH,moments_hess,constraints,multipliers,&lagrangian);
+                printf("----------- Iteration %zu -----------\nValue of Lagrangian %g\n",iter,lagrangian);
+                printf("Norm of gradient %g\n",gnorm);
+                gsl_matrix_memcpy(eigvec,hessian);
+                gsl_eigen_symm(eigvec,eigval,eigen_workspace);
+                printf("Hessian condition number %g\n",eigval->data[0]/eigval->data[size-1]);
+            }
             /** End diagnostic info **/
 
             /** Now, determine the step through Cholesky decomposition **/
@@ -141,7 +435,8 @@ int maxentmc_basic_algorithm(maxentmc_power_vector_t const constraints, size_t c
 
                 do_it = 0;
                 error_flag = -1;
-                puts("Cholesky decomposition failed, convergence failed");
+                if(verbose)
+                    puts("Cholesky decomposition failed, convergence failed");
 
             }
             else{
@@ -154,7 +449,48 @@ int maxentmc_basic_algorithm(maxentmc_power_vector_t const constraints, size_t c
                 size_t num_line_search=0;
                 maxentmc_float_t step_scale = -1.0;
 
-                do{
+                if(do_speculative){
+
+                    /** Evaluate the first scales in one pass, the full step computes the hessian moments as below **/
+                    size_t t;
+                    sp.trial[0].moments = (full_step)?moments_hess:sp.trial[0].moments_grad;
+                    for(t=0;t<MAXENTMC_BASIC_ALGORITHM_SPECULATIVE_TRIALS;++t){
+                        gsl_vector_memcpy(&sp.trial[t].multipliers->gsl_vec,&multipliers->gsl_vec);
+                        gsl_blas_daxpy(sp.trial[t].scale,step,&sp.trial[t].multipliers->gsl_vec);
+                        maxentmc_quad_helper_set_exp_mode(sp.quad[t],exp_mode);
+                        maxentmc_quad_helper_set_multipliers(sp.quad[t],sp.trial[t].multipliers);
+                        maxentmc_quad_helper_set_moments(sp.quad[t],sp.trial[t].moments);
+                    }
+                    maxentmc_basic_algorithm_quadrature_multi(sp.quad, MAXENTMC_BASIC_ALGORITHM_SPECULATIVE_TRIALS, method);
+
+                    for(t=0;t<MAXENTMC_BASIC_ALGORITHM_SPECULATIVE_TRIALS;++t)
+                        maxentmc_quad_helper_get_moments(sp.quad[t],sp.trial[t].moments);
+
+                    /** The largest acceptable scale is taken **/
+                    for(t=0;t<MAXENTMC_BASIC_ALGORITHM_SPECULATIVE_TRIALS && do_line_search;++t){
+                        maxentmc_LGH_compute_gradient(LGH,sp.trial[t].moments,constraints,sp.trial[t].gradient);
+                        maxentmc_float_t gdot;
+                        gsl_blas_ddot(step,sp.trial[t].gradient,&gdot);
+                        if(!(isnan(gdot) || isinf(gdot) || (gdot<0))){
+                            gsl_vector_memcpy(&multipliers->gsl_vec,&sp.trial[t].multipliers->gsl_vec);
+                            gsl_vector_memcpy(gradient,sp.trial[t].gradient);
+                            current_moments = sp.trial[t].moments;
+                            have_hess = full_step && (t == 0);
+                            full_step = (t == 0);
+                            num_line_search = t;
+                            do_line_search = 0;
+                        }
+                    }
+
+                    /** If no trial was acceptable, the halving continues from the next scale **/
+                    if(do_line_search){
+                        num_line_search = MAXENTMC_BASIC_ALGORITHM_SPECULATIVE_TRIALS;
+                        step_scale = sp.trial[MAXENTMC_BASIC_ALGORITHM_SPECULATIVE_TRIALS-1].scale*0.5;
+                    }
+
+                }
+
+                while(do_line_search){
 
                     /** Here we compute the temporary set of multipliers from the step **/
                     gsl_vector_memcpy(&temp_multipliers->gsl_vec,&multipliers->gsl_vec);
@@ -162,10 +498,20 @@ int maxentmc_basic_algorithm(maxentmc_power_vector_t const constraints, size_t c
                     /** Done computing temporary multipliers **/
 
                     maxentmc_quad_helper_set_multipliers(quad,temp_multipliers); /** Set the temporary multipliers in the quadrature **/
-                    maxentmc_quad_helper_set_moments(quad,moments_grad);  /** Here we do not need hessian, so set gradient moments (faster computation) **/
-                    maxentmc_quadrature_rectangle_uniform_ca(quad, quad_size, quad_start, quad_end); /** Compute quadrature **/
-                    maxentmc_quad_helper_get_moments(quad,moments_grad); /** Extract moments **/
-                    maxentmc_LGH_compute_gradient(LGH,moments_grad,constraints,temp_gradient); /** Compute the temporary gradient **/
+                    if(full_step && num_line_search == 0){
+                        /** The full Newton step was accepted last time, so it is likely accepted again: compute the hessian moments here,
+                            then the next iteration takes the hessian from the same pass instead of recomputing the moments at the same point **/
+                        maxentmc_quad_helper_set_moments(quad,moments_hess);
+                        maxentmc_basic_algorithm_quadrature(quad,method);
+                        maxentmc_quad_helper_get_moments(quad,moments_hess);
+                        maxentmc_LGH_compute_gradient(LGH,moments_hess,constraints,temp_gradient);
+                    }
+                    else{
+                        maxentmc_quad_helper_set_moments(quad,moments_grad);  /** Here we do not need hessian, so set gradient moments (faster computation) **/
+                        maxentmc_basic_algorithm_quadrature(quad,method); /** Compute quadrature **/
+                        maxentmc_quad_helper_get_moments(quad,moments_grad); /** Extract moments **/
+                        maxentmc_LGH_compute_gradient(LGH,moments_grad,constraints,temp_gradient); /** Compute the temporary gradient **/
+                    }
 
                     maxentmc_float_t gdot;
                     gsl_blas_ddot(step,temp_gradient,&gdot);
@@ -180,14 +526,18 @@ int maxentmc_basic_algorithm(maxentmc_power_vector_t const constraints, size_t c
                         /** Line search successful, copy the temporary multipliers into the main multipliers **/
                         gsl_vector_memcpy(&multipliers->gsl_vec,&temp_multipliers->gsl_vec);
                         gsl_vector_memcpy(gradient,temp_gradient);
+                        current_moments = (full_step && num_line_search == 0)?moments_hess:moments_grad;
+                        have_hess = full_step && (num_line_search == 0);
+                        full_step = (num_line_search == 0);
                         do_line_search = 0;
                     }
 
-                }while(do_line_search);
+                }
 
-                /** Diagnostic info (can be commented out) **/
+                /** Diagnostic info (only in verbose mode) **/
 
-                printf("Line search rescalings %zu\n",num_line_search);
+                if(verbose)
+                    printf("Line search rescalings %zu\n",num_line_search);
 
                 /** End diagnostic info **/
 
@@ -202,19 +552,28 @@ int maxentmc_basic_algorithm(maxentmc_power_vector_t const constraints, size_t c
         /** Computations are successful, copy the computed multipliers into the constraint vector **/
         gsl_vector_memcpy(&constraints->gsl_vec,&multipliers->gsl_vec);
 
-        /** Diagnostic info (can be commented out) **/
-        maxentmc_LGH_compute_lagrangian(LGH,moments_hess,constraints,multipliers,&lagrangian);
-        printf("----------- Iteration %zu -----------\nValue of Lagrangian %g\n",++num_iter,lagrangian);
-        printf("Norm of gradient %g\n",gnorm);
+        /** Diagnostic info (only in verbose mode) **/
+        if(verbose){
+            maxentmc_LGH_compute_lagrangian(LGH,moments_hess,constraints,multipliers,&lagrangian);
+            printf("----------- Iteration %zu -----------\nValue of Lagrangian %g\n",iter+1,lagrangian);
+            printf("Norm of gradient %g\n",gnorm);
+        }
         /** End diagnostic info **/
 
     }
 
+    *num_iter = iter;
+
     /** Release everything allocated for the computation **/
 
-    gsl_matrix_free(eigvec);
-    gsl_vector_free(eigval);
-    gsl_eigen_symm_free(eigen_workspace);
+    if(do_speculative)
+        maxentmc_basic_algorithm_speculative_free(&sp);
+
+    if(verbose){
+        gsl_matrix_free(eigvec);
+        gsl_vector_free(eigval);
+        gsl_eigen_symm_free(eigen_workspace);
+    }
 
     maxentmc_power_vector_free(temp_multipliers);
     gsl_vector_free(gradient);
@@ -224,11 +583,173 @@ int maxentmc_basic_algorithm(maxentmc_power_vector_t const constraints, size_t c
 
     maxentmc_power_vector_free(moments_grad);
     maxentmc_power_vector_free(moments_hess);
-    maxentmc_quad_helper_free(quad);
-    maxentmc_LGH_free(LGH);
 
     maxentmc_power_vector_free(multipliers);
 
     return error_flag;
 
 }
+
+/** Batch solver: problems are grouped by their set of powers, every group shares one set of power, product and LGH
+    structures, and the problems are scheduled on the workers of a thread pool, one problem at a time per worker.
+    Each worker computes the quadrature of its problems serially with its own quadrature helper **/
+
+struct maxentmc_basic_algorithm_batch_struct{
+    maxentmc_power_vector_t const * v;
+    struct maxentmc_basic_algorithm_quadrature_struct method;
+    maxentmc_float_t tolerance;
+    size_t const * group; /** Index of the shared structures of each problem **/
+    struct maxentmc_basic_algorithm_shared_struct const * shared;
+    maxentmc_quad_helper_t * quad; /** Quadrature helper of each worker, reused while the dimension does not change **/
+    maxentmc_index_t * quad_dimension;
+    int * status;
+    size_t * num_iter;
+};
+
+/** Returns 1 if the two vectors have the same powers in the same order **/
+
+static int maxentmc_basic_algorithm_same_powers(maxentmc_power_vector_t const a, maxentmc_power_vector_t const b)
+{
+    if(a->powers == b->powers)
+        return 1;
+    maxentmc_index_t const dimension = maxentmc_power_vector_get_dimension(a);
+    if(dimension != maxentmc_power_vector_get_dimension(b) || a->gsl_vec.size != b->gsl_vec.size)
+        return 0;
+    maxentmc_index_t pa[dimension], pb[dimension], i;
+    size_t j;
+    for(j=0;j<a->gsl_vec.size;++j){
+        maxentmc_power_vector_get_powers_ca(a,j,pa);
+        maxentmc_power_vector_get_powers_ca(b,j,pb);
+        for(i=0;i<dimension;++i)
+            if(pa[i] != pb[i])
+                return 0;
+    }
+    return 1;
+}
+
+static int maxentmc_basic_algorithm_batch_chunk(void * const arg, size_t const c, size_t const index)
+{
+    struct maxentmc_basic_algorithm_batch_struct * const b = arg;
+    struct maxentmc_basic_algorithm_shared_struct const * const shared = b->shared+b->group[c];
+    maxentmc_index_t const dimension = maxentmc_power_vector_get_dimension(b->v[c]);
+
+    int status = -1;
+    size_t num_iter = 0;
+
+    if(b->quad[index] && b->quad_dimension[index] != dimension){
+        maxentmc_quad_helper_free(b->quad[index]);
+        b->quad[index] = NULL;
+    }
+    if(b->quad[index] == NULL){
+        b->quad[index] = maxentmc_quad_helper_alloc(dimension);
+        b->quad_dimension[index] = dimension;
+#ifdef MAXENTMC_MPI
+        /** A problem is solved by one worker of one rank, the other ranks are not taking part in its quadrature **/
+        if(b->quad[index])
+            maxentmc_quad_helper_set_communicator(b->quad[index],MPI_COMM_NULL);
+#endif
+    }
+
+    if(b->quad[index]){
+        if(b->v[c]->powers == shared->constraints->powers)
+            status = maxentmc_basic_algorithm_solve(shared, b->v[c], b->quad[index], &b->method, b->tolerance, 0, 0, &num_iter);
+        else{
+            /** The LGH object only accepts vectors with its own powers, solve on a copy with them **/
+            maxentmc_power_vector_t constraints = maxentmc_power_vector_alloc(shared->constraints);
+            if(constraints){
+                gsl_vector_memcpy(&constraints->gsl_vec,&b->v[c]->gsl_vec);
+                status = maxentmc_basic_algorithm_solve(shared, constraints, b->quad[index], &b->method, b->tolerance, 0, 0, &num_iter);
+                if(!status)
+                    gsl_vector_memcpy(&b->v[c]->gsl_vec,&constraints->gsl_vec);
+                maxentmc_power_vector_free(constraints);
+            }
+        }
+    }
+
+    if(b->status)
+        b->status[c] = status;
+    if(b->num_iter)
+        b->num_iter[c] = num_iter;
+
+    return status;
+}
+
+int maxentmc_basic_algorithm_batch(maxentmc_power_vector_t const * const v, size_t const num_problems, size_t const * const quad_size,
+                                   maxentmc_float_t const * const quad_start, maxentmc_float_t const * const quad_end,
+                                   maxentmc_float_t const tolerance, maxentmc_thread_pool_t const pool, int * const status, size_t * const num_iter)
+{
+
+    if(v == NULL){
+        fputs(" MaxEntMC basic algorithm error: provided array of constraint vectors is NULL\n",stderr);
+        return -1;
+    }
+
+    size_t c, g, num_groups = 0;
+    for(c=0;c<num_problems;++c)
+        if(v[c] == NULL){
+            fputs(" MaxEntMC basic algorithm error: provided constraint vector is NULL\n",stderr);
+            return -1;
+        }
+
+    size_t * const group = malloc(num_problems*sizeof(size_t));
+    struct maxentmc_basic_algorithm_shared_struct * const shared = malloc(num_problems*sizeof(struct maxentmc_basic_algorithm_shared_struct));
+    if((group == NULL || shared == NULL) && num_problems > 0){
+        fputs(" MaxEntMC basic algorithm error: could not allocate memory\n",stderr);
+        free(group);
+        free(shared);
+        return -1;
+    }
+
+    /** Group the problems by their powers, the first problem of every group provides the shared structures **/
+
+    int error_flag = 0;
+    for(c=0;c<num_problems && !error_flag;++c){
+        for(g=0;g<num_groups;++g)
+            if(maxentmc_basic_algorithm_same_powers(shared[g].constraints,v[c]))
+                break;
+        if(g == num_groups){
+            if(maxentmc_basic_algorithm_shared_init(shared+g,v[c]))
+                error_flag = -1;
+            else
+                ++num_groups;
+        }
+        group[c] = g;
+    }
+
+    /** Without a pool, one worker per processor for this call **/
+
+    maxentmc_thread_pool_t own_pool = NULL;
+    if(!error_flag && pool == NULL){
+        long const num_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+        own_pool = maxentmc_thread_pool_alloc((num_cpus>0)?(size_t)num_cpus:1);
+        if(own_pool == NULL)
+            error_flag = -1;
+    }
+
+    if(!error_flag){
+        maxentmc_thread_pool_t const p = (pool)?pool:own_pool;
+        size_t const num_threads = maxentmc_thread_pool_get_num_threads(p);
+        size_t t;
+        maxentmc_quad_helper_t quad[num_threads];
+        maxentmc_index_t quad_dimension[num_threads];
+        for(t=0;t<num_threads;++t)
+            quad[t] = NULL;
+
+        struct maxentmc_basic_algorithm_batch_struct b = {v, {quad_size, quad_start, quad_end, 0, 0, 0}, tolerance, group, shared,
+                                                           quad, quad_dimension, status, num_iter};
+        if(maxentmc_thread_pool_run_chunks(p, num_problems, maxentmc_basic_algorithm_batch_chunk, NULL, &b))
+            error_flag = -1;
+
+        for(t=0;t<num_threads;++t)
+            maxentmc_quad_helper_free(quad[t]);
+    }
+
+    maxentmc_thread_pool_free(own_pool);
+    for(g=0;g<num_groups;++g)
+        maxentmc_basic_algorithm_shared_free(shared+g);
+    free(group);
+    free(shared);
+
+    return error_flag;
+
+}
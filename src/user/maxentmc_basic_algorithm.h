@@ -21,10 +21,45 @@
 #include <gsl/gsl_eigen.h>
 #include "../user/maxentmc.h"
 #include "../user/maxentmc_quad_rectangle_uniform.h"
+#include "../user/maxentmc_quad_importance.h"
 
 int maxentmc_basic_algorithm(maxentmc_power_vector_t const v, size_t const * const quad_size, maxentmc_float_t const * const quad_start,
                              maxentmc_float_t const * const quad_end, maxentmc_float_t const tolerance);
 /** On input, v contains input contraints. On successful output, v contains computed Lagrange multipliers.
     quad_size, quad_start and quad_end are inputs to maxentmc_quad_rectangle_uniform_ca **/
 
+int maxentmc_basic_algorithm_parallel(maxentmc_power_vector_t const v, size_t const * const quad_size, maxentmc_float_t const * const quad_start,
+                                      maxentmc_float_t const * const quad_end, maxentmc_float_t const tolerance, size_t const num_threads,
+                                      enum MAXENTMC_QUAD_HELPER_REDUCTION_MODE const reduction_mode);
+/** Same as maxentmc_basic_algorithm with num_threads quadrature threads (0 for one per processor) and the given reduction mode.
+    With MAXENTMC_QUAD_HELPER_REDUCTION_DETERMINISTIC or _COMPENSATED the output is bitwise identical for any number of threads. **/
+
+int maxentmc_basic_algorithm_speculative(maxentmc_power_vector_t const v, size_t const * const quad_size, maxentmc_float_t const * const quad_start,
+                                         maxentmc_float_t const * const quad_end, maxentmc_float_t const tolerance, size_t const num_threads,
+                                         enum MAXENTMC_QUAD_HELPER_REDUCTION_MODE const reduction_mode);
+/** Same as maxentmc_basic_algorithm_parallel with a speculative line search: the step scales 1, 1/2, 1/4 and 1/8 are evaluated
+    in one quadrature pass on the same workers, each with its own multipliers and thread accumulators, and the largest acceptable
+    scale is taken (halving continues serially if none is). With fewer than four threads the line search is the serial one.
+    The steps are those of the serial line search, and with a deterministic reduction mode the result is bitwise identical to
+    maxentmc_basic_algorithm_parallel. **/
+
+int maxentmc_basic_algorithm_importance(maxentmc_power_vector_t const v, size_t const num_samples, maxentmc_float_t const width,
+                                        uint64_t const seed, maxentmc_float_t const tolerance, size_t const num_threads,
+                                        enum MAXENTMC_QUAD_HELPER_REDUCTION_MODE const reduction_mode);
+/** Same as maxentmc_basic_algorithm_parallel with the rectangle replaced by maxentmc_quadrature_importance_ca with num_samples
+    samples, width and seed: at every iteration the proposal is moved to the mean and covariance of the current iterate, until
+    this no longer reduces the gradient or the gradient is small enough for the accurate exponential, after which the samples
+    are kept so that the iterations converge.
+    The result is deterministic given the seed, and with a deterministic reduction mode does not depend on the number of threads. **/
+
+int maxentmc_basic_algorithm_batch(maxentmc_power_vector_t const * const v, size_t const num_problems, size_t const * const quad_size,
+                                   maxentmc_float_t const * const quad_start, maxentmc_float_t const * const quad_end,
+                                   maxentmc_float_t const tolerance, maxentmc_thread_pool_t const pool, int * const status, size_t * const num_iter);
+/** Solves the num_problems independent problems v[0],...,v[num_problems-1] concurrently, one problem at a time per worker of the pool
+    (NULL for a pool with one worker per processor for this call), each problem as maxentmc_basic_algorithm without diagnostics.
+    The power, product and LGH structures are shared by all problems with the same powers. quad_size, quad_start and quad_end
+    are used for all problems and must be at least as long as the largest dimension. If not NULL, status[i] receives the
+    return value for v[i] and num_iter[i] the number of Newton iterations. Returns 0 if all problems were solved.
+    The batch is local to the calling rank: with MPI, every rank solves the problems it is given on its own. **/
+
 #endif // MAXENTMC_BASIC_ALGORITHM_H_INCLUDED
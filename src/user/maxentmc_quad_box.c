@@ -0,0 +1,229 @@
+/** This file is part of MaxEntMC, a maximum entropy algorithm with moment constraints. **/
+/** Copyright (C) 2014 Rafail V. Abramov.                                               **/
+/**                                                                                     **/
+/** This program is free software: you can redistribute it and/or modify it under the   **/
+/** terms of the GNU General Public License as published by the Free Software           **/
+/** Foundation, either version 3 of the License, or (at your option) any later version. **/
+/**                                                                                     **/
+/** This program is distributed in the hope that it will be useful, but WITHOUT ANY     **/
+/** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     **/
+/** PARTICULAR PURPOSE.  See the GNU General Public License for more details.           **/
+/**                                                                                     **/
+/** You should have received a copy of the GNU General Public License along with this   **/
+/** program.  If not, see <http://www.gnu.org/licenses/>.                               **/
+
+#include <stdlib.h>
+#include <math.h>
+#include <pthread.h>
+#include "maxentmc_quad_box.h"
+
+#define MAXENTMC_QUADRATURE_GAUSS_LEGENDRE_EPS 1e-15
+#define MAXENTMC_QUADRATURE_GAUSS_LEGENDRE_MAX_ITER 100
+
+/** Cached tables of the rules on [-1,1], in a list that only grows, so that a table never moves once it is found **/
+
+struct maxentmc_quadrature_rule_struct {
+    struct maxentmc_quadrature_rule_struct * next;
+    enum MAXENTMC_QUADRATURE_RULE rule;
+    size_t n;
+    maxentmc_float_t * nodes, * weights;
+};
+
+static struct maxentmc_quadrature_rule_struct * maxentmc_quadrature_rule_cache = NULL;
+
+static pthread_mutex_t maxentmc_quadrature_rule_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/** Roots of the Legendre polynomial by Newton iterations on the recurrence, from the guesses cos(pi(i+3/4)/(n+1/2)) **/
+
+static int maxentmc_quadrature_rule_gauss_legendre(size_t const n, maxentmc_float_t * const nodes, maxentmc_float_t * const weights)
+{
+    maxentmc_float_t const pi = 4.0*atan(1.0);
+    size_t i, j, iter;
+
+    for(i=0;i<(n+1)/2;++i){
+        maxentmc_float_t z = cos(pi*(i+0.75)/(n+0.5)), z1, p1, p2, p3, pp = 0;
+        for(iter=0;iter<MAXENTMC_QUADRATURE_GAUSS_LEGENDRE_MAX_ITER;++iter){
+            p1 = 1.0;
+            p2 = 0.0;
+            for(j=1;j<=n;++j){
+                p3 = p2;
+                p2 = p1;
+                p1 = ((2.0*j-1.0)*z*p2-(j-1.0)*p3)/j;
+            }
+            pp = n*(z*p1-p2)/(z*z-1.0);
+            z1 = z;
+            z = z1-p1/pp;
+            if(fabs(z-z1) <= MAXENTMC_QUADRATURE_GAUSS_LEGENDRE_EPS)
+                break;
+        }
+        if(iter == MAXENTMC_QUADRATURE_GAUSS_LEGENDRE_MAX_ITER){
+            fputs("maxentmc_quadrature_rule: Gauss-Legendre nodes did not converge",stderr);
+            return -1;
+        }
+        nodes[i] = -z;
+        nodes[n-1-i] = z;
+        weights[i] = weights[n-1-i] = 2.0/((1.0-z*z)*pp*pp);
+    }
+
+    if(n%2)
+        nodes[n/2] = 0.0;
+
+    return 0;
+}
+
+/** Nodes cos(pi k/N), N = n-1, and the weights from the cosine series of the rule **/
+
+static int maxentmc_quadrature_rule_clenshaw_curtis(size_t const n, maxentmc_float_t * const nodes, maxentmc_float_t * const weights)
+{
+    if(n == 1){
+        nodes[0] = 0.0;
+        weights[0] = 2.0;
+        return 0;
+    }
+
+    maxentmc_float_t const pi = 4.0*atan(1.0);
+    size_t const N = n-1;
+    size_t j, k;
+
+    for(k=0;k<=N;++k){
+        maxentmc_float_t s = 1.0;
+        for(j=1;j<=N/2;++j)
+            s -= ((2*j == N)?1.0:2.0)/(4.0*j*j-1.0)*cos(2.0*pi*j*k/N);
+        weights[k] = ((k == 0 || k == N)?1.0:2.0)*s/N;
+        /** Nodes in increasing order, the middle one exactly zero **/
+        nodes[k] = (2*k == N)?0.0:-cos(pi*k/N);
+    }
+
+    return 0;
+}
+
+int maxentmc_quadrature_rule(enum MAXENTMC_QUADRATURE_RULE const rule, size_t const n, maxentmc_float_t const ** const nodes,
+                             maxentmc_float_t const ** const weights)
+{
+    if(n == 0){
+        fputs("maxentmc_quadrature_rule: zero number of points",stderr);
+        return -1;
+    }
+
+    pthread_mutex_lock(&maxentmc_quadrature_rule_lock);
+
+    struct maxentmc_quadrature_rule_struct * r = maxentmc_quadrature_rule_cache;
+
+    while(r && !(r->rule == rule && r->n == n))
+        r = r->next;
+
+    if(r == NULL){
+        r = malloc(sizeof(struct maxentmc_quadrature_rule_struct)+sizeof(maxentmc_float_t)*2*n);
+        if(r){
+            r->rule = rule;
+            r->n = n;
+            r->nodes = (maxentmc_float_t *)(r+1);
+            r->weights = r->nodes+n;
+            int const status = (rule == MAXENTMC_QUADRATURE_RULE_GAUSS_LEGENDRE)?
+                               maxentmc_quadrature_rule_gauss_legendre(n,r->nodes,r->weights):
+                               maxentmc_quadrature_rule_clenshaw_curtis(n,r->nodes,r->weights);
+            if(status){
+                free(r);
+                r = NULL;
+            }
+            else{
+                r->next = maxentmc_quadrature_rule_cache;
+                maxentmc_quadrature_rule_cache = r;
+            }
+        }
+        else
+            fputs("maxentmc_quadrature_rule: could not allocate the table",stderr);
+    }
+
+    pthread_mutex_unlock(&maxentmc_quadrature_rule_lock);
+
+    if(r == NULL)
+        return -1;
+
+    *nodes = r->nodes;
+    *weights = r->weights;
+
+    return 0;
+}
+
+void maxentmc_quadrature_rule_cache_free(void)
+{
+    pthread_mutex_lock(&maxentmc_quadrature_rule_lock);
+
+    while(maxentmc_quadrature_rule_cache){
+        struct maxentmc_quadrature_rule_struct * const r = maxentmc_quadrature_rule_cache;
+        maxentmc_quadrature_rule_cache = r->next;
+        free(r);
+    }
+
+    pthread_mutex_unlock(&maxentmc_quadrature_rule_lock);
+}
+
+/** Maps the rule from [-1,1] to the box and runs the tensor driver **/
+
+static int maxentmc_quadrature_box_run(maxentmc_quad_helper_t const quad, enum MAXENTMC_QUADRATURE_RULE const rule,
+                                       size_t const * const num_points, maxentmc_float_t const * const start,
+                                       maxentmc_float_t const * const end)
+{
+    if(quad == NULL){
+        fputs("maxentmc_quadrature_box: NULL pointer is given as quadrature helper structure",stderr);
+        return -1;
+    }
+
+    maxentmc_index_t const dim = maxentmc_quad_helper_get_dimension(quad);
+    maxentmc_index_t i;
+    size_t total = 0, k;
+
+    for(i=0;i<dim;++i){
+        if(num_points[i] == 0){
+            fputs("maxentmc_quadrature_box: zero number of points",stderr);
+            return -1;
+        }
+        total += num_points[i];
+    }
+
+    maxentmc_float_t * const table = malloc(sizeof(maxentmc_float_t)*2*total);
+    if(table == NULL){
+        fputs("maxentmc_quadrature_box: could not allocate node storage",stderr);
+        return -1;
+    }
+
+    maxentmc_float_t const * nodes[dim], * weights[dim];
+    maxentmc_float_t * p = table;
+    int status = 0;
+
+    for(i=0;i<dim && !status;++i){
+        maxentmc_float_t const * t, * w;
+        status = maxentmc_quadrature_rule(rule,num_points[i],&t,&w);
+        if(status)
+            break;
+        maxentmc_float_t const center = 0.5*(start[i]+end[i]);
+        maxentmc_float_t const half = 0.5*(end[i]-start[i]);
+        for(k=0;k<num_points[i];++k){
+            p[k] = center+half*t[k];
+            p[num_points[i]+k] = half*w[k];
+        }
+        nodes[i] = p;
+        weights[i] = p+num_points[i];
+        p += 2*num_points[i];
+    }
+
+    if(!status)
+        status = maxentmc_quadrature_tensor_ca(quad, num_points, nodes, weights);
+
+    free(table);
+
+    return status;
+}
+
+int maxentmc_quadrature_gauss_legendre_ca(maxentmc_quad_helper_t const quad, size_t const * const num_points,
+                                          maxentmc_float_t const * const start, maxentmc_float_t const * const end)
+{
+    return maxentmc_quadrature_box_run(quad, MAXENTMC_QUADRATURE_RULE_GAUSS_LEGENDRE, num_points, start, end);
+}
+
+int maxentmc_quadrature_clenshaw_curtis_ca(maxentmc_quad_helper_t const quad, size_t const * const num_points,
+                                           maxentmc_float_t const * const start, maxentmc_float_t const * const end)
+{
+    return maxentmc_quadrature_box_run(quad, MAXENTMC_QUADRATURE_RULE_CLENSHAW_CURTIS, num_points, start, end);
+}
@@ -0,0 +1,43 @@
+/** This file is part of MaxEntMC, a maximum entropy algorithm with moment constraints. **/
+/** Copyright (C) 2014 Rafail V. Abramov.                                               **/
+/**                                                                                     **/
+/** This program is free software: you can redistribute it and/or modify it under the   **/
+/** terms of the GNU General Public License as published by the Free Software           **/
+/** Foundation, either version 3 of the License, or (at your option) any later version. **/
+/**                                                                                     **/
+/** This program is distributed in the hope that it will be useful, but WITHOUT ANY     **/
+/** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     **/
+/** PARTICULAR PURPOSE.  See the GNU General Public License for more details.           **/
+/**                                                                                     **/
+/** You should have received a copy of the GNU General Public License along with this   **/
+/** program.  If not, see <http://www.gnu.org/licenses/>.                               **/
+
+#ifndef MAXENTMC_QUAD_BOX_H_INCLUDED
+#define MAXENTMC_QUAD_BOX_H_INCLUDED
+
+#include <stdio.h>
+#include "../user/maxentmc.h"
+#include "../user/maxentmc_quad_tensor.h"
+
+enum MAXENTMC_QUADRATURE_RULE {MAXENTMC_QUADRATURE_RULE_GAUSS_LEGENDRE, MAXENTMC_QUADRATURE_RULE_CLENSHAW_CURTIS};
+/** One-dimensional rules on [-1,1]: Gauss-Legendre, exact for polynomials of degree 2n-1, and Clenshaw-Curtis on the
+    extrema of the Chebyshev polynomial, exact to degree n-1 and nested when n-1 doubles (1, 3, 5, 9, 17, ... points) **/
+
+int maxentmc_quadrature_rule(enum MAXENTMC_QUADRATURE_RULE rule, size_t n, maxentmc_float_t const ** nodes, maxentmc_float_t const ** weights);
+/** Sets *nodes and *weights to the n nodes and weights of the rule on [-1,1]. The tables are computed on the first request
+    of every rule and order and cached until maxentmc_quadrature_rule_cache_free, so the pointers stay valid until then.
+    Thread safe. **/
+
+void maxentmc_quadrature_rule_cache_free(void);
+/** Frees all cached tables, when no quadrature is running **/
+
+int maxentmc_quadrature_gauss_legendre_ca(maxentmc_quad_helper_t const quad, size_t const * const num_points,
+                                          maxentmc_float_t const * const start, maxentmc_float_t const * const end);
+
+int maxentmc_quadrature_clenshaw_curtis_ca(maxentmc_quad_helper_t const quad, size_t const * const num_points,
+                                           maxentmc_float_t const * const start, maxentmc_float_t const * const end);
+/** Tensor product rules on the box from start to end with num_points nodes along every coordinate, the same box as
+    maxentmc_quadrature_rectangle_uniform_ca. Smooth densities need several times fewer points per coordinate than
+    the uniform rule **/
+
+#endif // MAXENTMC_QUAD_BOX_H_INCLUDED
@@ -0,0 +1,151 @@
+/** This file is part of MaxEntMC, a maximum entropy algorithm with moment constraints. **/
+/** Copyright (C) 2014 Rafail V. Abramov.                                               **/
+/**                                                                                     **/
+/** This program is free software: you can redistribute it and/or modify it under the   **/
+/** terms of the GNU General Public License as published by the Free Software           **/
+/** Foundation, either version 3 of the License, or (at your option) any later version. **/
+/**                                                                                     **/
+/** This program is distributed in the hope that it will be useful, but WITHOUT ANY     **/
+/** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     **/
+/** PARTICULAR PURPOSE.  See the GNU General Public License for more details.           **/
+/**                                                                                     **/
+/** You should have received a copy of the GNU General Public License along with this   **/
+/** program.  If not, see <http://www.gnu.org/licenses/>.                               **/
+
+#include <stdlib.h>
+#include <math.h>
+#include "maxentmc_quad_gauss_hermite.h"
+
+#define MAXENTMC_QUADRATURE_GAUSS_HERMITE_EPS 3e-14
+#define MAXENTMC_QUADRATURE_GAUSS_HERMITE_MAX_ITER 20
+
+/** Nodes and weights of the n-point rule for the weight exp(-y^2/(2 width^2)), with the weights divided by the weight if
+    corrected (the plain rule is normalized to the Gaussian density instead). The roots of the Hermite polynomial H_n(t) are found by Newton iterations on the orthonormal recurrence, starting from
+    the usual asymptotic guesses, then y = sqrt(2) width t. The weights are computed through logarithms, so that the corrected
+    weights of the outer nodes, products of a very small and a very large number, do not overflow **/
+
+static int maxentmc_quadrature_gauss_hermite_rule(size_t const n, maxentmc_float_t * const nodes, maxentmc_float_t * const weights,
+                                                  maxentmc_float_t const width, int const corrected)
+{
+    maxentmc_float_t const pi = 4.0*atan(1.0);
+    maxentmc_float_t const pim4 = pow(pi,-0.25);
+    maxentmc_float_t z = 0, z1, pp = 0, p1, p2, p3;
+    size_t i, j, iter;
+
+    for(i=0;i<(n+1)/2;++i){
+
+        if(i == 0)
+            z = sqrt((maxentmc_float_t)(2*n+1))-1.85575*pow((maxentmc_float_t)(2*n+1),-0.16667);
+        else if(i == 1)
+            z -= 1.14*pow((maxentmc_float_t)n,0.426)/z;
+        else if(i == 2)
+            z = 1.86*z-0.86*nodes[0];
+        else if(i == 3)
+            z = 1.91*z-0.91*nodes[1];
+        else
+            z = 2.0*z-nodes[i-2];
+
+        for(iter=0;iter<MAXENTMC_QUADRATURE_GAUSS_HERMITE_MAX_ITER;++iter){
+            p1 = pim4;
+            p2 = 0.0;
+            for(j=1;j<=n;++j){
+                p3 = p2;
+                p2 = p1;
+                p1 = z*sqrt(2.0/j)*p2-sqrt((j-1.0)/j)*p3;
+            }
+            pp = sqrt(2.0*n)*p2;
+            z1 = z;
+            z = z1-p1/pp;
+            if(fabs(z-z1) <= MAXENTMC_QUADRATURE_GAUSS_HERMITE_EPS*fmax(1.0,fabs(z))) /** Absolute at the root 0 of odd n **/
+                break;
+        }
+        if(iter == MAXENTMC_QUADRATURE_GAUSS_HERMITE_MAX_ITER){
+            fputs("maxentmc_quadrature_gauss_hermite: nodes did not converge",stderr);
+            return -1;
+        }
+
+        /** Keep the t roots in nodes[] for the guesses, scaled at the end **/
+        nodes[i] = z;
+        nodes[n-1-i] = -z;
+        maxentmc_float_t const log_w = log(2.0)-2.0*log(fabs(pp)); /** Weight of the rule for exp(-t^2) **/
+        weights[i] = weights[n-1-i] = (corrected)?sqrt(2.0)*exp(log_w+z*z):exp(log_w)/sqrt(pi);
+    }
+
+    if(n%2)
+        nodes[n/2] = 0.0;
+
+    for(i=0;i<n;++i){
+        nodes[i] *= sqrt(2.0)*width;
+        if(corrected)
+            weights[i] *= width;
+    }
+
+    return 0;
+}
+
+static int maxentmc_quadrature_gauss_hermite_run(maxentmc_quad_helper_t const quad, size_t const * const num_points,
+                                                 maxentmc_float_t const width, int const corrected)
+{
+    if(quad == NULL){
+        fputs("maxentmc_quadrature_gauss_hermite: NULL pointer is given as quadrature helper structure",stderr);
+        return -1;
+    }
+
+    if(!(width > 0)){
+        fputs("maxentmc_quadrature_gauss_hermite: width of the Gaussian weight is not positive",stderr);
+        return -1;
+    }
+
+    maxentmc_index_t const dim = maxentmc_quad_helper_get_dimension(quad);
+    maxentmc_index_t i;
+    size_t total = 0;
+
+    for(i=0;i<dim;++i){
+        if(num_points[i] == 0){
+            fputs("maxentmc_quadrature_gauss_hermite: zero number of points",stderr);
+            return -1;
+        }
+        total += num_points[i];
+    }
+
+    maxentmc_float_t * const table = malloc(sizeof(maxentmc_float_t)*2*total);
+    if(table == NULL){
+        fputs("maxentmc_quadrature_gauss_hermite: could not allocate node storage",stderr);
+        return -1;
+    }
+
+    maxentmc_float_t const * nodes[dim], * weights[dim];
+    maxentmc_float_t * p = table;
+    int status = 0;
+
+    for(i=0;i<dim && !status;++i){
+        /** Axes with the same number of points share the table of the previous one **/
+        if(i>0 && num_points[i] == num_points[i-1]){
+            nodes[i] = nodes[i-1];
+            weights[i] = weights[i-1];
+            continue;
+        }
+        status = maxentmc_quadrature_gauss_hermite_rule(num_points[i],p,p+num_points[i],width,corrected);
+        nodes[i] = p;
+        weights[i] = p+num_points[i];
+        p += 2*num_points[i];
+    }
+
+    if(!status)
+        status = maxentmc_quadrature_tensor_ca(quad, num_points, nodes, weights);
+
+    free(table);
+
+    return status;
+}
+
+int maxentmc_quadrature_gauss_hermite_ca(maxentmc_quad_helper_t const quad, size_t const * const num_points)
+{
+    return maxentmc_quadrature_gauss_hermite_run(quad, num_points, 1.0, 0);
+}
+
+int maxentmc_quadrature_gauss_hermite_corrected_ca(maxentmc_quad_helper_t const quad, size_t const * const num_points,
+                                                   maxentmc_float_t const width)
+{
+    return maxentmc_quadrature_gauss_hermite_run(quad, num_points, width, 1);
+}
@@ -0,0 +1,34 @@
+/** This file is part of MaxEntMC, a maximum entropy algorithm with moment constraints. **/
+/** Copyright (C) 2014 Rafail V. Abramov.                                               **/
+/**                                                                                     **/
+/** This program is free software: you can redistribute it and/or modify it under the   **/
+/** terms of the GNU General Public License as published by the Free Software           **/
+/** Foundation, either version 3 of the License, or (at your option) any later version. **/
+/**                                                                                     **/
+/** This program is distributed in the hope that it will be useful, but WITHOUT ANY     **/
+/** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     **/
+/** PARTICULAR PURPOSE.  See the GNU General Public License for more details.           **/
+/**                                                                                     **/
+/** You should have received a copy of the GNU General Public License along with this   **/
+/** program.  If not, see <http://www.gnu.org/licenses/>.                               **/
+
+#ifndef MAXENTMC_QUAD_GAUSS_HERMITE_H_INCLUDED
+#define MAXENTMC_QUAD_GAUSS_HERMITE_H_INCLUDED
+
+#include <stdio.h>
+#include "../user/maxentmc.h"
+#include "../user/maxentmc_quad_tensor.h"
+
+int maxentmc_quadrature_gauss_hermite_ca(maxentmc_quad_helper_t const quad, size_t const * const num_points);
+/** Tensor product Gauss-Hermite rule with num_points[i] nodes along the i-th coordinate of the helper, for the standard
+    Gaussian weight: the moments are those of the density times the standard Gaussian density of the helper coordinates **/
+
+int maxentmc_quadrature_gauss_hermite_corrected_ca(maxentmc_quad_helper_t const quad, size_t const * const num_points,
+                                                   maxentmc_float_t const width);
+/** Gauss-Hermite nodes for a Gaussian weight of standard deviation width, with the weights divided by the Gaussian weight,
+    so that the moments of the density itself are computed. With the shift and rotation set from the constraints and width 1
+    the rule is exact for the Gaussian density with the constraint covariance, and densities close to it need far fewer
+    nodes than the uniform rule. Densities with lighter than Gaussian tails (high even powers) converge faster with a
+    narrower weight, about 0.5, which puts the nodes where the mass is **/
+
+#endif // MAXENTMC_QUAD_GAUSS_HERMITE_H_INCLUDED
@@ -0,0 +1,148 @@
+/** This file is part of MaxEntMC, a maximum entropy algorithm with moment constraints. **/
+/** Copyright (C) 2014 Rafail V. Abramov.                                               **/
+/**                                                                                     **/
+/** This program is free software: you can redistribute it and/or modify it under the   **/
+/** terms of the GNU General Public License as published by the Free Software           **/
+/** Foundation, either version 3 of the License, or (at your option) any later version. **/
+/**                                                                                     **/
+/** This program is distributed in the hope that it will be useful, but WITHOUT ANY     **/
+/** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     **/
+/** PARTICULAR PURPOSE.  See the GNU General Public License for more details.           **/
+/**                                                                                     **/
+/** You should have received a copy of the GNU General Public License along with this   **/
+/** program.  If not, see <http://www.gnu.org/licenses/>.                               **/
+
+#include <math.h>
+#include "maxentmc_quad_importance.h"
+
+struct maxentmc_quadrature_importance_struct {
+    maxentmc_index_t dim;
+    size_t num_samples;
+    maxentmc_float_t width;
+    uint64_t seed;
+};
+
+/** The splitmix64 finalizer **/
+
+static uint64_t maxentmc_quadrature_importance_mix(uint64_t z)
+{
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/** Counter-based generator, uniform on (0,1]. The seed is mixed before the counter is added: otherwise seeds differing by a
+    multiple of the increment would give the same stream shifted by that many samples. **/
+
+static maxentmc_float_t maxentmc_quadrature_importance_uniform(uint64_t const seed, uint64_t const counter)
+{
+    uint64_t const z = maxentmc_quadrature_importance_mix(maxentmc_quadrature_importance_mix(seed)+0x9E3779B97F4A7C15ULL*(counter+1));
+    return ((z >> 11)+1)*(1.0/9007199254740992.0);
+}
+
+static int maxentmc_quadrature_importance_generate(void * const arg, size_t const begin, size_t const n,
+                                                   maxentmc_float_t * const * const x, maxentmc_float_t * const w)
+{
+    struct maxentmc_quadrature_importance_struct const * const s = arg;
+    maxentmc_float_t const two_pi = 8.0*atan(1.0);
+    maxentmc_float_t const log_norm = s->dim*(0.5*log(two_pi)+log(s->width)); /** log of (sqrt(2 pi) width)^dim **/
+    size_t const num_pairs = (s->dim+1)/2;
+    size_t k;
+
+    /** Box-Muller transform, coordinates 2j and 2j+1 of the k-th sample come from the uniforms 2(k num_pairs+j) and 2(k num_pairs+j)+1 **/
+
+    for(k=0;k<n;++k){
+        uint64_t const counter = 2*(uint64_t)(begin+k)*num_pairs;
+        maxentmc_float_t sum = 0.0;
+        maxentmc_index_t i;
+        for(i=0;i<s->dim;i+=2){
+            maxentmc_float_t const r = sqrt(-2.0*log(maxentmc_quadrature_importance_uniform(s->seed,counter+i)));
+            maxentmc_float_t const theta = two_pi*maxentmc_quadrature_importance_uniform(s->seed,counter+i+1);
+            maxentmc_float_t const y0 = r*cos(theta);
+            x[i][k] = s->width*y0;
+            sum += y0*y0;
+            if(i+1<s->dim){
+                maxentmc_float_t const y1 = r*sin(theta);
+                x[i+1][k] = s->width*y1;
+                sum += y1*y1;
+            }
+        }
+        w[k] = exp(0.5*sum+log_norm)/s->num_samples;
+    }
+
+    return 0;
+}
+
+int maxentmc_quadrature_importance_set_proposal(maxentmc_quad_helper_t const quad, maxentmc_power_vector_t const moments)
+{
+    if(quad == NULL || moments == NULL){
+        fputs("maxentmc_quadrature_importance: NULL pointer is given as quadrature helper or moments",stderr);
+        return -1;
+    }
+
+    maxentmc_index_t const dim = maxentmc_power_vector_get_dimension(moments);
+    maxentmc_index_t powers[dim], i;
+    size_t pos;
+
+    for(i=0;i<dim;++i)
+        powers[i] = 0;
+    if(maxentmc_power_vector_find_element_ca(moments,powers,&pos) || !(moments->gsl_vec.data[pos] > 0)){
+        fputs("maxentmc_quadrature_importance: moments have no positive zero power",stderr);
+        return -1;
+    }
+
+    /** The shift and rotation are computed from normalized moments **/
+
+    maxentmc_power_vector_t const normalized = maxentmc_power_vector_alloc(moments);
+    if(normalized == NULL){
+        fputs("maxentmc_quadrature_importance: could not allocate memory",stderr);
+        return -1;
+    }
+
+    maxentmc_float_t const norm = 1.0/moments->gsl_vec.data[pos];
+    size_t k;
+    for(k=0;k<moments->gsl_vec.size;++k)
+        normalized->gsl_vec.data[k] = moments->gsl_vec.data[k]*norm;
+
+    int const status = maxentmc_quad_helper_set_shift_rotation(quad,normalized);
+
+    maxentmc_power_vector_free(normalized);
+
+    return status;
+}
+
+int maxentmc_quadrature_importance_ca(maxentmc_quad_helper_t const quad, size_t const num_samples, maxentmc_float_t const width,
+                                      uint64_t const seed)
+{
+    if(quad == NULL){
+        fputs("maxentmc_quadrature_importance: NULL pointer is given as quadrature helper structure",stderr);
+        return -1;
+    }
+
+    if(!(width > 0) || num_samples == 0){
+        fputs("maxentmc_quadrature_importance: width or number of samples is not positive",stderr);
+        return -1;
+    }
+
+    struct maxentmc_quadrature_importance_struct s = {maxentmc_quad_helper_get_dimension(quad), num_samples, width, seed};
+
+    return maxentmc_quadrature_points_ca(quad, num_samples, maxentmc_quadrature_importance_generate, &s);
+}
+
+int maxentmc_quadrature_importance_multi_ca(maxentmc_quad_helper_t const * const quads, size_t const num_quads, size_t const num_samples,
+                                            maxentmc_float_t const width, uint64_t const seed)
+{
+    if(quads == NULL || num_quads == 0 || quads[0] == NULL){
+        fputs("maxentmc_quadrature_importance: NULL pointer is given as quadrature helper structure",stderr);
+        return -1;
+    }
+
+    if(!(width > 0) || num_samples == 0){
+        fputs("maxentmc_quadrature_importance: width or number of samples is not positive",stderr);
+        return -1;
+    }
+
+    struct maxentmc_quadrature_importance_struct s = {maxentmc_quad_helper_get_dimension(quads[0]), num_samples, width, seed};
+
+    return maxentmc_quadrature_points_multi_ca(quads, num_quads, num_samples, maxentmc_quadrature_importance_generate, &s);
+}
@@ -0,0 +1,41 @@
+/** This file is part of MaxEntMC, a maximum entropy algorithm with moment constraints. **/
+/** Copyright (C) 2014 Rafail V. Abramov.                                               **/
+/**                                                                                     **/
+/** This program is free software: you can redistribute it and/or modify it under the   **/
+/** terms of the GNU General Public License as published by the Free Software           **/
+/** Foundation, either version 3 of the License, or (at your option) any later version. **/
+/**                                                                                     **/
+/** This program is distributed in the hope that it will be useful, but WITHOUT ANY     **/
+/** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     **/
+/** PARTICULAR PURPOSE.  See the GNU General Public License for more details.           **/
+/**                                                                                     **/
+/** You should have received a copy of the GNU General Public License along with this   **/
+/** program.  If not, see <http://www.gnu.org/licenses/>.                               **/
+
+#ifndef MAXENTMC_QUAD_IMPORTANCE_H_INCLUDED
+#define MAXENTMC_QUAD_IMPORTANCE_H_INCLUDED
+
+#include <stdio.h>
+#include <stdint.h>
+#include "../user/maxentmc.h"
+#include "../user/maxentmc_quad_points.h"
+
+int maxentmc_quadrature_importance_set_proposal(maxentmc_quad_helper_t const quad, maxentmc_power_vector_t const moments);
+/** Sets the shift and rotation of the helper from the mean and covariance of the (not necessarily normalized) moments,
+    for example the hessian moments of the current iterate, so that the helper's coordinates are whitened for the density
+    these moments come from. The moments must contain the zero, first and second powers. **/
+
+int maxentmc_quadrature_importance_ca(maxentmc_quad_helper_t const quad, size_t const num_samples, maxentmc_float_t const width,
+                                      uint64_t const seed);
+/** Monte Carlo quadrature with num_samples points drawn from the Gaussian with standard deviation width along every
+    coordinate of the helper (the mean and covariance of the proposal, once set with maxentmc_quadrature_importance_set_proposal,
+    scaled by width), each weighted by the inverse of the proposal density. The k-th sample is computed from the seed and k
+    alone, so every thread generates the samples of its own points and the result does not depend on the number of threads. **/
+
+int maxentmc_quadrature_importance_multi_ca(maxentmc_quad_helper_t const * const quads, size_t const num_quads, size_t const num_samples,
+                                            maxentmc_float_t const width, uint64_t const seed);
+/** The quadratures of num_quads helpers of the same dimension over the same samples in one pass, as in
+    maxentmc_quadrature_points_multi_ca. The samples are drawn in the coordinates of each helper, so helpers with the same
+    shift and rotation share the same points. **/
+
+#endif // MAXENTMC_QUAD_IMPORTANCE_H_INCLUDED
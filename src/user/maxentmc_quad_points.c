@@ -0,0 +1,328 @@
+/** This file is part of MaxEntMC, a maximum entropy algorithm with moment constraints. **/
+/** Copyright (C) 2014 Rafail V. Abramov.                                               **/
+/**                                                                                     **/
+/** This program is free software: you can redistribute it and/or modify it under the   **/
+/** terms of the GNU General Public License as published by the Free Software           **/
+/** Foundation, either version 3 of the License, or (at your option) any later version. **/
+/**                                                                                     **/
+/** This program is distributed in the hope that it will be useful, but WITHOUT ANY     **/
+/** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     **/
+/** PARTICULAR PURPOSE.  See the GNU General Public License for more details.           **/
+/**                                                                                     **/
+/** You should have received a copy of the GNU General Public License along with this   **/
+/** program.  If not, see <http://www.gnu.org/licenses/>.                               **/
+
+#include <stdlib.h>
+#include <pthread.h>
+#include "maxentmc_quad_points.h"
+
+/** Number of blocks of the fixed partition of the points in the deterministic reduction modes, which bounds the number of
+    threads that can share a pass **/
+
+#define MAXENTMC_QUADRATURE_POINTS_BLOCKS 64
+
+/** With a thread pool the blocks are scheduled by work stealing, a few blocks per thread leave something to steal **/
+
+#define MAXENTMC_QUADRATURE_POINTS_BLOCKS_PER_THREAD 8
+
+/** Every block is generated and computed in chunks of this many points **/
+
+#define MAXENTMC_QUADRATURE_POINTS_CHUNK 512
+
+static int maxentmc_quadrature_points_run(maxentmc_quad_helper_t const * const quads, size_t const num_quads,
+                                          maxentmc_thread_pool_t const pool, size_t const num_threads, size_t const num_points,
+                                          maxentmc_quadrature_points_generator_t const generator, void * const arg);
+
+int maxentmc_quadrature_points_ca(maxentmc_quad_helper_t const quad, size_t const num_points,
+                                  maxentmc_quadrature_points_generator_t const generator, void * const arg)
+{
+
+    if(quad == NULL){
+        fputs("maxentmc_quadrature_points: NULL pointer is given as quadrature helper structure",stderr);
+        return -1;
+    }
+
+    return maxentmc_quadrature_points_run(&quad, 1, maxentmc_quad_helper_get_thread_pool(quad), 1, num_points, generator, arg);
+
+}
+
+int maxentmc_quadrature_points_parallel_ca(maxentmc_quad_helper_t const quad, size_t const num_threads, size_t const num_points,
+                                           maxentmc_quadrature_points_generator_t const generator, void * const arg)
+{
+
+    if(quad == NULL){
+        fputs("maxentmc_quadrature_points: NULL pointer is given as quadrature helper structure",stderr);
+        return -1;
+    }
+
+    return maxentmc_quadrature_points_run(&quad, 1, NULL, num_threads, num_points, generator, arg);
+
+}
+
+int maxentmc_quadrature_points_multi_ca(maxentmc_quad_helper_t const * const quads, size_t const num_quads, size_t const num_points,
+                                        maxentmc_quadrature_points_generator_t const generator, void * const arg)
+{
+
+    size_t h;
+
+    for(h=0;h<num_quads;++h){
+        if(quads[h] == NULL){
+            fputs("maxentmc_quadrature_points: NULL pointer is given as quadrature helper structure",stderr);
+            return -1;
+        }
+        if(maxentmc_quad_helper_get_dimension(quads[h]) != maxentmc_quad_helper_get_dimension(quads[0])){
+            fputs("maxentmc_quadrature_points: quadrature helpers of different dimensions are given",stderr);
+            return -1;
+        }
+    }
+
+    if(num_quads == 0)
+        return 0;
+
+    return maxentmc_quadrature_points_run(quads, num_quads, maxentmc_quad_helper_get_thread_pool(quads[0]), 1, num_points, generator, arg);
+
+}
+
+/** The points are divided into contiguous blocks: a few per thread, or, in the deterministic reduction modes, a fixed
+    number of blocks independent of the threads, each deposited separately. A task computes blocks with its own thread
+    accumulator, either a fixed range of them, or, with a thread pool, whichever blocks its worker takes or steals. The
+    accumulators of all tasks are reduced in a tree by the tasks themselves. **/
+
+struct maxentmc_quadrature_points_task_struct {
+    maxentmc_quad_helper_t quad;
+    maxentmc_quadrature_points_generator_t generator;
+    void * arg;
+    size_t point_offset, points, blocks, block_begin, block_end, index;
+    int deposit, status, node;
+    maxentmc_float_t * chunk; /** allocated with the accumulator by the first block the task computes **/
+    struct maxentmc_quad_helper_thread_struct * quad_thread;
+};
+
+static int maxentmc_quadrature_points_task_begin(struct maxentmc_quadrature_points_task_struct * const task)
+{
+    maxentmc_index_t const dim = maxentmc_quad_helper_get_dimension(task->quad);
+
+    /** The points of a chunk in the structure-of-arrays form, followed by their weights **/
+
+    task->chunk = malloc(sizeof(maxentmc_float_t)*MAXENTMC_QUADRATURE_POINTS_CHUNK*(dim+1));
+    if(task->chunk == NULL){
+        fputs("maxentmc_quadrature_points: could not allocate point storage",stderr);
+        task->status = -1;
+        return -1;
+    }
+
+    task->quad_thread = maxentmc_quad_helper_thread_alloc_on_node(task->quad,task->node);
+    if(task->quad_thread == NULL){
+        task->status = -1;
+        return -1;
+    }
+
+    return 0;
+}
+
+static void maxentmc_quadrature_points_task_block(struct maxentmc_quadrature_points_task_struct * const task, size_t const b)
+{
+    /** A task that could not allocate its storage skips its blocks, and the pass reports an error **/
+
+    if((task->quad_thread == NULL) && ((task->status) || maxentmc_quadrature_points_task_begin(task)))
+        return;
+
+    maxentmc_index_t const dim = maxentmc_quad_helper_get_dimension(task->quad);
+    maxentmc_float_t * x[dim];
+    maxentmc_float_t * const w = task->chunk + MAXENTMC_QUADRATURE_POINTS_CHUNK*dim;
+
+    maxentmc_index_t i;
+
+    for(i=0;i<dim;++i)
+        x[i] = task->chunk + MAXENTMC_QUADRATURE_POINTS_CHUNK*i;
+
+    size_t const end = task->point_offset+(b+1)*task->points/task->blocks;
+    size_t begin;
+
+    for(begin=task->point_offset+b*task->points/task->blocks;begin<end;begin+=MAXENTMC_QUADRATURE_POINTS_CHUNK){
+        size_t const n = (end-begin<MAXENTMC_QUADRATURE_POINTS_CHUNK)?end-begin:MAXENTMC_QUADRATURE_POINTS_CHUNK;
+        if(task->generator(task->arg,begin,n,x,w)){
+            task->status = -1;
+            break;
+        }
+        maxentmc_quad_helper_thread_compute_n(task->quad_thread,n,(maxentmc_float_t const * const *)x,w);
+    }
+
+    if(task->deposit)
+        maxentmc_quad_helper_thread_deposit(task->quad_thread,b);
+}
+
+static void maxentmc_quadrature_points_task_end(struct maxentmc_quadrature_points_task_struct * const task)
+{
+    /** Every task takes part in the reduction, even one that failed or had no blocks, so that the other partial sums
+        still arrive **/
+
+    free(task->chunk);
+
+    if(maxentmc_quad_helper_reduce(task->quad,task->quad_thread,task->index))
+        task->status = -1;
+}
+
+static void * maxentmc_quadrature_points_task(void * const arg)
+{
+    struct maxentmc_quadrature_points_task_struct * const task = arg;
+
+    size_t b;
+
+    for(b=task->block_begin;b<task->block_end;++b)
+        maxentmc_quadrature_points_task_block(task,b);
+
+    maxentmc_quadrature_points_task_end(task);
+
+    return NULL;
+}
+
+/** With a thread pool, the chunks are the blocks of all helpers of the call, those of the first helper first **/
+
+struct maxentmc_quadrature_points_pass_struct {
+    struct maxentmc_quadrature_points_task_struct * task; /** [num_quads][num_threads] **/
+    size_t num_quads, num_threads;
+};
+
+static int maxentmc_quadrature_points_pool_chunk(void * const arg, size_t const chunk, size_t const index)
+{
+    struct maxentmc_quadrature_points_pass_struct const * const pass = arg;
+    struct maxentmc_quadrature_points_task_struct * task = pass->task + index;
+    size_t b = chunk;
+    while(b >= task->blocks){
+        b -= task->blocks;
+        task += pass->num_threads;
+    }
+    maxentmc_quadrature_points_task_block(task, b);
+    return task->status;
+}
+
+static void maxentmc_quadrature_points_pool_finish(void * const arg, size_t const index)
+{
+    struct maxentmc_quadrature_points_pass_struct const * const pass = arg;
+    size_t h;
+    for(h=0;h<pass->num_quads;++h)
+        maxentmc_quadrature_points_task_end(pass->task + h*pass->num_threads + index);
+}
+
+/** Computes the quadratures of the helpers over the same points with the workers of the pool, or, without a pool, one
+    after the other with num_threads threads started for this call **/
+
+static int maxentmc_quadrature_points_run(maxentmc_quad_helper_t const * const quads, size_t const num_quads,
+                                          maxentmc_thread_pool_t const pool, size_t const num_threads, size_t const num_points,
+                                          maxentmc_quadrature_points_generator_t const generator, void * const arg)
+{
+
+    if(generator == NULL){
+        fputs("maxentmc_quadrature_points: NULL pointer is given as point generator",stderr);
+        return -1;
+    }
+
+    size_t const n_threads = (pool)?maxentmc_thread_pool_get_num_threads(pool):((num_threads>0)?num_threads:1);
+
+    struct maxentmc_quadrature_points_task_struct task[num_quads*n_threads];
+
+    size_t h, t, chunks = 0;
+
+    /** On several NUMA nodes, every task keeps accumulators allocated on the node of its worker **/
+
+    int const numa = (pool && (maxentmc_thread_pool_get_num_nodes(pool) > 1));
+
+    for(h=0;h<num_quads;++h){
+
+        maxentmc_quad_helper_t const quad = quads[h];
+
+        int const deposit = (maxentmc_quad_helper_get_reduction_mode(quad) != MAXENTMC_QUAD_HELPER_REDUCTION_FAST);
+
+        size_t const blocks = (deposit)?MAXENTMC_QUADRATURE_POINTS_BLOCKS:
+                              ((pool)?MAXENTMC_QUADRATURE_POINTS_BLOCKS_PER_THREAD*n_threads:n_threads);
+
+        /** With several MPI ranks, this rank computes a contiguous share of the points **/
+
+        int rank, num_ranks;
+
+        maxentmc_quad_helper_get_rank(quad,&rank,&num_ranks);
+
+        size_t const point_offset = rank*num_points/num_ranks;
+
+        size_t const points = (rank+1)*num_points/num_ranks - point_offset;
+
+        struct maxentmc_quadrature_points_task_struct * const task_h = task + h*n_threads;
+
+        for(t=0;t<n_threads;++t){
+            task_h[t].quad = quad;
+            task_h[t].generator = generator;
+            task_h[t].arg = arg;
+            task_h[t].point_offset = point_offset;
+            task_h[t].points = points;
+            task_h[t].blocks = blocks;
+            task_h[t].block_begin = t*blocks/n_threads;
+            task_h[t].block_end = (t+1)*blocks/n_threads;
+            task_h[t].index = t;
+            task_h[t].deposit = deposit;
+            task_h[t].status = 0;
+            task_h[t].node = (numa)?maxentmc_thread_pool_get_node(pool,t):-1;
+            task_h[t].chunk = NULL;
+            task_h[t].quad_thread = NULL;
+        }
+
+        if(maxentmc_quad_helper_reduce_begin(quad,n_threads))
+            return -1;
+
+        if(deposit && maxentmc_quad_helper_reduce_blocks(quad,blocks))
+            return -1;
+
+        chunks += blocks;
+
+    }
+
+    int status = 0;
+
+    if(pool){
+
+        struct maxentmc_quadrature_points_pass_struct pass = {task, num_quads, n_threads};
+
+        if(maxentmc_thread_pool_run_chunks(pool, chunks, maxentmc_quadrature_points_pool_chunk,
+                                           maxentmc_quadrature_points_pool_finish, &pass))
+            status = -1;
+
+        for(t=0;t<num_quads*n_threads;++t)
+            if(task[t].status)
+                status = -1;
+
+        return status;
+
+    }
+
+    pthread_t thread[n_threads];
+
+    for(h=0;h<num_quads;++h){
+
+        struct maxentmc_quadrature_points_task_struct * const task_h = task + h*n_threads;
+
+        /** The last task runs on the calling thread **/
+
+        for(t=0;t+1<n_threads;++t)
+            if(pthread_create(thread+t,NULL,maxentmc_quadrature_points_task,task_h+t)){
+                fputs("maxentmc_quadrature_points: could not create a thread, computing on the calling thread",stderr);
+                maxentmc_quadrature_points_task(task_h+t);
+                thread[t] = pthread_self();
+            }
+
+        maxentmc_quadrature_points_task(task_h+n_threads-1);
+
+        if(task_h[n_threads-1].status)
+            status = -1;
+
+        for(t=0;t+1<n_threads;++t){
+            if(!pthread_equal(thread[t],pthread_self()))
+                pthread_join(thread[t],NULL);
+            if(task_h[t].status)
+                status = -1;
+        }
+
+    }
+
+    return status;
+
+}
@@ -0,0 +1,43 @@
+/** This file is part of MaxEntMC, a maximum entropy algorithm with moment constraints. **/
+/** Copyright (C) 2014 Rafail V. Abramov.                                               **/
+/**                                                                                     **/
+/** This program is free software: you can redistribute it and/or modify it under the   **/
+/** terms of the GNU General Public License as published by the Free Software           **/
+/** Foundation, either version 3 of the License, or (at your option) any later version. **/
+/**                                                                                     **/
+/** This program is distributed in the hope that it will be useful, but WITHOUT ANY     **/
+/** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     **/
+/** PARTICULAR PURPOSE.  See the GNU General Public License for more details.           **/
+/**                                                                                     **/
+/** You should have received a copy of the GNU General Public License along with this   **/
+/** program.  If not, see <http://www.gnu.org/licenses/>.                               **/
+
+#ifndef MAXENTMC_QUAD_POINTS_H_INCLUDED
+#define MAXENTMC_QUAD_POINTS_H_INCLUDED
+
+#include <stdio.h>
+#include "../user/maxentmc.h"
+
+typedef int (*maxentmc_quadrature_points_generator_t)(void * arg, size_t begin, size_t n, maxentmc_float_t * const * x, maxentmc_float_t * w);
+/** Writes the points begin,...,begin+n-1 of a quadrature rule in the structure-of-arrays form: x[i][k] is the i-th
+    coordinate of the point begin+k, and w[k] its weight. Called concurrently by several threads for disjoint ranges, so
+    it must only depend on the point indices. Returns non-zero on error. **/
+
+int maxentmc_quadrature_points_ca(maxentmc_quad_helper_t const quad, size_t const num_points,
+                                  maxentmc_quadrature_points_generator_t const generator, void * const arg);
+/** Computes the quadrature over the num_points points produced by the generator, in the coordinates of the quadrature
+    helper. With a thread pool attached to the helper, its workers compute the quadrature, otherwise the calling thread
+    alone. All quadrature drivers are generators run by this function, which honours the reduction mode and the MPI
+    ranks of the helper **/
+
+int maxentmc_quadrature_points_parallel_ca(maxentmc_quad_helper_t const quad, size_t const num_threads, size_t const num_points,
+                                           maxentmc_quadrature_points_generator_t const generator, void * const arg);
+/** The same quadrature computed by num_threads threads (including the calling one) over contiguous ranges of points **/
+
+int maxentmc_quadrature_points_multi_ca(maxentmc_quad_helper_t const * const quads, size_t const num_quads, size_t const num_points,
+                                        maxentmc_quadrature_points_generator_t const generator, void * const arg);
+/** The quadratures of num_quads helpers of the same dimension, each armed with its own multipliers and moments, over the
+    same points in one pass: the workers of the thread pool of the first helper take the blocks of all of them, each helper
+    with its own thread accumulators. Without a pool, the quadratures are computed one after the other on the calling thread **/
+
+#endif // MAXENTMC_QUAD_POINTS_H_INCLUDED
@@ -0,0 +1,248 @@
+/** This file is part of MaxEntMC, a maximum entropy algorithm with moment constraints. **/
+/** Copyright (C) 2014 Rafail V. Abramov.                                               **/
+/**                                                                                     **/
+/** This program is free software: you can redistribute it and/or modify it under the   **/
+/** terms of the GNU General Public License as published by the Free Software           **/
+/** Foundation, either version 3 of the License, or (at your option) any later version. **/
+/**                                                                                     **/
+/** This program is distributed in the hope that it will be useful, but WITHOUT ANY     **/
+/** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     **/
+/** PARTICULAR PURPOSE.  See the GNU General Public License for more details.           **/
+/**                                                                                     **/
+/** You should have received a copy of the GNU General Public License along with this   **/
+/** program.  If not, see <http://www.gnu.org/licenses/>.                               **/
+
+#include <stdlib.h>
+#include <math.h>
+#include "maxentmc_quad_qmc.h"
+
+/** The i-th coordinate of the k-th point is the radical inverse of k in the i-th prime base b, with the j-th digit replaced
+    by its image under a random permutation of 0,...,b-1, drawn for every randomization, coordinate and digit. Digits are
+    taken up to the resolution of double precision, the zero digits above the ones of k are permuted too. **/
+
+struct maxentmc_quadrature_qmc_struct {
+    maxentmc_index_t dim;
+    size_t num_points;
+    maxentmc_float_t width;
+    unsigned int * base;
+    unsigned int * num_digits;
+    unsigned char ** permutation; /** permutation[i] is [num_digits[i]][base[i]] **/
+};
+
+/** splitmix64, used to draw the permutations from the seed **/
+
+static uint64_t maxentmc_quadrature_qmc_random(uint64_t * const state)
+{
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/** Inverse of the standard Gaussian distribution: the rational approximation of Acklam (relative error 1.2e-9) refined by
+    one Halley step, which brings it to full precision **/
+
+static maxentmc_float_t maxentmc_quadrature_qmc_inverse_gaussian(maxentmc_float_t const u)
+{
+    static maxentmc_float_t const a[6] = {-3.969683028665376e+01, 2.209460984245205e+02, -2.759285104469687e+02,
+                                          1.383577518672690e+02, -3.066479806614716e+01, 2.506628277459239e+00};
+    static maxentmc_float_t const b[5] = {-5.447609879822406e+01, 1.615858368580409e+02, -1.556989798598866e+02,
+                                          6.680131188771972e+01, -1.328068155288572e+01};
+    static maxentmc_float_t const c[6] = {-7.784894002430293e-03, -3.223964580411365e-01, -2.400758277161838e+00,
+                                          -2.549732539343734e+00, 4.374664141464968e+00, 2.938163982698783e+00};
+    static maxentmc_float_t const d[4] = {7.784695709041462e-03, 3.224671290700398e-01, 2.445134137142996e+00,
+                                          3.754408661907416e+00};
+    maxentmc_float_t x, q, r;
+
+    if(u < 0.02425){
+        q = sqrt(-2.0*log(u));
+        x = (((((c[0]*q+c[1])*q+c[2])*q+c[3])*q+c[4])*q+c[5])/((((d[0]*q+d[1])*q+d[2])*q+d[3])*q+1.0);
+    }
+    else if(u > 1.0-0.02425){
+        q = sqrt(-2.0*log(1.0-u));
+        x = -(((((c[0]*q+c[1])*q+c[2])*q+c[3])*q+c[4])*q+c[5])/((((d[0]*q+d[1])*q+d[2])*q+d[3])*q+1.0);
+    }
+    else{
+        q = u-0.5;
+        r = q*q;
+        x = (((((a[0]*r+a[1])*r+a[2])*r+a[3])*r+a[4])*r+a[5])*q/(((((b[0]*r+b[1])*r+b[2])*r+b[3])*r+b[4])*r+1.0);
+    }
+
+    maxentmc_float_t const e = 0.5*erfc(-x/sqrt(2.0))-u;
+    maxentmc_float_t const h = e*sqrt(8.0*atan(1.0))*exp(0.5*x*x);
+
+    return x-h/(1.0+0.5*x*h);
+}
+
+static int maxentmc_quadrature_qmc_generate(void * const arg, size_t const begin, size_t const n,
+                                            maxentmc_float_t * const * const x, maxentmc_float_t * const w)
+{
+    struct maxentmc_quadrature_qmc_struct const * const s = arg;
+    maxentmc_float_t const log_norm = 0.5*log(8.0*atan(1.0))+log(s->width); /** log(sqrt(2 pi) width) **/
+    maxentmc_index_t i;
+    size_t k;
+
+    for(k=0;k<n;++k)
+        w[k] = 0.0;
+
+    for(i=0;i<s->dim;++i){
+        unsigned int const base = s->base[i];
+        maxentmc_float_t const inverse_base = 1.0/base;
+        for(k=0;k<n;++k){
+            size_t index = begin+k;
+            maxentmc_float_t u = 0.0, scale = inverse_base;
+            unsigned int j;
+            for(j=0;j<s->num_digits[i];++j){
+                u += s->permutation[i][j*base+index%base]*scale;
+                index /= base;
+                scale *= inverse_base;
+            }
+            if(u <= 0.0)
+                u = scale; /** Below the resolution of the digits **/
+            maxentmc_float_t const y = maxentmc_quadrature_qmc_inverse_gaussian(u);
+            x[i][k] = s->width*y;
+            w[k] += 0.5*y*y+log_norm;
+        }
+    }
+
+    for(k=0;k<n;++k)
+        w[k] = exp(w[k])/s->num_points;
+
+    return 0;
+}
+
+int maxentmc_quadrature_qmc_ca(maxentmc_quad_helper_t const quad, size_t const num_points, maxentmc_float_t const width,
+                               uint64_t const seed, size_t const randomization)
+{
+    if(quad == NULL){
+        fputs("maxentmc_quadrature_qmc: NULL pointer is given as quadrature helper structure",stderr);
+        return -1;
+    }
+
+    if(!(width > 0) || num_points == 0){
+        fputs("maxentmc_quadrature_qmc: width or number of points is not positive",stderr);
+        return -1;
+    }
+
+    maxentmc_index_t const dim = maxentmc_quad_helper_get_dimension(quad);
+
+    unsigned int base[dim], num_digits[dim];
+    unsigned char * permutation[dim];
+    size_t size = 0;
+    maxentmc_index_t i;
+    unsigned int p = 1, j, l;
+
+    /** The first dim primes, and the number of digits of each base within double precision **/
+
+    for(i=0;i<dim;++i){
+        int prime;
+        do{
+            ++p;
+            prime = 1;
+            for(j=2;j*j<=p && prime;++j)
+                prime = (p%j != 0);
+        }while(!prime);
+        base[i] = p;
+        num_digits[i] = (unsigned int)ceil(53.0*log(2.0)/log((maxentmc_float_t)p));
+        size += num_digits[i]*base[i];
+    }
+
+    if(p > 256){
+        fputs("maxentmc_quadrature_qmc: dimension too high",stderr);
+        return -1;
+    }
+
+    unsigned char * const table = malloc(size);
+    if(table == NULL){
+        fputs("maxentmc_quadrature_qmc: could not allocate the permutations",stderr);
+        return -1;
+    }
+
+    uint64_t state = seed ^ (0xD1B54A32D192ED03ULL*(randomization+1));
+    unsigned char * t = table;
+
+    for(i=0;i<dim;++i){
+        permutation[i] = t;
+        for(j=0;j<num_digits[i];++j, t+=base[i]){
+            /** Fisher-Yates shuffle **/
+            for(l=0;l<base[i];++l)
+                t[l] = l;
+            for(l=base[i]-1;l>0;--l){
+                unsigned int const m = maxentmc_quadrature_qmc_random(&state)%(l+1);
+                unsigned char const temp = t[l];
+                t[l] = t[m];
+                t[m] = temp;
+            }
+        }
+    }
+
+    struct maxentmc_quadrature_qmc_struct s = {dim, num_points, width, base, num_digits, permutation};
+
+    int const status = maxentmc_quadrature_points_ca(quad, num_points, maxentmc_quadrature_qmc_generate, &s);
+
+    free(table);
+
+    return status;
+}
+
+int maxentmc_quadrature_qmc_moments(maxentmc_quad_helper_t const quad, maxentmc_power_vector_t const multipliers,
+                                    maxentmc_power_vector_t const moments, maxentmc_power_vector_t const error,
+                                    size_t const num_points, size_t const num_randomizations,
+                                    maxentmc_float_t const width, uint64_t const seed)
+{
+    if(moments == NULL || num_randomizations == 0 || (error && num_randomizations < 2)){
+        fputs("maxentmc_quadrature_qmc: invalid moments or number of randomizations",stderr);
+        return -1;
+    }
+
+    if(error && error->gsl_vec.size != moments->gsl_vec.size){
+        fputs("maxentmc_quadrature_qmc: sizes of moments and error do not match",stderr);
+        return -1;
+    }
+
+    size_t const size = moments->gsl_vec.size;
+
+    maxentmc_power_vector_t const estimate = maxentmc_power_vector_alloc(moments);
+    maxentmc_float_t * const sum = calloc(2*size,sizeof(maxentmc_float_t));
+
+    if(estimate == NULL || sum == NULL){
+        fputs("maxentmc_quadrature_qmc: could not allocate memory",stderr);
+        maxentmc_power_vector_free(estimate);
+        free(sum);
+        return -1;
+    }
+
+    maxentmc_float_t * const sum_squares = sum+size;
+    size_t r, k;
+    int status = 0;
+
+    /** Welford's update of the mean and the sum of squared deviations of the estimates **/
+
+    for(r=0;r<num_randomizations && !status;++r){
+        if(maxentmc_quad_helper_set_multipliers(quad,multipliers) || maxentmc_quad_helper_set_moments(quad,estimate)){
+            status = -1;
+            break;
+        }
+        status = maxentmc_quadrature_qmc_ca(quad, num_points, width, seed, r);
+        if(maxentmc_quad_helper_get_moments(quad,estimate))
+            status = -1;
+        for(k=0;k<size;++k){
+            maxentmc_float_t const delta = estimate->gsl_vec.data[k]-sum[k];
+            sum[k] += delta/(r+1);
+            sum_squares[k] += delta*(estimate->gsl_vec.data[k]-sum[k]);
+        }
+    }
+
+    if(!status){
+        for(k=0;k<size;++k){
+            moments->gsl_vec.data[k] = sum[k];
+            if(error)
+                error->gsl_vec.data[k] = sqrt(sum_squares[k]/((num_randomizations-1)*num_randomizations));
+        }
+    }
+
+    maxentmc_power_vector_free(estimate);
+    free(sum);
+
+    return status;
+}
@@ -0,0 +1,39 @@
+/** This file is part of MaxEntMC, a maximum entropy algorithm with moment constraints. **/
+/** Copyright (C) 2014 Rafail V. Abramov.                                               **/
+/**                                                                                     **/
+/** This program is free software: you can redistribute it and/or modify it under the   **/
+/** terms of the GNU General Public License as published by the Free Software           **/
+/** Foundation, either version 3 of the License, or (at your option) any later version. **/
+/**                                                                                     **/
+/** This program is distributed in the hope that it will be useful, but WITHOUT ANY     **/
+/** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     **/
+/** PARTICULAR PURPOSE.  See the GNU General Public License for more details.           **/
+/**                                                                                     **/
+/** You should have received a copy of the GNU General Public License along with this   **/
+/** program.  If not, see <http://www.gnu.org/licenses/>.                               **/
+
+#ifndef MAXENTMC_QUAD_QMC_H_INCLUDED
+#define MAXENTMC_QUAD_QMC_H_INCLUDED
+
+#include <stdio.h>
+#include <stdint.h>
+#include "../user/maxentmc.h"
+#include "../user/maxentmc_quad_points.h"
+
+int maxentmc_quadrature_qmc_ca(maxentmc_quad_helper_t const quad, size_t const num_points, maxentmc_float_t const width,
+                               uint64_t const seed, size_t const randomization);
+/** Quasi-Monte Carlo quadrature with num_points points of a scrambled Halton sequence, mapped to the Gaussian with standard
+    deviation width along every coordinate of the helper (whitened if the shift and rotation are set from the constraints)
+    and weighted by the inverse of its density. The digits are scrambled by random permutations determined by the seed and
+    the randomization index, so every randomization is an independent unbiased estimate. **/
+
+int maxentmc_quadrature_qmc_moments(maxentmc_quad_helper_t const quad, maxentmc_power_vector_t const multipliers,
+                                    maxentmc_power_vector_t const moments, maxentmc_power_vector_t const error,
+                                    size_t const num_points, size_t const num_randomizations,
+                                    maxentmc_float_t const width, uint64_t const seed);
+/** Computes the moments num_randomizations times with maxentmc_quadrature_qmc_ca (one pass each, the helper must not be
+    armed) and stores their mean in moments and, if error is not NULL, the standard error of the mean in error (same
+    powers as moments, needs at least two randomizations). A caller can increase num_points until the error is below
+    its tolerance. **/
+
+#endif // MAXENTMC_QUAD_QMC_H_INCLUDED
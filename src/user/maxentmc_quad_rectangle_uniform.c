@@ -12,7 +12,9 @@
 /** You should have received a copy of the GNU General Public License along with this   **/
 /** program.  If not, see <http://www.gnu.org/licenses/>.                               **/
 
+#include <stdlib.h>
 #include "maxentmc_quad_rectangle_uniform.h"
+#include "maxentmc_quad_points.h"
 
 int maxentmc_quadrature_rectangle_uniform(maxentmc_quad_helper_t const quad, ...)
 {
@@ -39,6 +41,10 @@ int maxentmc_quadrature_rectangle_uniform(maxentmc_quad_helper_t const quad, ...
 
 }
 
+static int maxentmc_quadrature_rectangle_uniform_run(maxentmc_quad_helper_t const * const quads, size_t const num_quads,
+                                                     size_t const num_threads, size_t const * const num_points,
+                                                     maxentmc_float_t const * const start, maxentmc_float_t const * const end);
+
 int maxentmc_quadrature_rectangle_uniform_ca(maxentmc_quad_helper_t const quad, size_t const * const num_points,
                                                  maxentmc_float_t const * const start, maxentmc_float_t const * const end)
 {
@@ -48,78 +54,136 @@ int maxentmc_quadrature_rectangle_uniform_ca(maxentmc_quad_helper_t const quad,
         return -1;
     }
 
+    /** With a thread pool attached to the helper, its workers compute the quadrature, otherwise the calling thread alone **/
+
+    return maxentmc_quadrature_rectangle_uniform_run(&quad, 1, 0, num_points, start, end);
+
+}
+
+int maxentmc_quadrature_rectangle_uniform_parallel(maxentmc_quad_helper_t const quad, size_t const num_threads, ...)
+{
+    if(quad == NULL){
+        fputs("maxentmc_quad_hausdorff_uniform: NULL pointer is given as quadrature helper structure",stderr);
+        return -1;
+    }
+
     maxentmc_index_t const dim = maxentmc_quad_helper_get_dimension(quad);
 
-    size_t quad_point[dim];
+    size_t num_points[dim];
+    maxentmc_float_t start[dim], end[dim];
+
+    va_list ap;
+    va_start(ap,num_threads);
+    maxentmc_index_t i;
+    for(i=0;i<dim;++i){
+        num_points[i] = va_arg(ap,size_t);
+        start[i] = va_arg(ap,maxentmc_float_t);
+        end[i] = va_arg(ap,maxentmc_float_t);
+    }
+    va_end(ap);
+    return maxentmc_quadrature_rectangle_uniform_parallel_ca(quad, num_threads, num_points, start, end);
+
+}
+
+/** The grid is generated point by point for maxentmc_quadrature_points_ca, with the first coordinate running fastest **/
 
-    maxentmc_float_t abscissa[4][dim], dx[dim], weight = 1.0;
+struct maxentmc_quadrature_rectangle_uniform_grid_struct {
+    maxentmc_index_t dim;
+    size_t const * num_points;
+    maxentmc_float_t const * start, * dx;
+    maxentmc_float_t weight;
+};
 
+static int maxentmc_quadrature_rectangle_uniform_generator(void * const arg, size_t const begin, size_t const n,
+                                                           maxentmc_float_t * const * const x, maxentmc_float_t * const w)
+{
+    struct maxentmc_quadrature_rectangle_uniform_grid_struct const * const grid = arg;
+    maxentmc_index_t const dim = grid->dim;
+    size_t index[dim], r = begin, k = 0, j;
     maxentmc_index_t i;
 
     for(i=0;i<dim;++i){
-        quad_point[i] = 0;
-        dx[i] = (end[i] - start[i])/num_points[i];
-        weight *= dx[i];
+        index[i] = r%grid->num_points[i];
+        r /= grid->num_points[i];
     }
 
-    struct maxentmc_quad_helper_thread_struct * quad_thread = maxentmc_quad_helper_thread_alloc(quad);
-
-    while(quad_point[dim-1]<num_points[dim-1]){
+    /** The points come in runs along the first coordinate, where the other coordinates are constant **/
 
+    while(k<n){
+        size_t const run = (n-k<grid->num_points[0]-index[0])?n-k:grid->num_points[0]-index[0];
+        for(j=0;j<run;++j){
+            x[0][k+j] = grid->start[0]+(0.5+index[0]+j)*grid->dx[0];
+            w[k+j] = grid->weight;
+        }
         for(i=1;i<dim;++i){
-            abscissa[0][i] = start[i]+(0.5+quad_point[i])*dx[i];
-            abscissa[1][i] = abscissa[0][i];
-            abscissa[2][i] = abscissa[0][i];
-            abscissa[3][i] = abscissa[0][i];
+            maxentmc_float_t const a = grid->start[i]+(0.5+index[i])*grid->dx[i];
+            for(j=0;j<run;++j)
+                x[i][k+j] = a;
         }
+        k += run;
+        index[0] = 0;
+        for(i=1;i<dim && ++index[i] == grid->num_points[i];++i)
+            index[i] = 0;
+    }
 
-        while((quad_point[0]+3) < num_points[0]){
+    return 0;
+}
 
-            abscissa[0][0] = start[0]+(0.5+quad_point[0])*dx[0];
-            abscissa[1][0] = start[0]+(1.5+quad_point[0])*dx[0];
-            abscissa[2][0] = start[0]+(2.5+quad_point[0])*dx[0];
-            abscissa[3][0] = start[0]+(3.5+quad_point[0])*dx[0];
-            maxentmc_quad_helper_thread_compute_4(quad_thread,abscissa[0],weight,abscissa[1],weight,abscissa[2],weight,abscissa[3],weight);
-            (quad_point[0]) += 4;
+int maxentmc_quadrature_rectangle_uniform_parallel_ca(maxentmc_quad_helper_t const quad, size_t const num_threads, size_t const * const num_points,
+                                                      maxentmc_float_t const * const start, maxentmc_float_t const * const end)
+{
 
-        }
+    if(quad == NULL){
+        fputs("maxentmc_quad_hausdorff_uniform: NULL pointer is given as quadrature helper structure",stderr);
+        return -1;
+    }
 
-        i = num_points[0] - quad_point[0];
-
-        switch(i){
-            case 3:
-                abscissa[0][0] = start[0]+(0.5+quad_point[0])*dx[0];
-                abscissa[1][0] = start[0]+(1.5+quad_point[0])*dx[0];
-                abscissa[2][0] = start[0]+(2.5+quad_point[0])*dx[0];
-                maxentmc_quad_helper_thread_compute_3(quad_thread,abscissa[0],weight,abscissa[1],weight,abscissa[2],weight);
-                (quad_point[0]) += 3;
-                break;
-            case 2:
-                abscissa[0][0] = start[0]+(0.5+quad_point[0])*dx[0];
-                abscissa[1][0] = start[0]+(1.5+quad_point[0])*dx[0];
-                maxentmc_quad_helper_thread_compute_2(quad_thread,abscissa[0],weight,abscissa[1],weight);
-                (quad_point[0]) += 2;
-                break;
-            case 1:
-                abscissa[0][0] = start[0]+(0.5+quad_point[0])*dx[0];
-                maxentmc_quad_helper_thread_compute_1(quad_thread,abscissa[0],weight);
-                (quad_point[0]) += 1;
-                break;
-        }
+    return maxentmc_quadrature_rectangle_uniform_run(&quad, 1, (num_threads>0)?num_threads:1, num_points, start, end);
 
-        i=1;
+}
 
-        while((i<dim) && (quad_point[i-1]==num_points[i-1])){
+int maxentmc_quadrature_rectangle_uniform_multi_ca(maxentmc_quad_helper_t const * const quads, size_t const num_quads, size_t const * const num_points,
+                                                   maxentmc_float_t const * const start, maxentmc_float_t const * const end)
+{
 
-            quad_point[i-1] = 0;
-            ++(quad_point[i++]);
+    if(num_quads == 0)
+        return 0;
 
-        }
+    if(quads == NULL || quads[0] == NULL){
+        fputs("maxentmc_quad_hausdorff_uniform: NULL pointer is given as quadrature helper structure",stderr);
+        return -1;
+    }
 
+    return maxentmc_quadrature_rectangle_uniform_run(quads, num_quads, 0, num_points, start, end);
+
+}
+
+/** Computes the quadratures of the helpers on the grid, with the pool of the first helper or num_threads threads **/
+
+static int maxentmc_quadrature_rectangle_uniform_run(maxentmc_quad_helper_t const * const quads, size_t const num_quads,
+                                                     size_t const num_threads, size_t const * const num_points,
+                                                     maxentmc_float_t const * const start, maxentmc_float_t const * const end)
+{
+
+    maxentmc_index_t const dim = maxentmc_quad_helper_get_dimension(quads[0]);
+
+    maxentmc_float_t dx[dim];
+
+    struct maxentmc_quadrature_rectangle_uniform_grid_struct grid = {dim, num_points, start, dx, 1.0};
+
+    size_t total = 1;
+
+    maxentmc_index_t i;
+
+    for(i=0;i<dim;++i){
+        dx[i] = (end[i] - start[i])/num_points[i];
+        grid.weight *= dx[i];
+        total *= num_points[i];
     }
 
-    maxentmc_quad_helper_thread_merge(quad_thread);
+    if(num_threads)
+        return maxentmc_quadrature_points_parallel_ca(quads[0], num_threads, total, maxentmc_quadrature_rectangle_uniform_generator, &grid);
 
-    return 0;
+    return maxentmc_quadrature_points_multi_ca(quads, num_quads, total, maxentmc_quadrature_rectangle_uniform_generator, &grid);
 
 }
@@ -24,4 +24,17 @@ int maxentmc_quadrature_rectangle_uniform(maxentmc_quad_helper_t const quad, ...
 int maxentmc_quadrature_rectangle_uniform_ca(maxentmc_quad_helper_t const quad, size_t const * const num_points,
                                                  maxentmc_float_t const * const start, maxentmc_float_t const * const end);
 
+int maxentmc_quadrature_rectangle_uniform_parallel(maxentmc_quad_helper_t const quad, size_t const num_threads, ...);
+
+int maxentmc_quadrature_rectangle_uniform_parallel_ca(maxentmc_quad_helper_t const quad, size_t const num_threads, size_t const * const num_points,
+                                                      maxentmc_float_t const * const start, maxentmc_float_t const * const end);
+/** The same quadrature computed by num_threads threads (including the calling one), each with its own thread accumulator,
+    over contiguous ranges of the grid points **/
+
+int maxentmc_quadrature_rectangle_uniform_multi_ca(maxentmc_quad_helper_t const * const quads, size_t const num_quads, size_t const * const num_points,
+                                                   maxentmc_float_t const * const start, maxentmc_float_t const * const end);
+/** The quadratures of num_quads helpers of the same dimension, each armed with its own multipliers and moments, on the
+    same grid in one pass: the workers of the thread pool of the first helper take the blocks of all of them, each helper
+    with its own thread accumulators. Without a pool, the quadratures are computed one after the other on the calling thread **/
+
 #endif // TEST_QUAD_HAUSDORFF_UNIFORM_H_INCLUDED
@@ -0,0 +1,407 @@
+/** This file is part of MaxEntMC, a maximum entropy algorithm with moment constraints. **/
+/** Copyright (C) 2014 Rafail V. Abramov.                                               **/
+/**                                                                                     **/
+/** This program is free software: you can redistribute it and/or modify it under the   **/
+/** terms of the GNU General Public License as published by the Free Software           **/
+/** Foundation, either version 3 of the License, or (at your option) any later version. **/
+/**                                                                                     **/
+/** This program is distributed in the hope that it will be useful, but WITHOUT ANY     **/
+/** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     **/
+/** PARTICULAR PURPOSE.  See the GNU General Public License for more details.           **/
+/**                                                                                     **/
+/** You should have received a copy of the GNU General Public License along with this   **/
+/** program.  If not, see <http://www.gnu.org/licenses/>.                               **/
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include <pthread.h>
+#include "maxentmc_quad_smolyak.h"
+
+/** The grid is the combination of tensor rules Q(j_1) x ... x Q(j_dim), j_i >= 1, with Q(j) the Clenshaw-Curtis rule with
+    m(1) = 1 and m(j) = 2^(j-1)+1 points, over q-dim+1 <= |j| <= q, q = dim+level, with the coefficients
+    (-1)^(q-|j|) binomial(dim-1,q-|j|). Since the rules are nested, every point lies on the finest rule along each
+    coordinate, so a point is numbered by its indices in the finest rules and the weights of coinciding points are summed. **/
+
+struct maxentmc_quadrature_smolyak_grid_struct {
+    struct maxentmc_quadrature_smolyak_grid_struct * next;
+    maxentmc_index_t dim;
+    size_t level, num_points, fine_size;
+    uint32_t * index; /** [dim][num_points], indices of the coordinates in the finest rule **/
+    maxentmc_float_t * weights;
+    maxentmc_float_t const * fine; /** Nodes of the finest rule on [-1,1] **/
+    maxentmc_float_t * gauss_nodes, * gauss_factors; /** The finest rule mapped to the standard Gaussian, see below **/
+};
+
+struct maxentmc_quadrature_smolyak_entry_struct {
+    uint64_t key;
+    maxentmc_float_t weight;
+};
+
+static struct maxentmc_quadrature_smolyak_grid_struct * maxentmc_quadrature_smolyak_cache = NULL;
+
+static pthread_mutex_t maxentmc_quadrature_smolyak_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static size_t maxentmc_quadrature_smolyak_rule_size(size_t const j)
+{
+    return (j == 1)?1:(((size_t)1<<(j-1))+1);
+}
+
+static int maxentmc_quadrature_smolyak_compare(void const * const a, void const * const b)
+{
+    uint64_t const ka = ((struct maxentmc_quadrature_smolyak_entry_struct const *)a)->key;
+    uint64_t const kb = ((struct maxentmc_quadrature_smolyak_entry_struct const *)b)->key;
+    return (ka > kb) - (ka < kb);
+}
+
+/** Calls f for every multi-index j with j_i >= 1 and lo <= |j| <= hi, returns the sum of the results **/
+
+static size_t maxentmc_quadrature_smolyak_for_each(maxentmc_index_t const dim, size_t const lo, size_t const hi,
+                                                   size_t (*f)(void * arg, size_t const * j, size_t sum), void * const arg)
+{
+    size_t j[dim], sum = dim, total = 0;
+    maxentmc_index_t i;
+
+    for(i=0;i<dim;++i)
+        j[i] = 1;
+
+    for(;;){
+        if(sum >= lo)
+            total += f(arg,j,sum);
+        /** Next multi-index with |j| <= hi, in odometer order **/
+        for(i=0;i<dim;++i){
+            if(sum < hi){
+                ++j[i];
+                ++sum;
+                break;
+            }
+            sum -= j[i]-1;
+            j[i] = 1;
+        }
+        if(i == dim)
+            return total;
+    }
+}
+
+struct maxentmc_quadrature_smolyak_build_struct {
+    maxentmc_index_t dim;
+    size_t q, fine_size;
+    struct maxentmc_quadrature_smolyak_entry_struct * entry;
+    size_t num_entries;
+    int status;
+};
+
+static size_t maxentmc_quadrature_smolyak_count(void * const arg, size_t const * const j, size_t const sum)
+{
+    struct maxentmc_quadrature_smolyak_build_struct const * const b = arg;
+    size_t n = 1;
+    maxentmc_index_t i;
+    (void)sum;
+    for(i=0;i<b->dim;++i)
+        n *= maxentmc_quadrature_smolyak_rule_size(j[i]);
+    return n;
+}
+
+static size_t maxentmc_quadrature_smolyak_add(void * const arg, size_t const * const j, size_t const sum)
+{
+    struct maxentmc_quadrature_smolyak_build_struct * const b = arg;
+    maxentmc_index_t const dim = b->dim;
+    maxentmc_float_t const * w[dim];
+    size_t m[dim], k[dim];
+    maxentmc_index_t i;
+
+    /** Coefficient (-1)^(q-|j|) binomial(dim-1,q-|j|) **/
+    size_t const r = b->q-sum;
+    maxentmc_float_t coefficient = (r%2)?-1.0:1.0;
+    for(i=0;i<r;++i)
+        coefficient = coefficient*(dim-1-i)/(i+1);
+
+    for(i=0;i<dim;++i){
+        maxentmc_float_t const * nodes;
+        m[i] = maxentmc_quadrature_smolyak_rule_size(j[i]);
+        if(maxentmc_quadrature_rule(MAXENTMC_QUADRATURE_RULE_CLENSHAW_CURTIS,m[i],&nodes,w+i)){
+            b->status = -1;
+            return 0;
+        }
+        k[i] = 0;
+    }
+
+    size_t n = 0;
+
+    do{
+        uint64_t key = 0;
+        maxentmc_float_t weight = coefficient;
+        for(i=dim;i-->0;){
+            size_t const fine = (m[i] == 1)?(b->fine_size-1)/2:k[i]*((b->fine_size-1)/(m[i]-1));
+            key = key*b->fine_size+fine;
+            weight *= w[i][k[i]];
+        }
+        b->entry[b->num_entries].key = key;
+        b->entry[b->num_entries].weight = weight;
+        ++b->num_entries;
+        ++n;
+        for(i=0;i<dim;++i){
+            if(++k[i] < m[i])
+                break;
+            k[i] = 0;
+        }
+    }while(i<dim);
+
+    return n;
+}
+
+/** The mapping y = Phi^(-1)((1+t)/2) of [-1,1] to the real line, with Phi the standard Gaussian distribution, turns the integral
+    over y into the integral over t of the integrand times dy/dt = 1/(2 phi(y)), phi the Gaussian density. For a density close
+    to Gaussian the mapped integrand is close to constant, which the low levels already integrate well. The ends t = -1 and
+    t = 1 go to infinity, where the densities vanish, so their factors are zero. y is found by Newton iterations on
+    log(erfc(y/sqrt(2))) = log(1-t), which converge monotonically since the left side is concave. **/
+
+#define MAXENTMC_QUADRATURE_SMOLYAK_GAUSS_MAX_ITER 100
+
+static void maxentmc_quadrature_smolyak_gauss_map(struct maxentmc_quadrature_smolyak_grid_struct * const g)
+{
+    maxentmc_float_t const pi = 4.0*atan(1.0);
+    size_t k, iter;
+
+    for(k=0;k<g->fine_size;++k){
+
+        maxentmc_float_t const t = g->fine[k];
+
+        if(fabs(t) >= 1.0){
+            g->gauss_nodes[k] = 0.0;
+            g->gauss_factors[k] = 0.0;
+            continue;
+        }
+
+        maxentmc_float_t const log_r = log(1.0-fabs(t));
+        maxentmc_float_t y = 0.0;
+
+        for(iter=0;iter<MAXENTMC_QUADRATURE_SMOLYAK_GAUSS_MAX_ITER;++iter){
+            maxentmc_float_t const r = erfc(y/sqrt(2.0));
+            maxentmc_float_t const dy = (log(r)-log_r)*r/(sqrt(2.0/pi)*exp(-0.5*y*y));
+            y += dy;
+            if(fabs(dy) <= 1e-15*(1.0+y))
+                break;
+        }
+
+        if(t < 0.0)
+            y = -y;
+
+        g->gauss_nodes[k] = y;
+        g->gauss_factors[k] = 0.5*sqrt(2.0*pi)*exp(0.5*y*y);
+    }
+}
+
+static struct maxentmc_quadrature_smolyak_grid_struct * maxentmc_quadrature_smolyak_build(maxentmc_index_t const dim, size_t const level)
+{
+    struct maxentmc_quadrature_smolyak_build_struct b;
+
+    b.dim = dim;
+    b.q = dim+level;
+    b.fine_size = maxentmc_quadrature_smolyak_rule_size(level+1);
+    b.num_entries = 0;
+    b.status = 0;
+
+    /** The keys number the points of the finest tensor grid, which must fit in 64 bits **/
+    uint64_t limit = UINT64_MAX;
+    maxentmc_index_t i;
+    for(i=0;i<dim;++i){
+        if(limit < b.fine_size){
+            fputs("maxentmc_quadrature_smolyak: level too high for the dimension",stderr);
+            return NULL;
+        }
+        limit /= b.fine_size;
+    }
+
+    size_t const lo = (level+1>(size_t)dim)?level+1:dim; /** q-dim+1, but every |j| is at least dim **/
+    size_t const num_entries = maxentmc_quadrature_smolyak_for_each(dim,lo,b.q,maxentmc_quadrature_smolyak_count,&b);
+
+    b.entry = malloc(sizeof(struct maxentmc_quadrature_smolyak_entry_struct)*num_entries);
+    if(b.entry == NULL){
+        fputs("maxentmc_quadrature_smolyak: could not allocate the grid",stderr);
+        return NULL;
+    }
+
+    maxentmc_quadrature_smolyak_for_each(dim,lo,b.q,maxentmc_quadrature_smolyak_add,&b);
+    if(b.status){
+        free(b.entry);
+        return NULL;
+    }
+
+    /** Merge coinciding points, dropping the ones whose weights cancel exactly **/
+
+    qsort(b.entry,b.num_entries,sizeof(struct maxentmc_quadrature_smolyak_entry_struct),maxentmc_quadrature_smolyak_compare);
+
+    size_t e, n = 0;
+    for(e=0;e<b.num_entries;++e){
+        if(n > 0 && b.entry[n-1].key == b.entry[e].key)
+            b.entry[n-1].weight += b.entry[e].weight;
+        else
+            b.entry[n++] = b.entry[e];
+    }
+
+    size_t const num_merged = n;
+    for(e=0, n=0;e<num_merged;++e)
+        if(b.entry[e].weight != 0.0)
+            b.entry[n++] = b.entry[e];
+
+    maxentmc_float_t const * fine;
+    maxentmc_float_t const * fine_weights;
+
+    struct maxentmc_quadrature_smolyak_grid_struct * const g = malloc(sizeof(struct maxentmc_quadrature_smolyak_grid_struct)+
+                                                                       sizeof(maxentmc_float_t)*(n+2*b.fine_size)+sizeof(uint32_t)*n*dim);
+    if(g == NULL || maxentmc_quadrature_rule(MAXENTMC_QUADRATURE_RULE_CLENSHAW_CURTIS,b.fine_size,&fine,&fine_weights)){
+        fputs("maxentmc_quadrature_smolyak: could not allocate the grid",stderr);
+        free(g);
+        free(b.entry);
+        return NULL;
+    }
+
+    g->dim = dim;
+    g->level = level;
+    g->num_points = n;
+    g->fine_size = b.fine_size;
+    g->fine = fine;
+    g->weights = (maxentmc_float_t *)(g+1);
+    g->gauss_nodes = g->weights+n;
+    g->gauss_factors = g->gauss_nodes+b.fine_size;
+    g->index = (uint32_t *)(g->gauss_factors+b.fine_size);
+
+    for(e=0;e<n;++e){
+        uint64_t key = b.entry[e].key;
+        for(i=0;i<dim;++i){
+            g->index[i*n+e] = key%b.fine_size;
+            key /= b.fine_size;
+        }
+        g->weights[e] = b.entry[e].weight;
+    }
+
+    free(b.entry);
+
+    maxentmc_quadrature_smolyak_gauss_map(g);
+
+    return g;
+}
+
+static struct maxentmc_quadrature_smolyak_grid_struct const * maxentmc_quadrature_smolyak_grid(maxentmc_index_t const dim, size_t const level)
+{
+    pthread_mutex_lock(&maxentmc_quadrature_smolyak_lock);
+
+    struct maxentmc_quadrature_smolyak_grid_struct * g = maxentmc_quadrature_smolyak_cache;
+
+    while(g && !(g->dim == dim && g->level == level))
+        g = g->next;
+
+    if(g == NULL){
+        g = maxentmc_quadrature_smolyak_build(dim,level);
+        if(g){
+            g->next = maxentmc_quadrature_smolyak_cache;
+            maxentmc_quadrature_smolyak_cache = g;
+        }
+    }
+
+    pthread_mutex_unlock(&maxentmc_quadrature_smolyak_lock);
+
+    return g;
+}
+
+size_t maxentmc_quadrature_smolyak_num_points(maxentmc_index_t const dim, size_t const level)
+{
+    struct maxentmc_quadrature_smolyak_grid_struct const * const g = maxentmc_quadrature_smolyak_grid(dim,level);
+    return (g)?g->num_points:0;
+}
+
+/** Maps the points of the cached grid to the box, or, if width is positive, to the real line through the Gaussian of
+    standard deviation width **/
+
+struct maxentmc_quadrature_smolyak_map_struct {
+    struct maxentmc_quadrature_smolyak_grid_struct const * grid;
+    maxentmc_float_t const * center, * half;
+    maxentmc_float_t volume, width;
+};
+
+static int maxentmc_quadrature_smolyak_generate(void * const arg, size_t const begin, size_t const n,
+                                                maxentmc_float_t * const * const x, maxentmc_float_t * const w)
+{
+    struct maxentmc_quadrature_smolyak_map_struct const * const map = arg;
+    struct maxentmc_quadrature_smolyak_grid_struct const * const g = map->grid;
+    maxentmc_index_t i;
+    size_t k;
+
+    for(k=0;k<n;++k)
+        w[k] = map->volume*g->weights[begin+k];
+
+    for(i=0;i<g->dim;++i){
+        uint32_t const * const index = g->index+i*g->num_points+begin;
+        if(map->width > 0)
+            for(k=0;k<n;++k){
+                x[i][k] = map->width*g->gauss_nodes[index[k]];
+                w[k] *= g->gauss_factors[index[k]];
+            }
+        else
+            for(k=0;k<n;++k)
+                x[i][k] = map->center[i]+map->half[i]*g->fine[index[k]];
+    }
+
+    return 0;
+}
+
+int maxentmc_quadrature_smolyak_ca(maxentmc_quad_helper_t const quad, size_t const level,
+                                   maxentmc_float_t const * const start, maxentmc_float_t const * const end)
+{
+    if(quad == NULL){
+        fputs("maxentmc_quadrature_smolyak: NULL pointer is given as quadrature helper structure",stderr);
+        return -1;
+    }
+
+    maxentmc_index_t const dim = maxentmc_quad_helper_get_dimension(quad);
+
+    struct maxentmc_quadrature_smolyak_map_struct map;
+
+    map.grid = maxentmc_quadrature_smolyak_grid(dim,level);
+    if(map.grid == NULL)
+        return -1;
+
+    maxentmc_float_t center[dim], half[dim];
+    maxentmc_index_t i;
+
+    map.volume = 1.0;
+    for(i=0;i<dim;++i){
+        center[i] = 0.5*(start[i]+end[i]);
+        half[i] = 0.5*(end[i]-start[i]);
+        map.volume *= half[i];
+    }
+    map.center = center;
+    map.half = half;
+    map.width = 0.0;
+
+    return maxentmc_quadrature_points_ca(quad, map.grid->num_points, maxentmc_quadrature_smolyak_generate, &map);
+}
+
+int maxentmc_quadrature_smolyak_gaussian_ca(maxentmc_quad_helper_t const quad, size_t const level, maxentmc_float_t const width)
+{
+    if(quad == NULL){
+        fputs("maxentmc_quadrature_smolyak: NULL pointer is given as quadrature helper structure",stderr);
+        return -1;
+    }
+
+    if(!(width > 0)){
+        fputs("maxentmc_quadrature_smolyak: width of the Gaussian is not positive",stderr);
+        return -1;
+    }
+
+    maxentmc_index_t const dim = maxentmc_quad_helper_get_dimension(quad);
+
+    struct maxentmc_quadrature_smolyak_map_struct map;
+
+    map.grid = maxentmc_quadrature_smolyak_grid(dim,level);
+    if(map.grid == NULL)
+        return -1;
+
+    map.center = NULL;
+    map.half = NULL;
+    map.volume = pow(width,dim);
+    map.width = width;
+
+    return maxentmc_quadrature_points_ca(quad, map.grid->num_points, maxentmc_quadrature_smolyak_generate, &map);
+}
@@ -0,0 +1,41 @@
+/** This file is part of MaxEntMC, a maximum entropy algorithm with moment constraints. **/
+/** Copyright (C) 2014 Rafail V. Abramov.                                               **/
+/**                                                                                     **/
+/** This program is free software: you can redistribute it and/or modify it under the   **/
+/** terms of the GNU General Public License as published by the Free Software           **/
+/** Foundation, either version 3 of the License, or (at your option) any later version. **/
+/**                                                                                     **/
+/** This program is distributed in the hope that it will be useful, but WITHOUT ANY     **/
+/** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     **/
+/** PARTICULAR PURPOSE.  See the GNU General Public License for more details.           **/
+/**                                                                                     **/
+/** You should have received a copy of the GNU General Public License along with this   **/
+/** program.  If not, see <http://www.gnu.org/licenses/>.                               **/
+
+#ifndef MAXENTMC_QUAD_SMOLYAK_H_INCLUDED
+#define MAXENTMC_QUAD_SMOLYAK_H_INCLUDED
+
+#include <stdio.h>
+#include "../user/maxentmc.h"
+#include "../user/maxentmc_quad_box.h"
+#include "../user/maxentmc_quad_points.h"
+
+int maxentmc_quadrature_smolyak_ca(maxentmc_quad_helper_t const quad, size_t const level,
+                                   maxentmc_float_t const * const start, maxentmc_float_t const * const end);
+/** Smolyak sparse grid of the given level on the box from start to end, built from the nested Clenshaw-Curtis rules with
+    1, 3, 5, 9, ..., 2^level+1 points per coordinate. The grid is exact for polynomials of total degree 2 level+1, and
+    has O(N log(N)^(dim-1)) points for N = 2^level points per coordinate instead of the N^dim of the tensor grid. Some
+    weights are negative. The grids on [-1,1]^dim are cached by dimension and level. **/
+
+int maxentmc_quadrature_smolyak_gaussian_ca(maxentmc_quad_helper_t const quad, size_t const level, maxentmc_float_t const width);
+/** The same grid mapped from [-1,1] to the real line along every coordinate through the inverse distribution function of the
+    Gaussian with standard deviation width, in the coordinates of the helper. With the shift and rotation set from the
+    constraints, a density close to Gaussian becomes close to constant, so this converges much faster than the box grid,
+    whose low levels are far off on a box much wider than the density. Take width somewhat larger than the spread of
+    the density: with equal widths the mapped moments grow like powers of log near the ends of [-1,1], which slows the
+    convergence to algebraic. **/
+
+size_t maxentmc_quadrature_smolyak_num_points(maxentmc_index_t dim, size_t level);
+/** Number of points of the grid (0 on error) **/
+
+#endif // MAXENTMC_QUAD_SMOLYAK_H_INCLUDED
@@ -0,0 +1,108 @@
+/** This file is part of MaxEntMC, a maximum entropy algorithm with moment constraints. **/
+/** Copyright (C) 2014 Rafail V. Abramov.                                               **/
+/**                                                                                     **/
+/** This program is free software: you can redistribute it and/or modify it under the   **/
+/** terms of the GNU General Public License as published by the Free Software           **/
+/** Foundation, either version 3 of the License, or (at your option) any later version. **/
+/**                                                                                     **/
+/** This program is distributed in the hope that it will be useful, but WITHOUT ANY     **/
+/** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     **/
+/** PARTICULAR PURPOSE.  See the GNU General Public License for more details.           **/
+/**                                                                                     **/
+/** You should have received a copy of the GNU General Public License along with this   **/
+/** program.  If not, see <http://www.gnu.org/licenses/>.                               **/
+
+#include <stdlib.h>
+#include "maxentmc_quad_tensor.h"
+#include "maxentmc_quad_points.h"
+
+/** The tensor grid is generated point by point for maxentmc_quadrature_points_ca, with the first coordinate running
+    fastest, as the uniform rectangle grid **/
+
+struct maxentmc_quadrature_tensor_grid_struct {
+    maxentmc_index_t dim;
+    size_t const * num_points;
+    maxentmc_float_t const * const * nodes;
+    maxentmc_float_t const * const * weights;
+};
+
+static int maxentmc_quadrature_tensor_generator(void * const arg, size_t const begin, size_t const n,
+                                                maxentmc_float_t * const * const x, maxentmc_float_t * const w)
+{
+    struct maxentmc_quadrature_tensor_grid_struct const * const grid = arg;
+    maxentmc_index_t const dim = grid->dim;
+    size_t index[dim], r = begin, k = 0, j;
+    maxentmc_index_t i;
+
+    for(i=0;i<dim;++i){
+        index[i] = r%grid->num_points[i];
+        r /= grid->num_points[i];
+    }
+
+    /** The points come in runs along the first coordinate, where the other coordinates and their weights are constant **/
+
+    while(k<n){
+        size_t const run = (n-k<grid->num_points[0]-index[0])?n-k:grid->num_points[0]-index[0];
+        maxentmc_float_t weight = 1.0;
+        for(i=1;i<dim;++i){
+            maxentmc_float_t const a = grid->nodes[i][index[i]];
+            weight *= grid->weights[i][index[i]];
+            for(j=0;j<run;++j)
+                x[i][k+j] = a;
+        }
+        for(j=0;j<run;++j){
+            x[0][k+j] = grid->nodes[0][index[0]+j];
+            w[k+j] = grid->weights[0][index[0]+j]*weight;
+        }
+        k += run;
+        index[0] = 0;
+        for(i=1;i<dim && ++index[i] == grid->num_points[i];++i)
+            index[i] = 0;
+    }
+
+    return 0;
+}
+
+static int maxentmc_quadrature_tensor_run(maxentmc_quad_helper_t const quad, size_t const num_threads, size_t const * const num_points,
+                                          maxentmc_float_t const * const * const nodes, maxentmc_float_t const * const * const weights)
+{
+
+    if(quad == NULL){
+        fputs("maxentmc_quadrature_tensor: NULL pointer is given as quadrature helper structure",stderr);
+        return -1;
+    }
+
+    maxentmc_index_t const dim = maxentmc_quad_helper_get_dimension(quad);
+
+    struct maxentmc_quadrature_tensor_grid_struct grid = {dim, num_points, nodes, weights};
+
+    size_t total = 1;
+
+    maxentmc_index_t i;
+
+    for(i=0;i<dim;++i){
+        if(num_points[i] == 0){
+            fputs("maxentmc_quadrature_tensor: zero number of points",stderr);
+            return -1;
+        }
+        total *= num_points[i];
+    }
+
+    if(num_threads)
+        return maxentmc_quadrature_points_parallel_ca(quad, num_threads, total, maxentmc_quadrature_tensor_generator, &grid);
+
+    return maxentmc_quadrature_points_ca(quad, total, maxentmc_quadrature_tensor_generator, &grid);
+
+}
+
+int maxentmc_quadrature_tensor_ca(maxentmc_quad_helper_t const quad, size_t const * const num_points,
+                                  maxentmc_float_t const * const * const nodes, maxentmc_float_t const * const * const weights)
+{
+    return maxentmc_quadrature_tensor_run(quad, 0, num_points, nodes, weights);
+}
+
+int maxentmc_quadrature_tensor_parallel_ca(maxentmc_quad_helper_t const quad, size_t const num_threads, size_t const * const num_points,
+                                           maxentmc_float_t const * const * const nodes, maxentmc_float_t const * const * const weights)
+{
+    return maxentmc_quadrature_tensor_run(quad, (num_threads>0)?num_threads:1, num_points, nodes, weights);
+}
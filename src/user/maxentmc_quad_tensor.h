@@ -0,0 +1,32 @@
+/** This file is part of MaxEntMC, a maximum entropy algorithm with moment constraints. **/
+/** Copyright (C) 2014 Rafail V. Abramov.                                               **/
+/**                                                                                     **/
+/** This program is free software: you can redistribute it and/or modify it under the   **/
+/** terms of the GNU General Public License as published by the Free Software           **/
+/** Foundation, either version 3 of the License, or (at your option) any later version. **/
+/**                                                                                     **/
+/** This program is distributed in the hope that it will be useful, but WITHOUT ANY     **/
+/** WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A     **/
+/** PARTICULAR PURPOSE.  See the GNU General Public License for more details.           **/
+/**                                                                                     **/
+/** You should have received a copy of the GNU General Public License along with this   **/
+/** program.  If not, see <http://www.gnu.org/licenses/>.                               **/
+
+#ifndef MAXENTMC_QUAD_TENSOR_H_INCLUDED
+#define MAXENTMC_QUAD_TENSOR_H_INCLUDED
+
+#include <stdio.h>
+#include "../user/maxentmc.h"
+
+int maxentmc_quadrature_tensor_ca(maxentmc_quad_helper_t const quad, size_t const * const num_points,
+                                  maxentmc_float_t const * const * const nodes, maxentmc_float_t const * const * const weights);
+/** Tensor product of one-dimensional rules: along the i-th coordinate, num_points[i] nodes nodes[i] with weights weights[i].
+    The nodes are in the coordinates of the quadrature helper (whitened if the shift and rotation are set). With a thread
+    pool attached to the helper, its workers compute the quadrature, otherwise the calling thread alone **/
+
+int maxentmc_quadrature_tensor_parallel_ca(maxentmc_quad_helper_t const quad, size_t const num_threads, size_t const * const num_points,
+                                           maxentmc_float_t const * const * const nodes, maxentmc_float_t const * const * const weights);
+/** The same quadrature computed by num_threads threads (including the calling one), each with its own thread accumulator,
+    over contiguous ranges of points **/
+
+#endif // MAXENTMC_QUAD_TENSOR_H_INCLUDED